@@ -0,0 +1,158 @@
+// ============================================================================
+// codec_bench.cpp — per-frame cost of building, framing and decoding (make bench)
+//
+// slip_bench measures raw framing throughput on 4 KiB payloads; real ViaText
+// traffic is 10–60 byte frames, where per-call overhead dominates. This bench
+// runs the host's hot path on frames of that size and reports ns/frame and
+// MB/s (payload bytes) for:
+//   build   : make_get_id(), make_get_params() (4 tags), make_set_params(),
+//             and the FrameBuf/frame_seal() path for the same GET_PARAM
+//   slip    : slip::encode() of a reply, decoder::feed(buf) over a stream of them
+//   decode  : TlvCursor walk, decode_reply(), decode_pretty(), decode_snapshot()
+//
+// Replies are built with the FrameBuf API from the same TAG_* definitions the
+// decoders use, so every decode path is checked to find what was put in.
+// ============================================================================
+
+#include "commands.hpp"
+#include "slip.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace viatext;
+using Clock = std::chrono::steady_clock;
+
+static constexpr int ITERS = 200000;     // frames per measurement
+
+static volatile size_t sink = 0;         // keeps results observable
+
+template <class Fn>
+static void measure(const char* what, size_t bytes_per_frame, Fn fn) {
+    for (int i = 0; i < ITERS / 10; ++i) fn();            // warm caches and allocator
+    const auto t0 = Clock::now();
+    for (int i = 0; i < ITERS; ++i) fn();
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::printf("  %-26s %8.1f ns/frame %9.1f MB/s\n", what,
+                secs * 1e9 / ITERS, double(bytes_per_frame) * ITERS / secs / 1e6);
+}
+
+static std::vector<uint8_t> to_vector(const FrameBuf& f) {
+    return std::vector<uint8_t>(f.bytes.begin(), f.bytes.begin() + f.len);
+}
+
+// A telemetry reply as a node sends it: RESP_OK with rssi, snr, vbat, freq.
+static std::vector<uint8_t> telemetry_reply(uint8_t seq) {
+    FrameBuf f;
+    frame_begin(f, RESP_OK, seq);
+    frame_add_i16(f, TAG_RSSI_DBM, -92);
+    frame_add_i8 (f, TAG_SNR_DB, 7);
+    frame_add_u16(f, TAG_VBAT_MV, 3711);
+    frame_add_u32(f, TAG_FREQ_HZ, 915000000);
+    frame_finalize(f);
+    return to_vector(f);
+}
+
+// One GET_ALL snapshot, streamed as three frames plus the empty end marker.
+static std::vector<std::vector<uint8_t>> snapshot_frames(uint8_t seq) {
+    std::vector<std::vector<uint8_t>> out;
+    FrameBuf f;
+    frame_begin(f, RESP_OK, seq);
+    frame_add_str(f, TAG_ID, "N3", 2);
+    frame_add_str(f, TAG_ALIAS, "ridge-relay", 11);
+    frame_add_str(f, TAG_FW_VERSION, "1.2.0", 5);
+    frame_add_u32(f, TAG_UPTIME_S, 86400);
+    frame_finalize(f);
+    out.push_back(to_vector(f));
+    frame_begin(f, RESP_OK, seq);
+    frame_add_u32(f, TAG_FREQ_HZ, 915000000);
+    frame_add_u8 (f, TAG_SF, 9);
+    frame_add_u32(f, TAG_BW_HZ, 125000);
+    frame_add_u8 (f, TAG_CR, 5);
+    frame_add_i8 (f, TAG_TX_PWR_DBM, 14);
+    frame_finalize(f);
+    out.push_back(to_vector(f));
+    out.push_back(telemetry_reply(seq));
+    frame_begin(f, RESP_OK, seq);
+    frame_finalize(f);
+    out.push_back(to_vector(f));
+    return out;
+}
+
+int main() {
+    const std::vector<uint8_t> tags = {TAG_RSSI_DBM, TAG_SNR_DB, TAG_VBAT_MV, TAG_FREQ_HZ};
+    const std::vector<std::vector<uint8_t>> sets = {make_set_sf(1, 9), make_set_freq(1, 915000000),
+                                                    make_set_tx_pwr(1, 14)};
+    const auto reply = telemetry_reply(7);
+    const auto snap  = snapshot_frames(8);
+
+    // Cross-checks: both builders agree, and the decoders see what was built
+    {
+        FrameBuf f;
+        frame_begin(f, GET_PARAM, 1);
+        for (uint8_t t : tags) frame_add_get(f, t);
+        frame_finalize(f);
+        if (to_vector(f) != make_get_params(1, tags)) { std::printf("FAIL: FrameBuf != make_get_params\n"); return 1; }
+
+        NodeReply r;
+        if (!decode_reply(reply, r) || r.seq != 7 || r.rssi_dbm != -92 || r.freq_hz != 915000000) {
+            std::printf("FAIL: decode_reply\n"); return 1;
+        }
+        if (decode_pretty(reply).find("rssi_dbm=-92") == std::string::npos) { std::printf("FAIL: decode_pretty\n"); return 1; }
+        if (decode_snapshot(snap).find("alias=ridge-relay") == std::string::npos) { std::printf("FAIL: decode_snapshot\n"); return 1; }
+    }
+
+    std::printf("codec: %d frames per row, typical ViaText frame sizes\n", ITERS);
+
+    std::printf("build:\n");
+    uint8_t seq = 0;
+    measure("make_get_id", 4, [&] { sink = sink + make_get_id(++seq).size(); });
+    measure("make_get_params x4", 12, [&] { sink = sink + make_get_params(++seq, tags).size(); });
+    measure("make_set_params x3", make_set_params(1, sets).size(),
+            [&] { sink = sink + make_set_params(++seq, sets).size(); });
+    {
+        FrameBuf f;
+        WireBuf w;
+        measure("FrameBuf+frame_seal x4", 12, [&] {
+            frame_begin(f, GET_PARAM, ++seq);
+            for (uint8_t t : tags) frame_add_get(f, t);
+            frame_seal(f, w);
+            sink = sink + w.len;
+        });
+    }
+
+    std::printf("slip (%zu-byte reply):\n", reply.size());
+    std::vector<uint8_t> wire;
+    measure("slip::encode", reply.size(), [&] { slip::encode(reply.data(), reply.size(), wire); sink = sink + wire.size(); });
+    {
+        slip::encode(reply.data(), reply.size(), wire);
+        std::vector<uint8_t> stream;                          // 1000 replies back to back
+        for (int i = 0; i < 1000; ++i) stream.insert(stream.end(), wire.begin(), wire.end());
+        slip::decoder d;
+        size_t frames = 0;
+        const auto t0 = Clock::now();
+        for (int r = 0; r < ITERS / 1000; ++r)
+            d.feed(stream.data(), stream.size(), [&](const uint8_t*, size_t len) { ++frames; sink = sink + len; });
+        const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("  %-26s %8.1f ns/frame %9.1f MB/s\n", "decoder::feed(buf)",
+                    secs * 1e9 / frames, double(reply.size()) * frames / secs / 1e6);
+    }
+
+    std::printf("decode:\n");
+    measure("TlvCursor walk", reply.size(), [&] {
+        TlvCursor cur(reply.data(), reply.size());
+        TlvView t;
+        while (cur.next(t)) sink = sink + t.len;
+    });
+    {
+        NodeReply r;
+        measure("decode_reply", reply.size(), [&] { decode_reply(reply, r); sink = sink + r.present; });
+    }
+    measure("decode_pretty", reply.size(), [&] { sink = sink + decode_pretty(reply).size(); });
+    size_t snap_bytes = 0;
+    for (const auto& f : snap) snap_bytes += f.size();
+    measure("decode_snapshot (4 frames)", snap_bytes, [&] { sink = sink + decode_snapshot(snap).size(); });
+    return 0;
+}
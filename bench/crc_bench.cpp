@@ -0,0 +1,110 @@
+// ============================================================================
+// crc_bench.cpp — CRC-32C throughput (make bench)
+//
+// Compares, on the same buffers:
+//   bitwise : one bit at a time (the definition, reference only)
+//   table   : crc32c_table() slice-by-8
+//   fast    : crc32c() — SSE4.2 / ARMv8 when the CPU has it, else the tables
+//
+// Sizes:
+//   frame   : 24 bytes (a typical reply; what --crc costs per frame)
+//   log     : 240 bytes (a full GET_LOG chunk)
+//   bulk    : 64 KiB (throughput ceiling)
+//
+// Before timing, the check value and every size/alignment/split are compared
+// across all paths, so a fast path that disagrees fails loudly.
+// ============================================================================
+
+#include "crc32c.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace viatext;
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t TOTAL_BYTES = 64u << 20;  // bytes checksummed per timing
+static constexpr int    ROUNDS      = 5;
+
+// Reference: the definition, one bit at a time.
+static uint32_t crc_bitwise(const uint8_t* p, size_t n) {
+    uint32_t c = ~0u;
+    for (size_t i = 0; i < n; ++i) {
+        c ^= p[i];
+        for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (crc::POLY & (0u - (c & 1u)));
+    }
+    return ~c;
+}
+
+template <class Fn>
+static double seconds(Fn fn) {
+    const auto t0 = Clock::now();
+    for (int r = 0; r < ROUNDS; ++r) fn();
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void report(const char* what, const char* size, double bytes, double secs) {
+    std::printf("  %-10s %-6s %8.2f GB/s\n", what, size, bytes * ROUNDS / secs / 1e9);
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> buf(70000);
+    for (auto& b : buf) b = static_cast<uint8_t>(rng());
+
+    std::printf("crc32c: %zu MiB per size, %d rounds\n", TOTAL_BYTES >> 20, ROUNDS);
+#if defined(VIATEXT_CRC_X86)
+    std::printf("  fast path: %s\n", crc32c_hw() ? "SSE4.2" : "tables (no SSE4.2)");
+#elif defined(VIATEXT_CRC_ARM)
+    std::printf("  fast path: ARMv8 CRC\n");
+#elif defined(VIATEXT_CRC_SCALAR)
+    std::printf("  fast path: tables (forced)\n");
+#else
+    std::printf("  fast path: tables\n");
+#endif
+
+    // Every path must agree with the definition
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    if (crc_bitwise(check, 9) != 0xE3069283u || crc32c_table(check, 9) != 0xE3069283u ||
+        crc32c(check, 9) != 0xE3069283u) {
+        std::printf("FAIL: check value\n");
+        return 1;
+    }
+    for (size_t off = 0; off < 8; ++off) {
+        for (size_t n = 0; n < 300; ++n) {
+            const uint8_t* p = buf.data() + off;
+            const uint32_t ref = crc_bitwise(p, n);
+            if (crc32c_table(p, n) != ref || crc32c(p, n) != ref) {
+                std::printf("FAIL: mismatch (offset %zu, %zu bytes)\n", off, n);
+                return 1;
+            }
+            const size_t h = n / 3;                    // piecewise must equal one pass
+            if (crc32c(p + h, n - h, crc32c(p, h)) != ref || crc32c_table(p + h, n - h, crc32c_table(p, h)) != ref) {
+                std::printf("FAIL: piecewise (offset %zu, %zu bytes)\n", off, n);
+                return 1;
+            }
+        }
+    }
+
+    const struct { const char* name; size_t len; } sizes[] = {
+        {"frame", 24}, {"log", 240}, {"bulk", 65536},
+    };
+    volatile uint32_t sink = 0;
+    for (const auto& s : sizes) {
+        const size_t reps = TOTAL_BYTES / s.len;
+        const double bytes = double(reps * s.len);
+        std::printf("%s:\n", s.name);
+        report("bitwise", s.name, bytes / 16, seconds([&] {
+            for (size_t r = 0; r < reps / 16; ++r) sink = sink + crc_bitwise(buf.data() + (r & 7), s.len);
+        }));
+        report("table", s.name, bytes, seconds([&] {
+            for (size_t r = 0; r < reps; ++r) sink = sink + crc32c_table(buf.data() + (r & 7), s.len);
+        }));
+        report("fast", s.name, bytes, seconds([&] {
+            for (size_t r = 0; r < reps; ++r) sink = sink + crc32c(buf.data() + (r & 7), s.len);
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+// ============================================================================
+// roundtrip_bench.cpp — end-to-end request latency over a pty (make bench)
+//
+// One mock node (mock_node.hpp) is served on a Reactor thread, so the host
+// side runs the real open_serial()/write_frame()/read_frame() stack on a
+// real tty. The mock runs with no latency, jitter or baud limit; what is
+// measured is the host and kernel share of every round trip, which is the
+// part the host-side work can change. Modes:
+//   single-shot : open_serial() + GET_PARAM + read_reply() + close per command
+//                 (a CLI invocation without process start-up)
+//   session     : port kept open, one request in flight (window 1)
+//   pipelined   : port kept open, 8 requests in flight
+//   batched     : one GET_PARAM carrying 8 tags per round trip
+//   run_session : the real session loop (parse, send, decode, print)
+//                 at window 1 and 8, throughput only
+// Latency is from write to matching reply; p50/p99 over every command.
+// ============================================================================
+
+#include "commands.hpp"
+#include "mock_node.hpp"
+#include "serial_io.hpp"
+#include "session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace viatext;
+using Clock = std::chrono::steady_clock;
+
+static constexpr int COMMANDS = 2000;        // per mode
+static constexpr int WINDOW   = 8;           // pipelined / run_session depth
+static constexpr int BATCH    = 8;           // tags per batched GET_PARAM
+
+// -------- measurement --------
+
+static void report(const char* mode, std::vector<double>& us, double secs, int commands) {
+    if (us.empty()) {                        // every round trip failed (or none was run)
+        std::printf("  %-22s no samples\n", mode);
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    const auto pct = [&](double q) { return us[std::min(us.size() - 1, size_t(q * us.size()))]; };
+    std::printf("  %-22s p50 %7.1f us  p99 %7.1f us  %9.0f cmd/s\n",
+                mode, pct(0.50), pct(0.99), commands / secs);
+}
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static double us_since(Clock::time_point t0) { return since(t0) * 1e6; }
+
+int main() {
+    MockOptions opt;
+    MockNode mock;
+    std::mt19937 rng(1);
+    Reactor reactor;
+    if (!mock_open(mock, "N0") || !mock_attach(reactor, mock, opt, rng)) {
+        std::printf("FAIL: no pty available\n");
+        return 1;
+    }
+    const std::string slave = mock.pts;
+    std::thread node([&] { reactor.run(); });
+
+    std::printf("roundtrip: %d commands per mode over %s (mock node, no link delay)\n",
+                COMMANDS, slave.c_str());
+
+    const std::vector<uint8_t> one = {TAG_RSSI_DBM};
+    const std::vector<uint8_t> many = {TAG_RSSI_DBM, TAG_SNR_DB, TAG_VBAT_MV, TAG_TEMP_C10,
+                                       TAG_FREQ_HZ, TAG_SF, TAG_BW_HZ, TAG_TX_PWR_DBM};
+    std::vector<uint8_t> resp;
+    std::vector<double> us;
+    int failures = 0;
+
+    // single-shot
+    {
+        us.clear();
+        const auto t0 = Clock::now();
+        for (int i = 0; i < COMMANDS; ++i) {
+            const auto s = Clock::now();
+            const uint8_t seq = static_cast<uint8_t>(1 + i % 0xEF);
+            const int fd = open_serial(slave, 115200, /*boot_delay_ms*/0);
+            if (fd < 0 || !write_frame(fd, make_get_params(seq, one)) || !read_reply(fd, seq, resp, 1000)) ++failures;
+            close_serial(fd);
+            us.push_back(us_since(s));
+        }
+        report("single-shot", us, since(t0), COMMANDS);
+    }
+
+    const int fd = open_serial(slave, 115200, /*boot_delay_ms*/0);
+    if (fd < 0) { std::printf("FAIL: open %s\n", slave.c_str()); return 1; }
+
+    // session and batched: one request in flight
+    for (const auto* tags : {&one, &many}) {
+        us.clear();
+        const auto t0 = Clock::now();
+        for (int i = 0; i < COMMANDS; ++i) {
+            const auto s = Clock::now();
+            const uint8_t seq = static_cast<uint8_t>(1 + i % 0xEF);
+            if (!write_frame(fd, make_get_params(seq, *tags)) || !read_reply(fd, seq, resp, 1000)) ++failures;
+            us.push_back(us_since(s));
+        }
+        const double secs = since(t0);
+        if (tags == &one) {
+            report("session", us, secs, COMMANDS);
+        } else {
+            report("batched (8 tags)", us, secs, COMMANDS);
+            std::printf("  %-22s%33s%9.0f params/s\n", "", "", COMMANDS * BATCH / secs);
+        }
+    }
+
+    // pipelined: keep WINDOW requests on the wire, match replies by seq
+    {
+        us.clear();
+        std::vector<Clock::time_point> sent(256);
+        int next = 0, done = 0;
+        const auto t0 = Clock::now();
+        while (done < COMMANDS) {
+            while (next < COMMANDS && next - done < WINDOW) {
+                const uint8_t seq = static_cast<uint8_t>(1 + next % 0xEF);
+                sent[seq] = Clock::now();
+                if (!write_frame(fd, make_get_params(seq, one))) ++failures;
+                ++next;
+            }
+            if (!read_frame(fd, resp, 1000)) { ++failures; break; }
+            if (resp.size() < 3) continue;
+            us.push_back(us_since(sent[resp[2]]));
+            ++done;
+        }
+        report("pipelined (window 8)", us, since(t0), done);
+    }
+    close_serial(fd);
+
+    // run_session: the whole loop, fed from memory
+    for (int window : {1, WINDOW}) {
+        std::string script;
+        for (int i = 0; i < COMMANDS; ++i) script += "get rssi\n";
+        std::istringstream in(script);
+        std::ostringstream out;
+        const int sfd = open_serial(slave, 115200, /*boot_delay_ms*/0);
+        const auto t0 = Clock::now();
+        failures += run_session(sfd, in, out, 1000, window);
+        const double secs = since(t0);
+        close_serial(sfd);
+        const std::string mode = "run_session (window " + std::to_string(window) + ")";
+        std::printf("  %-22s%33s%9.0f cmd/s\n", mode.c_str(), "", COMMANDS / secs);
+    }
+
+    reactor.stop();
+    node.join();
+    mock_close(mock);
+    if (failures) { std::printf("FAIL: %d commands went unanswered\n", failures); return 1; }
+    return 0;
+}
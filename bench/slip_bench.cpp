@@ -0,0 +1,139 @@
+// ============================================================================
+// slip_bench.cpp — SLIP framing throughput (make bench)
+//
+// Compares, on the same payloads:
+//   encode  : byte-at-a-time reference loop  vs  slip::encode() fast path
+//   decode  : decoder::feed(byte, frame)     vs  decoder::feed(buf, n, on_frame)
+//   scan    : scan_special_scalar()          vs  scan_special()
+//
+// Payload mixes:
+//   clean   : random bytes with END/ESC removed (typical TLV traffic)
+//   sparse  : ~1 END/ESC per 256 bytes (log text, firmware images)
+//   dense   : ~1 in 8 (worst realistic case; runs are short)
+//
+// Before timing, every mix is round-tripped through both paths and the
+// results compared, so a fast path that disagrees fails loudly.
+// ============================================================================
+
+#include "slip.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace viatext;
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t FRAME_BYTES = 4096;     // payload per frame
+static constexpr size_t FRAMES      = 256;      // frames per stream (1 MiB payload)
+static constexpr int    ROUNDS      = 20;
+
+// Reference encoder: the original per-byte push_back loop.
+static void encode_ref(const uint8_t* in, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(n * 2 + 2);
+    out.push_back(slip::END);
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t b = in[i];
+        if (b == slip::END)      { out.push_back(slip::ESC); out.push_back(slip::ESC_END); }
+        else if (b == slip::ESC) { out.push_back(slip::ESC); out.push_back(slip::ESC_ESC); }
+        else                       out.push_back(b);
+    }
+    out.push_back(slip::END);
+}
+
+static std::vector<uint8_t> make_payload(std::mt19937& rng, unsigned special_one_in) {
+    std::vector<uint8_t> p(FRAME_BYTES);
+    for (auto& b : p) {
+        b = static_cast<uint8_t>(rng());
+        const bool special = special_one_in && rng() % special_one_in == 0;
+        if (special)                                  b = (rng() & 1) ? slip::END : slip::ESC;
+        else if (b == slip::END || b == slip::ESC)    b ^= 0x01;
+    }
+    return p;
+}
+
+template <class Fn>
+static double seconds(Fn fn) {
+    const auto t0 = Clock::now();
+    for (int r = 0; r < ROUNDS; ++r) fn();
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void report(const char* what, const char* mix, double bytes, double secs) {
+    std::printf("  %-22s %-7s %8.2f GB/s\n", what, mix, bytes * ROUNDS / secs / 1e9);
+}
+
+int main() {
+    std::mt19937 rng(42);
+    const struct { const char* name; unsigned one_in; } mixes[] = {
+        {"clean", 0}, {"sparse", 256}, {"dense", 8},
+    };
+
+    std::printf("slip: %zu frames x %zu bytes, %d rounds\n", FRAMES, FRAME_BYTES, ROUNDS);
+#if defined(VIATEXT_SLIP_SSE2)
+    std::printf("  scan path: SSE2\n");
+#elif defined(VIATEXT_SLIP_NEON)
+    std::printf("  scan path: NEON\n");
+#elif defined(VIATEXT_SLIP_SCALAR)
+    std::printf("  scan path: scalar (forced)\n");
+#else
+    std::printf("  scan path: SWAR\n");
+#endif
+
+    volatile size_t sink = 0;
+    for (const auto& m : mixes) {
+        std::vector<std::vector<uint8_t>> payloads;
+        for (size_t f = 0; f < FRAMES; ++f) payloads.push_back(make_payload(rng, m.one_in));
+        const double payload_bytes = double(FRAMES * FRAME_BYTES);
+
+        // Build the wire stream once, checking encode against the reference
+        std::vector<uint8_t> wire, a, b;
+        for (const auto& p : payloads) {
+            encode_ref(p.data(), p.size(), a);
+            slip::encode(p.data(), p.size(), b);
+            if (a != b) { std::printf("FAIL: encode mismatch (%s)\n", m.name); return 1; }
+            wire.insert(wire.end(), b.begin(), b.end());
+        }
+
+        // Both decode paths must return the original payloads
+        {
+            slip::decoder d1, d2;
+            std::vector<uint8_t> frame;
+            size_t k1 = 0, k2 = 0;
+            for (uint8_t x : wire)
+                if (d1.feed(x, frame) && frame != payloads[k1++]) { std::printf("FAIL: byte decode (%s)\n", m.name); return 1; }
+            d2.feed(wire.data(), wire.size(), [&](const uint8_t* f, size_t len) {
+                if (std::vector<uint8_t>(f, f + len) != payloads[k2]) { std::printf("FAIL: bulk decode (%s)\n", m.name); std::exit(1); }
+                ++k2;
+            });
+            if (k1 != FRAMES || k2 != FRAMES) { std::printf("FAIL: frame count (%s)\n", m.name); return 1; }
+        }
+
+        std::printf("%s:\n", m.name);
+        report("scan scalar", m.name, double(wire.size()), seconds([&] {
+            for (size_t i = 0; i < wire.size(); ) { i += slip::scan_special_scalar(wire.data() + i, wire.size() - i) + 1; sink = sink + i; }
+        }));
+        report("scan vector", m.name, double(wire.size()), seconds([&] {
+            for (size_t i = 0; i < wire.size(); ) { i += slip::scan_special(wire.data() + i, wire.size() - i) + 1; sink = sink + i; }
+        }));
+        report("encode per-byte", m.name, payload_bytes, seconds([&] {
+            for (const auto& p : payloads) { encode_ref(p.data(), p.size(), a); sink = sink + a.size(); }
+        }));
+        report("encode fast", m.name, payload_bytes, seconds([&] {
+            for (const auto& p : payloads) { slip::encode(p.data(), p.size(), b); sink = sink + b.size(); }
+        }));
+        report("decode feed(byte)", m.name, double(wire.size()), seconds([&] {
+            slip::decoder d;
+            std::vector<uint8_t> frame;
+            for (uint8_t x : wire) if (d.feed(x, frame)) sink = sink + frame.size();
+        }));
+        report("decode feed(buf)", m.name, double(wire.size()), seconds([&] {
+            slip::decoder d;
+            d.feed(wire.data(), wire.size(), [&](const uint8_t*, size_t len) { sink = sink + len; });
+        }));
+    }
+    return 0;
+}
@@ -27,8 +27,10 @@
  *   * It enforces which parameters are read-only (no SET variant).
  * - Provides `build_packet_from_kind()` which takes a `CommandKind`
  *   (plus an optional string value for SETs) and returns the exact
- *   TLV-framed request bytes using the builders in commands.cpp.
- *   * Includes validation: `--set sf 99` will fail with `err="bad_value:sf"`.
+ *   TLV-framed request bytes, encoded per the parameter's row in
+ *   param_table.hpp (verb, tag, wire type, range).
+ *   * Includes validation: `--set sf 99` will fail with `err="bad_value:sf(7..12)"`.
+ *   * `build_frame_from_kind()` is the same, into a caller-owned FrameBuf.
  * - Provides wrappers:
  *   * `build_legacy_packet()` for compatibility with the old `--get-id`, `--ping`,
  *     and `--set-id` flags.
@@ -57,16 +59,19 @@
  *
  * DESIGN ADVANTAGES
  * -----------------
- * - **Single point of truth**: All valid command names live in one switch.
+ * - **Single point of truth**: every name, alias, tag, wire type and range
+ *   lives in one constexpr table (param_table.hpp); lookup, building,
+ *   batching and decoding all read it.
  * - **Robust validation**: Numeric ranges checked before hitting firmware.
- * - **Extendable**: Adding new parameter = add builder + enum entry + string alias.
+ * - **Extendable**: Adding new parameter = tag + enum pair + one table row.
  * - **Keeps CLI thin**: main.cpp never explodes into a maze of if/else for each param.
  *
  * TRADE-OFFS
  * ----------
- * - Requires manual maintenance of the enum + switch (no codegen).
- * - Slight redundancy: command names exist here and in commands.cpp,
- *   but this separation ensures CLI errors are caught early and explained.
+ * - CommandKind is still kept by hand next to the table; static_asserts in
+ *   param_table.hpp catch a kind without a row and duplicate names.
+ * - The named make_*() builders in commands.cpp remain for direct callers;
+ *   the dispatcher no longer goes through them.
  *
  * EXAMPLE
  * -------
@@ -84,11 +89,10 @@
  * MAINTENANCE
  * -----------
  * - When adding a new parameter:
- *   1) Add the low-level builder(s) in commands.hpp/cpp.
- *   2) Extend CommandKind enum.
- *   3) Extend name_to_kind() to map user string to enum.
- *   4) Extend build_packet_from_kind() to call the right builder,
- *      with parsing/validation if needed.
+ *   1) Add its TAG_* value in commands.hpp.
+ *   2) Extend CommandKind enum (GET_ and, if writable, SET_).
+ *   3) Add one row to PARAMS in param_table.hpp (names, tag, type, range, key).
+ *   4) If typed consumers need it, add a NodeReply field + decode_reply() case.
  * @see docs/add_parameter_steps.md
  * 
  * With this pattern, the CLI and tooling scale without main.cpp changes.
@@ -102,8 +106,11 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 #include <cstdint>
 
+#include "commands.hpp"   // FrameBuf for build_frame_from_kind()
+
 namespace viatext {
 
 /**
@@ -136,8 +143,8 @@ namespace viatext {
  * basement, bunker, or backpack deployment and need to know what a ViaText
  * node can do, this is the list. Every valid operation is here.
  *
- * @note To add new parameters: extend this enum, add string mapping in
- *       `name_to_kind()`, and implement the builder in commands.cpp.
+ * @note To add new parameters: extend this enum and add the row to PARAMS
+ *       in param_table.hpp.
  */
 enum class CommandKind {
 
@@ -307,7 +314,8 @@ enum class CommandKind {
  *
  * DESIGN NOTES
  * ------------
- * - Switch-based dispatch makes command handling explicit and auditable.
+ * - Table-driven: the kind selects a PARAMS row (O(1) index); the row's
+ *   verb, tag, wire type and range drive encoding and validation.
  * - All parsing is local and exception-free (safe for embedded use).
  * - Error strings are short, stable, and script-friendly.
  */
@@ -317,6 +325,18 @@ bool build_packet_from_kind(CommandKind kind,
                             std::vector<uint8_t>& out,
                             std::string& err);
 
+/**
+ * @brief build_packet_from_kind() into a caller-owned FrameBuf (no allocation).
+ *
+ * Same validation and error strings; on success @p f holds the finalized
+ * payload, ready for frame_seal() or write_frame(f.bytes.data(), f.len).
+ */
+bool build_frame_from_kind(CommandKind kind,
+                           uint8_t seq,
+                           const std::string& value,
+                           FrameBuf& f,
+                           std::string& err);
+
 
 /**
  * @brief Resolve a user-facing name and operation into a CommandKind.
@@ -359,9 +379,10 @@ bool build_packet_from_kind(CommandKind kind,
  *
  * DESIGN NOTES
  * ------------
- * - Aliases are hard-coded here for transparency and offline readability.
- * - Lookup is O(n) through chained if-statements, chosen for simplicity
- *   and small binary size over more complex data structures.
+ * - Names and aliases come from PARAMS (param_table.hpp), sorted at
+ *   compile time; lookup is a binary search after a stack-buffer
+ *   lowercase, so mixed-case input is accepted and nothing allocates.
+ * - Read-only rows have no SET form: `is_set` on them returns false.
  * - Errors are not silent: unknown inputs cleanly return false so higher
  *   layers can explain the failure.
  */
@@ -436,10 +457,57 @@ bool build_legacy_packet(bool get_id,
  * ------------
  * - Uses name_to_kind(name, false, out_kind) for resolution.
  * - Delegates encoding to build_packet_from_kind.
+ * - A comma-separated list ("freq,sf,bw") is forwarded to build_param_get_batch().
  */
 bool build_param_get_packet(const std::string& name, uint8_t seq,
                             std::vector<uint8_t>& out, std::string& err);
 
+/**
+ * @brief Build one GET_PARAM packet that requests several parameters.
+ *
+ * Each name is resolved and validated exactly as build_param_get_packet()
+ * would, then all tags are packed into a single multi-TLV frame via
+ * make_get_params(). "id" is sent as TAG_ID; "ping" and "all" are rejected.
+ *
+ * PARAMETERS
+ * ----------
+ * @param names Parameter names (e.g. {"freq","sf","bw"}).
+ * @param seq   Sequence number for the request.
+ * @param out   Filled with the encoded packet on success.
+ * @param err   On failure: "unknown_get:<name>", "not_batchable:<name>",
+ *              or "batch_too_large".
+ *
+ * RETURNS
+ * -------
+ * @retval true   All names resolved and the packet was constructed.
+ * @retval false  See @p err.
+ */
+bool build_param_get_batch(const std::vector<std::string>& names, uint8_t seq,
+                           std::vector<uint8_t>& out, std::string& err);
+
+/**
+ * @brief Build one SET_PARAM packet that writes several parameters.
+ *
+ * Every (name, value) pair is validated by build_packet_from_kind() exactly
+ * like a single --set, then the resulting TLVs are merged with
+ * make_set_params(). Legacy SET_ID is not batchable.
+ *
+ * PARAMETERS
+ * ----------
+ * @param kv    (name, value) pairs in the order they should be applied.
+ * @param seq   Sequence number for the request.
+ * @param out   Filled with the encoded packet on success.
+ * @param err   On failure: "unknown_set:<name>", any "bad_value:..." string,
+ *              "not_batchable:<name>", or "batch_too_large".
+ *
+ * RETURNS
+ * -------
+ * @retval true   All pairs valid and the packet was constructed.
+ * @retval false  See @p err.
+ */
+bool build_param_set_batch(const std::vector<std::pair<std::string, std::string>>& kv, uint8_t seq,
+                           std::vector<uint8_t>& out, std::string& err);
+
 /**
  * @brief Build a SET_* packet from a user-facing parameter name and value.
  *
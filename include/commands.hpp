@@ -1,3 +1,4 @@
+#pragma once
 /**
  * @page vt-commands ViaText Commands Layer
  * @file commands.hpp
@@ -96,8 +97,11 @@
  * @author ChatGPT
  */
 
+#include <array>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <cstdint>
 
 namespace viatext {
@@ -112,8 +116,9 @@ namespace viatext {
  * for quick checks and backwards compatibility.
  *
  * How it’s used on the wire:
- *   - Requests start with one of: GET_ID, SET_ID, PING, GET_PARAM, SET_PARAM, GET_ALL.
+ *   - Requests start with one of: GET_ID, SET_ID, PING, GET_PARAM, SET_PARAM, GET_ALL, GET_LOG.
  *   - Responses start with RESP_OK or RESP_ERR, followed by TLVs with details.
+ *     RESP_NACK only appears on links with CRC trailers (see Header Flags).
  *
  * Notes for beginners:
  *   - TLV means Type-Length-Value: a compact way to ship small fields.
@@ -127,12 +132,38 @@ enum : uint8_t {
     GET_PARAM = 0x10,  /**< Parameter read: include one or more TAGs with len=0 to request their values. */
     SET_PARAM = 0x11,  /**< Parameter write: include TAGs with value bytes to set new values. */
     GET_ALL   = 0x12,  /**< Snapshot read: node may stream multiple RESP_OK frames with many TLVs. */
+    GET_LOG   = 0x13,  /**< Log range read: TAG_LOG_FROM/TAG_LOG_MAX in; streamed RESP_OK frames of
+                            TAG_LOG_INDEX + TAG_LOG_ENTRY pairs out, then an empty RESP_OK. */
 
     RESP_OK   = 0x90,  /**< Response: the request succeeded; TLVs carry results. */
-    RESP_ERR  = 0x91   /**< Response: the request failed; TLVs may include error info. */
+    RESP_ERR  = 0x91,  /**< Response: the request failed; TLVs may include error info. */
+    RESP_NACK = 0x92   /**< Response: the request arrived damaged (CRC mismatch); resend it.
+                            The seq byte is not trustworthy and is 0. */
 };
 
 
+/**
+ * @name Header Flags
+ * @brief Bits of header byte [1] (reserved and 0 on older hosts and firmware).
+ *
+ * Firmware that predates these ignores the byte and never sets it, so both
+ * bits are safe to send to any node; see link_guard.hpp for the negotiation.
+ *
+ *   - FLAG_CRC: this frame ends with a CRC_LEN-byte CRC-32C trailer
+ *     (little-endian, over every byte before it, header included). The
+ *     trailer sits behind the TLV section, so a reader that stops at the
+ *     TLV length byte never sees it.
+ *   - FLAG_CRC_OK: the sender checks trailers; put one on frames sent back.
+ */
+enum : uint8_t {
+    FLAG_CRC    = 0x01,  /**< Frame carries a CRC-32C trailer. */
+    FLAG_CRC_OK = 0x02   /**< Sender verifies trailers on frames it receives. */
+};
+
+/** @brief Trailer size in bytes when FLAG_CRC is set. */
+constexpr size_t CRC_LEN = 4;
+
+
 // ============================== TLV Tags =============================
 /**
  * @name TLV Tags: Identity / System
@@ -202,6 +233,25 @@ enum : uint8_t {
 };
 
 
+/**
+ * @name TLV Tags: Log transfer (GET_LOG only)
+ * @brief Range selection in a GET_LOG request and records in its replies.
+ *
+ * Entries are numbered 0..log_count-1, oldest first. A request asks for up to
+ * TAG_LOG_MAX entries starting at TAG_LOG_FROM; the node answers with as many
+ * RESP_OK frames as it takes, each holding whole records (a TAG_LOG_INDEX
+ * followed by its TAG_LOG_ENTRY), then one RESP_OK with no TLVs. A range
+ * past the end is just the empty frame. Not parameters: there is no param
+ * table row for these and GET_PARAM/SET_PARAM don't carry them.
+ */
+enum : uint8_t {
+    TAG_LOG_FROM    = 0x40, /**< u32: first entry index wanted (request). */
+    TAG_LOG_MAX     = 0x41, /**< u16: most entries to return for this request (request). */
+    TAG_LOG_INDEX   = 0x42, /**< u32: index of the record that follows (reply). */
+    TAG_LOG_ENTRY   = 0x43  /**< bytes: the record itself, up to 249 bytes (reply). */
+};
+
+
 // ========================= Convenience Builders =========================
 /**
  * @brief Build a GET_ID request frame (no TLVs).
@@ -669,6 +719,21 @@ std::vector<uint8_t> make_get_free_flash(uint8_t seq);
  */
 std::vector<uint8_t> make_get_log_count(uint8_t seq);
 
+/**
+ * @brief Build a GET_LOG request for entries [@p from, @p from + @p max).
+ *
+ * Wire shape:
+ *   [verb=GET_LOG, seq, TLV(TAG_LOG_FROM,u32), TLV(TAG_LOG_MAX,u16)]
+ *
+ * @param seq  Sequence number; every reply frame of the range carries it.
+ * @param from First entry index.
+ * @param max  Most entries the node should send (1..65535).
+ * @return Encoded packet ready for transmission.
+ *
+ * @see log_pull.hpp for the windowed download built on it.
+ */
+std::vector<uint8_t> make_get_log(uint8_t seq, uint32_t from, uint16_t max);
+
 // ============================= Bulk Read ==============================
 
 /**
@@ -689,8 +754,246 @@ std::vector<uint8_t> make_get_log_count(uint8_t seq);
 std::vector<uint8_t> make_get_all(uint8_t seq);
 
 
+// ========================= Batched Parameters =========================
+
+/**
+ * @brief Build one GET_PARAM request that asks for several tags at once.
+ *
+ * The protocol lets GET_PARAM carry any number of len=0 TLVs; the node replies
+ * with one RESP_OK frame holding a value TLV for each. Reading freq, sf, bw,
+ * rssi, snr and vbat this way costs one round trip instead of six.
+ *
+ * Wire shape:
+ *   [verb=GET_PARAM, seq, TLV(tag0,len=0), TLV(tag1,len=0), ...]
+ *
+ * @param seq  Sequence number for request/response correlation.
+ * @param tags TLV tags to request (TAG_*), in the order they should be asked.
+ * @return Encoded packet, or an empty vector if @p tags is empty or too many
+ *         to fit the 255-byte TLV section.
+ */
+std::vector<uint8_t> make_get_params(uint8_t seq, const std::vector<uint8_t>& tags);
+
+/**
+ * @brief Build one SET_PARAM request that writes several parameters at once.
+ *
+ * Takes requests produced by the single-parameter make_set_*() builders and
+ * merges their TLVs behind a fresh header, so every value keeps the exact wire
+ * type its builder gave it.
+ *
+ * @param seq   Sequence number for request/response correlation.
+ * @param parts Single-parameter SET_PARAM requests (e.g. from make_set_sf()).
+ * @return Encoded packet, or an empty vector if @p parts is empty, contains a
+ *         non-SET_PARAM request, or the merged TLVs exceed 255 bytes.
+ */
+std::vector<uint8_t> make_set_params(uint8_t seq, const std::vector<std::vector<uint8_t>>& parts);
+
+
+// ===================== Zero-Allocation Frame Building =====================
+
+/**
+ * @name Fixed-size frame buffers
+ * @brief Build requests without touching the heap.
+ *
+ * Every make_*() above returns a fresh std::vector (one allocation per request,
+ * plus another inside write_frame() for the SLIP copy). Hot paths that send
+ * many requests (session, fan-out, daemon) can instead keep one FrameBuf and
+ * one WireBuf alive and refill them per request:
+ *
+ * @code
+ *   viatext::FrameBuf f;
+ *   viatext::WireBuf  w;
+ *   viatext::frame_begin(f, viatext::GET_PARAM, seq);
+ *   viatext::frame_add_get(f, viatext::TAG_RSSI_DBM);
+ *   viatext::frame_add_get(f, viatext::TAG_SNR_DB);
+ *   if (viatext::frame_seal(f, w)) ::write(fd, w.bytes.data(), w.len);
+ * @endcode
+ *
+ * The same TLV-layout code backs both APIs, so the bytes are identical.
+ * @{
+ */
+constexpr size_t FRAME_HEADER = 4;                       /**< [verb][flags][seq][tlv_len] */
+constexpr size_t MAX_FRAME    = FRAME_HEADER + 255;      /**< tlv_len is one byte */
+constexpr size_t MAX_WIRE     = MAX_FRAME * 2 + 2;       /**< worst-case SLIP encoding */
+
+/** @brief Request payload (unframed), filled in place by frame_*(). */
+struct FrameBuf {
+    std::array<uint8_t, MAX_FRAME> bytes;  /**< payload bytes [0, len) */
+    size_t len = 0;                        /**< bytes used */
+    bool overflow = false;                 /**< a TLV did not fit; frame must not be sent */
+};
+
+/** @brief SLIP-encoded frame ready for write(2). */
+struct WireBuf {
+    std::array<uint8_t, MAX_WIRE> bytes;   /**< encoded bytes [0, len) */
+    size_t len = 0;                        /**< bytes used */
+};
+
+/** @brief Reset @p f and write the 4-byte header. */
+void frame_begin(FrameBuf& f, uint8_t verb, uint8_t seq);
+
+/** @brief Append a len=0 TLV (GET_PARAM request form). */
+void frame_add_get(FrameBuf& f, uint8_t tag);
+
+/** @brief Append typed TLVs (little-endian integers, UTF-8 string clamped to 255 bytes). */
+void frame_add_u8 (FrameBuf& f, uint8_t tag, uint8_t v);
+void frame_add_i8 (FrameBuf& f, uint8_t tag, int8_t v);
+void frame_add_u16(FrameBuf& f, uint8_t tag, uint16_t v);
+void frame_add_i16(FrameBuf& f, uint8_t tag, int16_t v);
+void frame_add_u32(FrameBuf& f, uint8_t tag, uint32_t v);
+void frame_add_str(FrameBuf& f, uint8_t tag, const char* s, size_t n);
+
+/**
+ * @brief Backfill the TLV length byte.
+ * @return false if the frame overflowed MAX_FRAME (nothing usable to send).
+ */
+bool frame_finalize(FrameBuf& f);
+
+/**
+ * @brief Finalize @p f and SLIP-encode it into @p w in one step.
+ * @return false if the frame overflowed; @p w.len is then 0.
+ */
+bool frame_seal(FrameBuf& f, WireBuf& w);
+/** @} */
+
+
+// =========================== Frame Integrity ==========================
+
+/**
+ * @brief Copy frame @p f into @p out with FLAG_CRC | FLAG_CRC_OK set and a trailer appended.
+ *
+ * A frame shorter than FRAME_HEADER is copied unchanged. @p out keeps its
+ * capacity between calls, so a reused buffer doesn't allocate.
+ */
+void crc_seal(const uint8_t* f, size_t n, std::vector<uint8_t>& out);
+
+/** @brief In-place form of crc_seal() (node side, tests). */
+void crc_seal(std::vector<uint8_t>& f);
+
+/** @brief Verdict of crc_check(). */
+enum class CrcCheck : uint8_t {
+    None,   /**< No FLAG_CRC (or too short to have a header): nothing to check. */
+    Ok,     /**< Trailer matches; the payload is the first n - CRC_LEN bytes. */
+    Bad     /**< Trailer missing or wrong: the frame was damaged on the way. */
+};
+
+/** @brief Check the trailer of a received frame (does not strip it). */
+CrcCheck crc_check(const uint8_t* f, size_t n);
+
+
 // =========================== Response Decode ==========================
 
+/**
+ * @brief Non-owning view of one TLV inside a received frame.
+ *
+ * Points into the frame buffer; valid only while that buffer is alive and
+ * unchanged. Typed accessors check the length against the wire type and
+ * return false on mismatch, leaving @p out untouched.
+ */
+struct TlvView {
+    uint8_t tag = 0;               /**< TLV tag (TAG_*) */
+    uint8_t len = 0;               /**< value length in bytes */
+    const uint8_t* val = nullptr;  /**< first value byte (inside the frame) */
+
+    bool as_u8 (uint8_t&  out) const;
+    bool as_i8 (int8_t&   out) const;
+    bool as_u16(uint16_t& out) const;   /**< little-endian */
+    bool as_i16(int16_t&  out) const;   /**< little-endian */
+    bool as_u32(uint32_t& out) const;   /**< little-endian */
+
+    /** @brief Value as text (no copy; may contain arbitrary bytes). */
+    std::string_view str() const { return {reinterpret_cast<const char*>(val), len}; }
+};
+
+/**
+ * @brief Forward-only walker over the TLV section of a frame, without copies.
+ *
+ * @code
+ *   viatext::TlvCursor cur(frame.data(), frame.size());
+ *   viatext::TlvView t;
+ *   while (cur.next(t)) {
+ *       uint32_t hz;
+ *       if (t.tag == viatext::TAG_FREQ_HZ && t.as_u32(hz)) { ... }
+ *   }
+ * @endcode
+ *
+ * Bounds: the walk stops at the frame's TLV length byte or at the end of the
+ * received bytes, whichever is first. A TLV whose length runs past that point
+ * ends the walk and sets @ref truncated.
+ */
+struct TlvCursor {
+    const uint8_t* p   = nullptr;  /**< next TLV */
+    const uint8_t* end = nullptr;  /**< one past the TLV section */
+    bool truncated = false;        /**< a TLV was cut short */
+
+    TlvCursor(const uint8_t* frame, size_t n);
+
+    /** @brief Advance to the next TLV. @return false at the end of the section. */
+    bool next(TlvView& t);
+};
+
+/**
+ * @brief Typed decode of one RESP_* frame into plain fields.
+ *
+ * For collectors and output formatters that want values, not text. Each known
+ * tag has a field of its wire type; @ref present tells which ones the frame
+ * carried (bit N = tag N, every tag is < 64). String fields are views into
+ * the frame and share its lifetime.
+ */
+struct NodeReply {
+    uint8_t  verb = 0;             /**< RESP_OK / RESP_ERR (or anything else received) */
+    uint8_t  seq  = 0;             /**< echoed sequence number */
+    uint64_t present = 0;          /**< bit(tag) set for every decoded field */
+    uint8_t  unknown = 0;          /**< TLVs with tags this host doesn't know */
+    uint8_t  bad = 0;              /**< TLVs with wrong length for their type, or truncated */
+    uint8_t  frames = 0;           /**< frames merged into this reply (see decode_reply_into()) */
+
+    // Identity / System
+    std::string_view id, alias, fw;
+    uint32_t uptime_s = 0, boot_time = 0;
+
+    // Radio
+    uint32_t freq_hz = 0, bw_hz = 0;
+    uint8_t  sf = 0, cr = 0, chan = 0;
+    int8_t   tx_pwr_dbm = 0;
+
+    // Behavior
+    uint8_t  mode = 0, hops = 0, ack = 0;
+    uint32_t beacon_s = 0;
+    uint16_t buf_size = 0;
+
+    // Diagnostics
+    int16_t  rssi_dbm = 0, temp_c10 = 0;
+    int8_t   snr_db = 0;
+    uint16_t vbat_mv = 0, log_count = 0;
+    uint32_t free_mem = 0, free_flash = 0;
+
+    static constexpr uint64_t bit(uint8_t tag) { return tag < 64 ? (uint64_t(1) << tag) : 0; }
+    bool has(uint8_t tag) const { return (present & bit(tag)) != 0; }
+    bool ok() const { return verb == RESP_OK; }
+};
+
+/**
+ * @brief Decode a RESP_* frame into @p r without building strings.
+ *
+ * @return false only if the frame is too short to hold a header; otherwise
+ *         true, with @ref NodeReply::bad / @ref NodeReply::unknown counting
+ *         TLVs that were skipped.
+ */
+bool decode_reply(const uint8_t* frame, size_t n, NodeReply& r);
+bool decode_reply(const std::vector<uint8_t>& frame, NodeReply& r);
+
+/**
+ * @brief Merge one more frame into @p r (streamed GET_ALL snapshots).
+ *
+ * Fields present in this frame overwrite earlier values; others are kept.
+ * @ref NodeReply::seq comes from the first frame, and RESP_ERR in any frame
+ * makes the merged verb RESP_ERR. Start from a default-constructed NodeReply.
+ *
+ * @return false if the frame is too short to hold a header (nothing merged).
+ */
+bool decode_reply_into(const uint8_t* frame, size_t n, NodeReply& r);
+
+
 /**
  * @brief Convert a raw RESP_* frame into a compact, single-line summary.
  *
@@ -713,4 +1016,22 @@ std::vector<uint8_t> make_get_all(uint8_t seq);
 std::string decode_pretty(const std::vector<uint8_t>& frame);
 
 
+/**
+ * @brief Merge several RESP_* frames (e.g. a streamed GET_ALL) into one summary line.
+ *
+ * GET_ALL replies may span many frames that share the request's sequence number.
+ * This flattens all of their TLVs into a single `decode_pretty()`-style line so
+ * the snapshot is printed once, complete.
+ *
+ * Merge rules:
+ *   - status is "error" if any frame is RESP_ERR, "ok" if all are RESP_OK.
+ *   - seq is taken from the first frame.
+ *   - A tag seen again in a later frame updates the value in place.
+ *
+ * @param frames Raw frames in arrival order.
+ * @return A summarized string with the same key names as decode_pretty().
+ */
+std::string decode_snapshot(const std::vector<std::vector<uint8_t>>& frames);
+
+
 } // namespace viatext
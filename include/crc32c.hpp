@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * @page vt-crc32c ViaText CRC-32C
+ * @file crc32c.hpp
+ * @brief CRC-32C (Castagnoli) for the optional frame trailer on noisy links.
+ *
+ * @details
+ * WHY CRC-32C
+ * -----------
+ * SLIP gives boundaries, not integrity: a flipped bit inside a TLV value
+ * decodes as a wrong frequency or RSSI without any error. The frame trailer
+ * (commands.hpp FLAG_CRC, link_guard.hpp) catches that. Castagnoli rather
+ * than the zlib polynomial because x86 (SSE4.2 `crc32`) and ARMv8 (`crc32c*`)
+ * compute it in hardware, and its Hamming distance is better for the short
+ * frames ViaText sends. A CRC-16 would save two bytes per frame and buy
+ * nothing in speed, so there is only this one.
+ *
+ * PATHS
+ * -----
+ * - x86-64: `crc32` 8 bytes per instruction. Built with a target attribute
+ *   and chosen at run time (first call), so the default -O2 build without
+ *   -msse4.2 still uses it on every CPU since 2008.
+ * - AArch64 with __ARM_FEATURE_CRC32 (-march=armv8-a+crc, default on most
+ *   distro toolchains for Pi 4/5): `crc32cx` 8 bytes per instruction.
+ * - Anything else: slice-by-8 tables (8 KiB, built at compile time).
+ * Define VIATEXT_CRC_SCALAR to force the tables. `make bench` checks every
+ * path against the tables and reports their throughput.
+ *
+ * PARAMETERS
+ * ----------
+ * Reflected polynomial 0x82F63B78, init ~0, final xor ~0 (iSCSI, ext4,
+ * RFC 3720). Check value: crc32c("123456789") == 0xE3069283.
+ *
+ * @code
+ *   uint32_t c = viatext::crc32c(frame.data(), frame.size());
+ *   // or in pieces: c = crc32c(tail, m, crc32c(head, n));
+ * @endcode
+ *
+ * @see commands.hpp (crc_seal(), crc_check()), link_guard.hpp
+ */
+
+// Dependencies:
+// - <cstdint>  fixed-size integer types.
+// - <cstddef>  size_t.
+// - <cstring>  memcpy for unaligned 8-byte loads.
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if !defined(VIATEXT_CRC_SCALAR)
+#  if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#    include <nmmintrin.h>
+#    define VIATEXT_CRC_X86 1
+#  elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#    include <arm_acle.h>
+#    define VIATEXT_CRC_ARM 1
+#  endif
+#endif
+
+namespace viatext {
+namespace crc {
+
+/** @brief Reflected CRC-32C polynomial. */
+static constexpr uint32_t POLY = 0x82F63B78u;
+
+/** @brief Slice-by-8 lookup tables; t[0] is the classic byte table. */
+struct Tables { uint32_t t[8][256]; };
+
+constexpr Tables make_tables() {
+    Tables tb{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (POLY & (0u - (c & 1u)));
+        tb.t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i)
+        for (int s = 1; s < 8; ++s)
+            tb.t[s][i] = (tb.t[s - 1][i] >> 8) ^ tb.t[0][tb.t[s - 1][i] & 0xFF];
+    return tb;
+}
+
+inline constexpr Tables TABLES = make_tables();
+
+} // namespace crc
+
+/**
+ * @brief CRC-32C with the slice-by-8 tables; every other path must agree with it.
+ *
+ * @param p    Bytes to checksum.
+ * @param n    Number of bytes at @p p.
+ * @param crc  Result of the previous piece when checksumming in pieces (0 to start).
+ */
+inline uint32_t crc32c_table(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    const auto& t = crc::TABLES.t;
+    uint32_t c = ~crc;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; n >= 8; p += 8, n -= 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c;
+        c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+#endif
+    for (; n; --n) c = (c >> 8) ^ t[0][(c ^ *p++) & 0xFF];
+    return ~c;
+}
+
+#if defined(VIATEXT_CRC_X86)
+/** @brief SSE4.2 `crc32` path; only call when crc32c_hw() is true. */
+__attribute__((target("sse4.2")))
+inline uint32_t crc32c_sse42(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    uint64_t c = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        c = _mm_crc32_u64(c, w);
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    for (; n; --n) c32 = _mm_crc32_u8(c32, *p++);
+    return ~c32;
+}
+#elif defined(VIATEXT_CRC_ARM)
+/** @brief ARMv8 CRC extension path. */
+inline uint32_t crc32c_armv8(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    uint32_t c = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        c = __crc32cd(c, w);
+    }
+    for (; n; --n) c = __crc32cb(c, *p++);
+    return ~c;
+}
+#endif
+
+/** @brief True if crc32c() runs on a CRC instruction rather than the tables. */
+inline bool crc32c_hw() {
+#if defined(VIATEXT_CRC_X86)
+    static const bool ok = __builtin_cpu_supports("sse4.2");
+    return ok;
+#elif defined(VIATEXT_CRC_ARM)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief CRC-32C of @p p[0..n), on the fastest path this CPU has.
+ *
+ * Same contract as crc32c_table(), including piecewise use through @p crc.
+ */
+inline uint32_t crc32c(const uint8_t* p, size_t n, uint32_t crc = 0) {
+#if defined(VIATEXT_CRC_X86)
+    if (crc32c_hw()) return crc32c_sse42(p, n, crc);
+#elif defined(VIATEXT_CRC_ARM)
+    return crc32c_armv8(p, n, crc);
+#endif
+    return crc32c_table(p, n, crc);
+}
+
+} // namespace viatext
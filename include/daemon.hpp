@@ -0,0 +1,184 @@
+#pragma once
+/**
+ * @page vt-daemon ViaText Daemon (viatextd)
+ * @file daemon.hpp
+ * @brief One process owns every node's serial port; CLIs talk to it over a Unix socket.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * A serial port can only have one sane owner. Two `viatext-cli` calls on the
+ * same `/dev/ttyACM*` interleave frames and corrupt each other's reads, and
+ * every call pays its own open and readiness wait. The daemon opens each node
+ * once, keeps the fd, and runs every request for that node through a single
+ * queue. Clients (viatext-cli, dashboards, scripts) connect to a Unix domain
+ * socket and never touch the tty.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - run_daemon(): scan once (discover_nodes(), saved to nodes.json), listen
+ *   on the socket, and serve until SIGINT/SIGTERM.
+ *   - One worker thread and one request queue per device. The device is
+ *     opened on first use (open_node() or a fixed boot delay) and kept open;
+ *     a write failure closes it so the next request reopens.
+ *   - Requests to one device are serialized; requests to different devices
+ *     run concurrently, also when they come over the same connection.
+ *   - The daemon re-stamps each request with its own seq (1..0xEF, below the
+ *     readiness PINGs) and puts the client's seq back into the reply, so
+ *     clients can't collide on sequence numbers and late replies to a
+ *     timed-out request are discarded.
+ *   - An ID the daemon doesn't know triggers a probe of the ports it does
+ *     not own yet, never of its open ones, and only if devices were plugged
+ *     or unplugged since the last scan (device_epoch()); otherwise the answer
+ *     is node_not_found at once. The probe runs without the daemon lock, so
+ *     requests to open devices carry on meanwhile; concurrent lookups share
+ *     one probe.
+ *   - Reads of identity/config parameters are answered from a shared
+ *     ReplyCache while fresh (reply_cache.hpp); a SET through the daemon
+ *     invalidates the tags it wrote, a reopen drops the node's entries.
+ * - With DaemonOptions::metrics_port (--metrics <port>): collect stats.hpp
+ *   counters and histograms and serve them in Prometheus text format on
+ *   http://127.0.0.1:<port>/ (any path; loopback only).
+ * - Client helpers (used by viatext-cli as a thin client): daemon_connect(),
+ *   daemon_send() / daemon_recv(), daemon_request(), daemon_list().
+ *
+ * SOCKET PROTOCOL
+ * ---------------
+ * Text lines; frames travel as lowercase hex so the stream stays line-based:
+ *   client → daemon
+ *     req <tag> <target> <timeout_ms> <hex>   target: node ID, /dev path, or @auto
+ *     list <tag>
+ *   daemon → client
+ *     <tag> ok <hex> [<hex> ...]              one hex word per reply frame
+ *     <tag> error <reason>                    node_not_found, timeout, open_failed, ...
+ *     <tag> nodes <id>=<dev> ...              answer to list (online nodes)
+ * Replies carry the request's tag and may come back out of order (different
+ * devices finish at different times). `@auto` picks the only online node.
+ *
+ * OPERATIONAL NOTES
+ * -----------------
+ * - Socket: $XDG_RUNTIME_DIR/viatext/viatextd.sock (fallback
+ *   /run/user/<uid>/viatext/...), mode 0600. A stale socket file is replaced;
+ *   a live daemon on the same path makes the second one exit.
+ * - Start it as `viatext-cli --daemon`, or install a `viatextd` symlink to
+ *   the binary: invoked under that name the CLI runs as the daemon.
+ * - Node IDs must not contain spaces or '=' for `list` to round-trip.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   viatext-cli --daemon &
+ *   viatext-cli --node N3 --get rssi      # served by the daemon, no tty open
+ *   viatext-cli --nodes all --get vbat    # fan-out through the daemon
+ * @endcode
+ *
+ * @see fanout.hpp, node_registry.hpp, session.hpp, stats.hpp
+ */
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "node_registry.hpp"   // NodeInfo for daemon_list()
+
+namespace viatext {
+
+/** @brief Settings the daemon applies to every device it opens. */
+struct DaemonOptions {
+    int baud          = 115200;  /**< Line speed for every port. */
+    int boot_delay_ms = -1;      /**< -1: open_node() readiness wait; >=0: fixed open_serial() delay. */
+    int idle_gap_ms   = 200;     /**< GET_ALL: silence that ends a streamed snapshot. */
+    bool cache        = true;    /**< Answer read-mostly parameters from reply_cache.hpp. */
+    int metrics_port  = 0;       /**< >0: serve stats_prometheus() over HTTP on 127.0.0.1:<port>. */
+};
+
+
+/**
+ * @brief Extra wait a client adds on top of a request's timeout_ms: the
+ *        daemon may first have to open the device (readiness wait) or probe
+ *        for an unknown ID.
+ */
+inline constexpr int DAEMON_REPLY_MARGIN_MS = 4000;
+
+
+/** @brief Default socket path: <runtime dir>/viatext/viatextd.sock. */
+std::string daemon_socket_path();
+
+
+/**
+ * @brief Serve the socket API until SIGINT/SIGTERM.
+ *
+ * Parameters:
+ *   @param socket_path  Where to listen (see daemon_socket_path()).
+ *   @param opt          Open settings for the devices.
+ *   @param log          One line per lifecycle event (listen, device open/close).
+ *
+ * Returns:
+ *   @return 0 on a clean stop; 1 if the socket could not be set up (or
+ *           another daemon already listens on it).
+ */
+int run_daemon(const std::string& socket_path, const DaemonOptions& opt, std::ostream& log);
+
+
+/**
+ * @brief Connect to a running daemon.
+ * @return Socket fd, or -1 if nothing listens on @p socket_path.
+ */
+int daemon_connect(const std::string& socket_path);
+
+/** @brief Close a connection from daemon_connect() and drop its buffered input. */
+void daemon_close(int sock);
+
+
+/**
+ * @brief Queue one request on the daemon connection (does not wait).
+ *
+ * Parameters:
+ *   @param sock        From daemon_connect().
+ *   @param tag         Caller's handle; echoed in the reply.
+ *   @param target      Node ID, device path, or "@auto".
+ *   @param req         Encoded request frame (its seq is echoed back).
+ *   @param timeout_ms  Reply deadline the daemon applies on the serial side.
+ *
+ * @return false if the socket write failed.
+ */
+bool daemon_send(int sock, unsigned tag, const std::string& target,
+                 const std::vector<uint8_t>& req, int timeout_ms);
+
+
+/**
+ * @brief Wait for the next reply on the connection (any tag).
+ *
+ * Parameters:
+ *   @param sock        From daemon_connect().
+ *   @param tag         Receives the reply's tag.
+ *   @param frames      Receives the reply frames (empty on error).
+ *   @param err         Receives the daemon's error reason; empty on success.
+ *   @param timeout_ms  How long to wait for the line.
+ *
+ * @return true if a reply line arrived (check @p err); false on socket
+ *         failure or timeout.
+ */
+bool daemon_recv(int sock, unsigned& tag, std::vector<std::vector<uint8_t>>& frames,
+                 std::string& err, int timeout_ms);
+
+
+/**
+ * @brief daemon_send() + daemon_recv() for a single request.
+ *
+ * Waits up to @p timeout_ms + DAEMON_REPLY_MARGIN_MS for the answer.
+ *
+ * @return true if the daemon answered (check @p err); false on socket failure.
+ */
+bool daemon_request(int sock, const std::string& target, const std::vector<uint8_t>& req,
+                    int timeout_ms, std::vector<std::vector<uint8_t>>& frames, std::string& err);
+
+
+/**
+ * @brief Fetch the daemon's roster of online nodes.
+ * @return false on socket failure or a malformed answer.
+ */
+bool daemon_list(int sock, std::vector<NodeInfo>& nodes);
+
+} // namespace viatext
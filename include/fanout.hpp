@@ -0,0 +1,171 @@
+#pragma once
+/**
+ * @page vt-fanout ViaText Multi-Node Fan-Out
+ * @file fanout.hpp
+ * @brief Run one command on many nodes at once, tagging each result with its node.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * "Read rssi from every node" or "set freq on the whole fleet" used to be a
+ * shell loop over `--node`, run one after another, each run paying its own
+ * open, readiness wait and maybe a scan. Fan-out resolves every target from
+ * the registry once and talks to all of them concurrently, so wall time is
+ * the slowest node rather than the sum.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - select_targets() turns a `--nodes` spec into registry entries:
+ *     all            every online node
+ *     N1,N3          exact IDs
+ *     gw-*,relay-?   fnmatch(3) globs on the ID
+ *   Items may be mixed and are de-duplicated. A fresh nodes.json is used as
+ *   is; if it is stale, or an exact ID is not in it, one discover_nodes()
+ *   scan refreshes it (and is saved).
+ * - run_fanout() drives every target from one Reactor (serial_io.hpp):
+ *   open, the readiness wait (adaptive PINGs or the fixed delay, as for one
+ *   node, but as timers), write the same request, collect the reply (GET_ALL
+ *   collects the whole stream), close.
+ * - One line per node, printed as soon as that node finishes, tagged with
+ *   the node via tag_with_node() (`node=N3 status=ok ...`, a `"node"` key in
+ *   jsonl, a leading `node` column in csv).
+ *
+ * With a daemon running, run_fanout_remote() sends the same requests over
+ * its socket instead, and the daemon's per-device workers do the I/O.
+ *
+ * run_fanout_steps() is the same loop for a short conversation per node
+ * (read, decide, write, read back): a FanoutStep sees each reply and either
+ * hands back the node's next request, sent on the port that is already
+ * open, or writes the node's final line.
+ *
+ * One event loop rather than a thread per device: the waits that used to
+ * block a worker (readiness, reply, idle gap) are timers on the loop, so 64
+ * or more nodes cost one thread and one epoll set, and a node that needs its
+ * reset wait still doesn't hold up the others.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   viatext-cli --nodes all --get rssi
+ *   viatext-cli --nodes 'gw-*,N7' --set freq 915000000 --format jsonl
+ * @endcode
+ *
+ * @see node_registry.hpp, session.hpp (read_reply(), collect_reply())
+ */
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "node_registry.hpp"   // NodeInfo
+#include "output_format.hpp"   // OutputFormat for result lines
+
+namespace viatext {
+
+/** @brief I/O settings shared by every target of a fan-out. */
+struct FanoutOptions {
+    int baud          = 115200;  /**< Line speed for every port. */
+    int boot_delay_ms = -1;      /**< -1: open_node() readiness wait; >=0: fixed open_serial() delay. */
+    int timeout_ms    = 1500;    /**< Reply deadline per node. */
+    int idle_gap_ms   = 200;     /**< GET_ALL: silence that ends a streamed snapshot. */
+    OutputFormat fmt  = OutputFormat::Pretty;  /**< Rendering of each result line. */
+};
+
+
+/** @brief What a FanoutStep wants after a reply: another request, or the node is finished. */
+enum class StepNext : uint8_t {
+    Send,     /**< @p next holds the node's next request. */
+    Done,     /**< @p line is the node's result. */
+    Failed    /**< @p line is the node's result, and it counts as a failure. */
+};
+
+/**
+ * @brief Per-node decision of run_fanout_steps(), called after every reply.
+ *
+ * Parameters:
+ *   - node    Index into the targets vector.
+ *   - err     nullptr if the node answered; else the reason (timeout,
+ *             open_failed, write_failed, daemon_failed...). Only Done or
+ *             Failed make sense then.
+ *   - frames  The reply to the request just sent (GET_ALL: every frame).
+ *   - next    Send: the next request (its own seq).
+ *   - line    Done/Failed: the result line, before tag_with_node().
+ */
+using FanoutStep = std::function<StepNext(size_t node, const char* err,
+                                          const std::vector<std::vector<uint8_t>>& frames,
+                                          std::vector<uint8_t>& next, std::string& line)>;
+
+
+/**
+ * @brief Resolve a `--nodes` spec ("all", IDs, globs; comma-separated) to online nodes.
+ *
+ * Parameters:
+ *   @param spec     The selector, e.g. "all" or "N1,gw-*".
+ *   @param targets  Receives the matching online nodes (registry order, no duplicates).
+ *   @param missing  Receives every item that matched nothing (exact IDs and globs).
+ *
+ * Returns:
+ *   @return true if at least one target was selected.
+ */
+bool select_targets(const std::string& spec, std::vector<NodeInfo>& targets,
+                    std::vector<std::string>& missing);
+
+
+/**
+ * @brief Selection over a roster that is already known (e.g. daemon_list()).
+ *
+ * Same spec rules as select_targets(), but no registry load and no scan;
+ * items that match nothing (exact IDs included) land in @p missing.
+ */
+void match_targets(const std::string& spec, const std::vector<NodeInfo>& roster,
+                   std::vector<NodeInfo>& targets, std::vector<std::string>& missing);
+
+
+/**
+ * @brief Send @p req to every target concurrently and print one tagged line per node.
+ *
+ * Parameters:
+ *   @param targets  Nodes to talk to (each gets its own fd, all on one event loop).
+ *   @param req      Encoded request; the same frame goes to every node.
+ *   @param opt      Shared I/O settings and output format.
+ *   @param out      Destination; lines are written whole and flushed in
+ *                   completion order. Csv callers print `node,` + csv_header() first.
+ *
+ * Returns:
+ *   @return Number of nodes that did not answer (open/write failure or timeout).
+ */
+int run_fanout(const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+               const FanoutOptions& opt, std::ostream& out);
+
+
+/**
+ * @brief run_fanout() with a per-node conversation: @p req first, then whatever @p step asks for.
+ *
+ * Each node keeps its port open until @p step returns Done or Failed; its
+ * line is printed then. An I/O error ends the node's conversation through
+ * @p step as well.
+ *
+ * Returns:
+ *   @return Number of nodes that ended Failed.
+ */
+int run_fanout_steps(const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                     const FanoutStep& step, const FanoutOptions& opt, std::ostream& out);
+
+
+/**
+ * @brief run_fanout() through a running daemon (daemon.hpp) instead of opening ports.
+ *
+ * Every request is queued on @p sock at once and addressed by node ID; the
+ * daemon serves the devices in parallel. Output and return value as for
+ * run_fanout(); @p opt.baud and boot_delay_ms are the daemon's business.
+ */
+int run_fanout_remote(int sock, const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                      const FanoutOptions& opt, std::ostream& out);
+
+/** @brief run_fanout_steps() through a running daemon (each step is one more daemon request). */
+int run_fanout_steps_remote(int sock, const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                            const FanoutStep& step, const FanoutOptions& opt, std::ostream& out);
+
+} // namespace viatext
@@ -0,0 +1,187 @@
+#pragma once
+/**
+ * @page vt-link-guard ViaText Link Guard
+ * @file link_guard.hpp
+ * @brief CRC trailers and immediate resends for serial links that lose or flip bytes.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * On long USB runs and noisy hubs two things go wrong. A damaged reply the
+ * SLIP decoder rejects (bad escape) just vanishes, and the request costs a
+ * whole --timeout (1.5-2.5 s) before anyone notices. A damaged reply the
+ * decoder accepts is worse: it prints a wrong frequency or RSSI. The link
+ * guard sits between serial_io and its callers and turns both cases into
+ * an immediate resend of the request.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Trailers (commands.hpp Header Flags): each frame may end with a CRC-32C
+ *   of everything before it (crc32c.hpp, SSE4.2/ARMv8 when present). A
+ *   reply whose trailer doesn't match is dropped like a SLIP error.
+ * - Negotiation, per fd, with no round trip of its own:
+ *     Auto  requests carry FLAG_CRC_OK ("I check trailers") but no trailer.
+ *           A node that speaks CRC seals its reply; from then on requests
+ *           are sealed too, and a reply without a trailer counts as damaged.
+ *           Old firmware ignores the reserved byte and nothing changes.
+ *           With --boot-delay auto the readiness PING does the negotiating,
+ *           so the command itself already travels sealed.
+ *     On    requests are sealed from the first frame (firmware known to
+ *           take trailers; protects the very first request too).
+ *     Off   byte [1] stays 0, frames pass untouched, nothing is resent.
+ * - Fast resend: a request written is remembered (encoded, up to
+ *   LINK_OUTSTANDING per fd) while its reply is awaited: until the reply
+ *   arrives, the caller gives up (link_forget(); read_reply() does it on
+ *   timeout), or LINK_HOLD_MS pass. When a reply fails its CRC, the decoder
+ *   drops a damaged frame, or the node answers RESP_NACK (it got a request
+ *   whose trailer didn't match), every remembered request is written again
+ *   at once, at most LINK_RESENDS times each. Callers still match replies by
+ *   seq, so a duplicate answer is discarded like any stale reply; the
+ *   deadline they passed is unchanged.
+ * - Never replayed: a SET_PARAM/SET_ID once a newer SET to the same tag has
+ *   been written (the node would end on the older value), a readiness PING
+ *   once a newer PING went out, GET_ALL at all, and GET_LOG once its first
+ *   frame is in. A resent GET_ALL would arrive behind the rest of the damaged
+ *   stream under the same seq, with nothing to tell the two apart, so its
+ *   readers watch link_damage() instead and ask again under a new seq
+ *   (collect_reply(), the session pipeline, fan-out). GET_LOG records carry
+ *   their index: log_pull drops duplicates and re-asks what a range missed.
+ * - Counters (--stats): crc_errors (bad trailers seen here plus NACKs from
+ *   the node), resends (requests written again, streams asked again).
+ *
+ * WHERE IT APPLIES
+ * ----------------
+ * open_serial() guards every fd it opens with the process default
+ * (set_default_link_crc(), CLI --crc, default Auto); close_serial() drops
+ * it. write_frame()/write_frames()/read_frame() and the Reactor consult it
+ * on every frame, so one-shot commands, sessions, fan-out, the daemon, the
+ * poller and --get-log all get it. Fds that did not come from open_serial()
+ * (mock node ptys, sockets) are never guarded.
+ *
+ * THREADING
+ * ---------
+ * The table is mutex-guarded; one LinkGuard belongs to whoever owns its fd
+ * (same rule as read_frame()).
+ *
+ * @see commands.hpp (FLAG_CRC, crc_seal(), crc_check(), RESP_NACK),
+ *      crc32c.hpp, serial_io.hpp, mock_node.hpp (node side, --mock-corrupt)
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace viatext {
+
+/** @brief CRC trailer policy of one fd (see the table above). */
+enum class LinkCrc : uint8_t { Off, Auto, On };
+
+/** @brief Parse "auto", "on" or "off". */
+bool parse_link_crc(const std::string& s, LinkCrc& out);
+
+/** @brief Policy open_serial() gives every fd it opens from now on (default Auto). */
+void set_default_link_crc(LinkCrc mode);
+LinkCrc default_link_crc();
+
+/** @brief Times one request is written again after damage before it is left to its timeout. */
+inline constexpr int LINK_RESENDS = 2;
+
+/** @brief Unanswered requests remembered per fd; the oldest is forgotten first. */
+inline constexpr size_t LINK_OUTSTANDING = 16;
+
+/**
+ * @brief How long a request stays eligible for a resend when nobody retires it.
+ *
+ * Covers the default --timeout (1500 ms) with room to spare; a caller waiting
+ * longer just loses the fast resend for the rest of its wait.
+ */
+inline constexpr int LINK_HOLD_MS = 2500;
+
+
+/** @brief Link state of one guarded fd. */
+struct LinkGuard {
+    /** @brief One request on the wire without its (final) reply yet. */
+    struct Sent {
+        uint8_t seq = 0;
+        uint8_t verb = 0;
+        int resends = 0;                /**< times written again so far */
+        std::chrono::steady_clock::time_point until;   /**< LINK_HOLD_MS after the write */
+        std::vector<uint8_t> tags;      /**< SET_PARAM/SET_ID: the tags it writes */
+        std::vector<uint8_t> wire;      /**< SLIP-encoded, ready to write again */
+    };
+
+    int fd = -1;
+    LinkCrc mode = LinkCrc::Auto;
+    bool peer_crc = false;              /**< the node has sealed a reply: it speaks CRC */
+    uint32_t damage = 0;                /**< damaged frames, decoder drops and NACKs so far */
+    std::vector<Sent> sent;             /**< oldest first */
+    std::vector<uint8_t> sealed;        /**< outgoing() scratch; keeps its capacity */
+
+    /**
+     * @brief The bytes to SLIP-encode for request frame @p p.
+     *
+     * A copy with FLAG_CRC_OK set, sealed with a trailer once the peer speaks
+     * CRC (or the mode is On). Valid until the next call.
+     *
+     * @param n  In: length of @p p. Out: length of the returned frame.
+     */
+    const uint8_t* outgoing(const uint8_t* p, size_t& n);
+
+    /**
+     * @brief Remember a written request (@p frame as passed to outgoing(), @p wire as encoded).
+     *
+     * GET_ALL is not remembered. Drops what the new request
+     * supersedes (same seq, an older SET to one of its tags, an older PING)
+     * and anything past its hold time.
+     */
+    void remember(const uint8_t* frame, size_t n, const uint8_t* wire, size_t wn);
+
+    /** @brief Stop resending request @p seq: its caller has given up on it. */
+    void forget(uint8_t seq);
+
+    /**
+     * @brief Vet one decoded frame.
+     *
+     * @return true: deliver @p f (trailer stripped, its request retired once
+     *         complete). false: drop it (damaged or a NACK); call resend().
+     */
+    bool accept(std::vector<uint8_t>& f);
+
+    /**
+     * @brief Count one damage event and collect every remembered request
+     *        that is still within its hold time and has resends left.
+     *
+     * Called once per damaged frame, decoder drop or NACK.
+     *
+     * @return Number of requests in @p out (0: nothing to write).
+     */
+    size_t resend(std::vector<uint8_t>& out);
+};
+
+
+/** @brief Guard @p fd with the default policy (open_serial()); resets old state. */
+void link_open(int fd);
+
+/** @brief Forget @p fd (close_serial()). */
+void link_close(int fd);
+
+/** @brief Change the policy of an already guarded fd; negotiation starts over. */
+void set_link_crc(int fd, LinkCrc mode);
+
+/** @brief State of @p fd, or nullptr if it is not guarded or its policy is Off. */
+LinkGuard* link_guard(int fd);
+
+/** @brief LinkGuard::forget() on @p fd; no-op if it is not guarded. */
+void link_forget(int fd, uint8_t seq);
+
+/**
+ * @brief Damage events seen on @p fd so far (LinkGuard::damage; 0 if unguarded).
+ *
+ * A stream reader notes it before asking and compares once the stream ends:
+ * a change means a frame went missing somewhere, possibly in this stream.
+ */
+uint32_t link_damage(int fd);
+
+} // namespace viatext
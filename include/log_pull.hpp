@@ -0,0 +1,109 @@
+#pragma once
+/**
+ * @page vt-log-pull ViaText Log Download
+ * @file log_pull.hpp
+ * @brief Drain a node's stored log (TAG_LOG_COUNT entries) into a file over one open port.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * A node keeps thousands of log entries, and TAG_LOG_COUNT says how many.
+ * Reading them as one request per entry is one round trip each, plus a CLI
+ * start and a port open if done from a shell loop. GET_LOG asks for a range
+ * and the node streams the whole range back; keeping several ranges in
+ * flight hides the round trip entirely, so the link's bandwidth is the limit.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * run_log_pull():
+ *   1) Opens the output and finds the resume point: the index after the last
+ *      complete record already in the file (a torn last line is cut off).
+ *   2) Opens the port once and reads log_count (GET_PARAM TAG_LOG_COUNT).
+ *   3) Keeps up to `window` GET_LOG requests of `chunk` entries each on the
+ *      wire. Records are written as soon as they are next in order; ones
+ *      that arrive ahead of a gap wait in memory (at most window x chunk).
+ *   4) A range is done at its empty end frame. Entries of it still missing
+ *      then (lost frames) are asked again from the first missing one; so is
+ *      a range that stays silent for timeout_ms. Asking for index N is the
+ *      acknowledgement of everything before N; the node keeps no state.
+ *   5) After `retries` failed rounds in a row without progress, or on a
+ *      write error (unplugged), the port is closed and reopened (up to
+ *      `reopens` times, one second apart) and the transfer continues from
+ *      the first index not yet written.
+ *   6) Prints one summary line:
+ *        status=ok log_count=5000 from=0 written=5000 requests=157 retries=0 reopens=0 ms=912
+ *
+ * OUTPUT FILE
+ * -----------
+ * One record per line, in index order: `<index> <entry>`. The entry bytes
+ * are written as-is except `\` `\n` `\r` `\t` (escaped as `\\` `\n` `\r`
+ * `\t`) and other control bytes (`\xHH`), so every record stays on one line.
+ * The file is appended to in order and flushed after every completed range,
+ * so whatever is in it is a valid prefix: the next run (or a rerun after
+ * Ctrl-C) resumes after its last line. `-` writes to stdout (no resume).
+ *
+ * LIMITS
+ * ------
+ * - Indices are taken as stable: a node that drops old entries while being
+ *   drained (ring buffer wrap) shifts them, and this can't tell.
+ * - The reopen is on the same path; a node that comes back under another
+ *   /dev name is picked up by the next run (with --node) instead.
+ *
+ * @see commands.hpp (GET_LOG, TAG_LOG_*), session.hpp
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace viatext {
+
+/** @brief Transfer settings for run_log_pull(). */
+struct LogPullOptions {
+    long long from    = -1;      /**< First index; -1 = resume from the file (0 if new). >=0 truncates the file. */
+    int window        = 4;       /**< GET_LOG requests in flight (1..16). */
+    int chunk         = 64;      /**< Entries asked per request (1..1024). */
+    int timeout_ms    = 1500;    /**< Silence after which a range is asked again. */
+    int retries       = 5;       /**< Failed rounds in a row before the port is reopened. */
+    int reopens       = 3;       /**< Reopens before giving up. */
+    int baud          = 115200;  /**< Line speed, as for open_serial(). */
+    int boot_delay_ms = -1;      /**< -1: open_node() readiness wait; >=0: fixed open_serial() delay. */
+};
+
+
+/**
+ * @brief Index after the last complete record in @p path.
+ *
+ * A trailing partial line (a run killed mid-write) is truncated away, but
+ * only once the last complete line has been checked to be a record.
+ *
+ * Returns:
+ *   @return false if the file exists but can't be read or repaired, or is not
+ *           a record file (then it is left unchanged); @p next is 0 for a
+ *           missing or empty file.
+ */
+bool log_resume_point(const std::string& path, uint32_t& next);
+
+/** @brief Append one record as written to the output file (`<index> <escaped entry>\n`). */
+void format_log_record(uint32_t index, const uint8_t* entry, size_t len, std::string& out);
+
+
+/**
+ * @brief Download entries [resume point, log_count) of the node on @p dev into @p path.
+ *
+ * Parameters:
+ *   @param dev   Device path (already resolved).
+ *   @param path  Output file, or "-" for stdout.
+ *   @param opt   Range/window/recovery settings.
+ *   @param log   Summary or error line.
+ *
+ * Returns:
+ *   @return 0 when every entry is in the file; 1 on an open/file error or a
+ *           node refusing GET_LOG; 3 when the node stopped answering for
+ *           good (what arrived is kept; rerun to resume).
+ */
+int run_log_pull(const std::string& dev, const std::string& path, const LogPullOptions& opt,
+                 std::ostream& log);
+
+} // namespace viatext
@@ -0,0 +1,177 @@
+#pragma once
+/**
+ * @page vt-mock-node ViaText Mock Node
+ * @file mock_node.hpp
+ * @brief Emulated nodes on pseudo-terminals, for load and timing tests without radios.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * Every path above serial_io (discovery, fan-out, the Reactor, sessions, the
+ * daemon, the poller) needs a node on the other end of a tty. One physical
+ * radio on /dev/ttyACM0 can't show how 50 nodes behave, nor reproduce a slow
+ * or lossy link on demand. A mock node is a pty whose master side speaks the
+ * node protocol from the same definitions the host uses (commands.hpp TAG_*,
+ * param_table.hpp rows), so the host code under test can't tell it from a
+ * board.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - mock_open(): allocate a pty, keep the slave side open (so host opens and
+ *   closes never hang the master up), optionally link it to a stable path
+ *   (never over an existing file, device or live link),
+ *   and seed every parameter with a plausible value.
+ * - mock_answer(): the node itself, no I/O. Per request verb:
+ *     GET_ID      RESP_OK, TAG_ID
+ *     SET_ID      stores the new ID, RESP_OK echoing it
+ *     PING        RESP_OK, no TLVs
+ *     GET_PARAM   RESP_OK, one TLV per asked tag in asked order
+ *                 (empty value for a tag the table doesn't know)
+ *     SET_PARAM   range-checked against the param_table row; all or
+ *                 nothing: RESP_OK echoing the TLVs, or RESP_ERR
+ *     GET_ALL     every readable parameter, MockOptions::getall_per_frame
+ *                 TLVs per RESP_OK frame, then an empty end marker
+ *     GET_LOG     entries [from, from+max) clipped to log_count, as
+ *                 TAG_LOG_INDEX/TAG_LOG_ENTRY pairs packed into full
+ *                 frames, then an empty end marker; RESP_ERR without
+ *                 TAG_LOG_FROM/TAG_LOG_MAX. Entry i is a fixed function
+ *                 of i and the node ID, so two downloads compare equal.
+ *     other       RESP_ERR
+ *   `uptime` counts from mock_open(); rssi/snr/temp wander a little per read.
+ * - mock_attach(): serve one node on a Reactor, applying the link model:
+ *     latency + uniform jitter per request,
+ *     baud throttling (10 bit times per byte, request and reply, one
+ *       transfer at a time per node so back-to-back replies queue up),
+ *     frame loss (each reply frame dropped independently),
+ *     corruption (one random bit flipped, each request and each reply
+ *       frame independently).
+ *   and the firmware's side of frame CRCs (link_guard.hpp): a request with
+ *   FLAG_CRC_OK gets sealed replies, a request whose trailer does not match
+ *   gets RESP_NACK. MockOptions::crc = false plays older firmware that
+ *   ignores header byte [1] and never seals.
+ * - run_mock(): open N nodes, print one line per node, serve all of them on
+ *   one Reactor until SIGINT/SIGTERM, then print per-node counters:
+ *     event=mock_ready id=M0 dev=/dev/pts/7 link=/dev/ttyACM10
+ *     event=mock_summary id=M0 requests=1200 replies=1302 dropped=13 corrupted=25 nacks=11
+ *
+ * LIMITS
+ * ------
+ * - A pty has no DTR line, so the reset-on-open of a real board is not
+ *   emulated; readiness PINGs are answered from the first one.
+ * - The termios baud of the pty is ignored; only MockOptions::baud counts.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   # 50 nodes as /dev/ttyACM10..59 (discoverable by --scan), 20 ms ± 10 ms, 1% loss
+ *   viatext-cli --mock 50 --mock-link /dev/ttyACM --mock-first 10 \
+ *               --mock-latency 20 --mock-jitter 10 --mock-loss 1
+ *
+ *   # a noisy hub: 5% of frames damaged; compare --crc auto with --crc off
+ *   viatext-cli --mock 1 --mock-link /tmp/vt --mock-corrupt 5
+ * @endcode
+ *
+ * @see serial_io.hpp (Reactor), param_table.hpp, bench/roundtrip_bench.cpp
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace viatext {
+
+class Reactor;
+
+/** @brief How many nodes, what they are called, and how their link behaves. */
+struct MockOptions {
+    int count            = 1;      /**< Nodes to emulate (run_mock()). */
+    std::string link_prefix;       /**< Non-empty: symlink <prefix><first+i> to node i's pty. */
+    int first            = 0;      /**< Index of node 0 in IDs and link names. */
+    std::string id_prefix = "M";   /**< Node i answers GET_ID with <id_prefix><first+i>. */
+    int latency_ms       = 0;      /**< Fixed processing delay per request. */
+    int jitter_ms        = 0;      /**< Uniform extra delay 0..jitter_ms per request. */
+    int baud             = 0;      /**< Link speed to emulate; 0 = unthrottled. */
+    double loss_pct      = 0.0;    /**< Chance (0..100) that a reply frame is dropped. */
+    double corrupt_pct   = 0.0;    /**< Chance (0..100) that a frame, either way, has one bit flipped. */
+    bool crc             = true;   /**< Firmware speaks CRC trailers; false = older firmware. */
+    int getall_per_frame = 6;      /**< TLVs per GET_ALL frame (1..32). */
+    int log_entries      = 1000;   /**< log_count of every node run_mock() opens (0..65535). */
+    unsigned seed        = 0;      /**< Jitter/loss/corruption/telemetry RNG seed; 0 = random. */
+};
+
+/** @brief One emulated node: its pty and its parameter values. */
+struct MockNode {
+    int master = -1;                               /**< Served side (non-blocking). */
+    int slave  = -1;                               /**< Held open; never read. */
+    std::string pts;                               /**< /dev/pts/N the host opens. */
+    std::string link;                              /**< Symlink to pts, if any. */
+    std::map<uint8_t, std::vector<uint8_t>> values;  /**< tag -> value bytes as sent. */
+    std::chrono::steady_clock::time_point started;   /**< uptime origin */
+    std::chrono::steady_clock::time_point wire_free; /**< Link busy until then (baud model). */
+    uint64_t requests = 0;                         /**< Frames decoded from the host. */
+    uint64_t replies  = 0;                         /**< Frames sent back. */
+    uint64_t dropped  = 0;                         /**< Reply frames lost on purpose. */
+    uint64_t corrupted = 0;                        /**< Frames damaged on purpose (both ways). */
+    uint64_t nacks    = 0;                         /**< Requests refused for a bad trailer. */
+};
+
+
+/**
+ * @brief Create a node on a fresh pty.
+ *
+ * Parameters:
+ *   @param n     Filled: fds, pts path, seeded values, counters reset.
+ *   @param id    Value of TAG_ID.
+ *   @param link  Non-empty: symlink this path to the pty. Only a missing path or
+ *                a dangling symlink (left by a crashed mock) is taken over.
+ *
+ * Returns:
+ *   @return false if no pty could be allocated or the link could not be made;
+ *           errno = EEXIST when something else already lives at @p link.
+ */
+bool mock_open(MockNode& n, const std::string& id, const std::string& link = {});
+
+/** @brief Close both pty sides and remove the link, if it still points at this pty. */
+void mock_close(MockNode& n);
+
+
+/**
+ * @brief Run one request through the node; no I/O, no delays.
+ *
+ * Parameters:
+ *   @param n        Node whose values are read and written.
+ *   @param req      Decoded request frame ([verb][flags][seq][len][TLVs]); a
+ *                   CRC trailer behind the TLVs is ignored.
+ *   @param opt      Only getall_per_frame is used.
+ *   @param rng      Telemetry wander.
+ *   @param replies  Filled with the reply frames, in send order.
+ */
+void mock_answer(MockNode& n, const std::vector<uint8_t>& req, const MockOptions& opt,
+                 std::mt19937& rng, std::vector<std::vector<uint8_t>>& replies);
+
+
+/**
+ * @brief Serve @p n on @p r with the link model of @p opt.
+ *
+ * @p n, @p opt and @p rng must outlive the Reactor registration; the node is
+ * served until the Reactor removes its master fd.
+ *
+ * Returns:
+ *   @return false if the Reactor would not take the fd.
+ */
+bool mock_attach(Reactor& r, MockNode& n, const MockOptions& opt, std::mt19937& rng);
+
+
+/**
+ * @brief Emulate opt.count nodes until SIGINT/SIGTERM.
+ *
+ * Returns:
+ *   @return 0 after a clean stop, 1 if a node could not be created.
+ */
+int run_mock(const MockOptions& opt, std::ostream& out);
+
+} // namespace viatext
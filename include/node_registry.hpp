@@ -25,6 +25,8 @@
  *     * and whether it responded to probe (online flag).
  * - Provides helpers to:
  *     * Save that registry to disk (`nodes.json`) under `$HOME/.config/altgrid/viatext/`.
+ *     * Load it back as a cache and resolve an ID with one targeted probe instead of a
+ *       full scan (resolve_node()); the cache is invalidated when `/dev/serial/by-id` changes.
  *     * Create runtime symlinks under `$XDG_RUNTIME_DIR/viatext/` or `/run/user/<uid>/viatext/`
  *       such as `/run/viatext-node-N3` → `/dev/ttyACM0`. These symlinks provide stable handles
  *       for scripting and automation.
@@ -40,15 +42,18 @@
  * --------------------------
  * - No libudev dependency: everything is done with filesystem inspection and globbing, making it
  *   portable across Debian, Fedora, Arch, and similar distros.
- * - Probing costs time (~1 second per candidate). In exchange, we avoid misidentifying
- *   unrelated USB devices as ViaText nodes.
+ * - Probing costs time (~1.6 seconds worst case, per wave of 32). All candidates are opened
+ *   and probed concurrently over one poll() set, so the cost is paid once per scan rather
+ *   than once per device; ttys that show no sign of SLIP are dropped after 700 ms or less,
+ *   and known modems/GPS receivers are skipped by VID:PID without being opened. In exchange, we avoid misidentifying unrelated USB devices as ViaText nodes.
  * - If device detection fails, ViaText multi-node operation is crippled. For this reason,
  *   discovery and registry maintenance are considered a core reliability feature.
  *
  * OPERATIONAL NOTES
  * -----------------
  * - The registry JSON is simple and human-editable; it can be inspected offline in a bunker or
- *   during debugging. No external tools are required.
+ *   during debugging. No external tools are required. It is replaced atomically and only
+ *   when its content changes, so concurrent CLIs, the watcher and the daemon can share it.
  * - Symlinks in `/run` are ephemeral. They disappear on reboot; always regenerate them at startup.
  * - Users must have permission to access the device nodes (`dialout` group or similar).
  *
@@ -56,10 +61,11 @@
  * -------
  * @code
  *   // Discover devices
- *   auto nodes = viatext::discover_nodes();
+ *   long long epoch;
+ *   auto nodes = viatext::discover_nodes(&epoch);
  *
  *   // Persist results
- *   if (!viatext::save_registry(nodes)) {
+ *   if (!viatext::save_registry(nodes, epoch)) {
  *       std::cerr << "Failed to save node registry\n";
  *   }
  *
@@ -91,6 +97,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 namespace viatext {
 
@@ -113,16 +120,50 @@ struct NodeInfo {
     std::string id;       /**< Unique ViaText node ID reported by the device (e.g., "N3"). */
     std::string dev_path; /**< Absolute device path on Linux (e.g., "/dev/serial/by-id/usb-..."). */
     bool online;          /**< True if the node responded to probe during discovery. */
+    int ready_ms = -1;    /**< Learned open behavior: -1 unknown, 0 answers at once (no reset on
+                               open), >0 ms the node needed after open to answer (it resets). */
+    long long last_seen = 0; /**< Unix time (s) the node last answered a probe; 0 = never. */
+    int latency_us = -1;  /**< GET_ID round trip of that probe (write to reply); -1 = unknown. */
 };
 
 
+/**
+ * @brief List the serial devices discover_nodes() would probe, without opening any.
+ *
+ * Canonical paths of `/dev/serial/by-id` entries, or `/dev/ttyACM*` and
+ * `/dev/ttyUSB*` when by-id does not exist. Lets a process that already owns
+ * some ports (the daemon) probe only the others.
+ *
+ * USB devices that are known not to be nodes are left out by their VID:PID
+ * (from sysfs), so they are never opened: u-blox GNSS (1546:*) and Quectel,
+ * Sierra, Huawei and Telit modems (2c7c:*, 1199:*, 12d1:*, 1bc7:*), plus
+ * any pattern listed in `~/.config/altgrid/viatext/probe_skip`, one per line:
+ * @code
+ *   # onboard LTE modem and the bench GPS
+ *   05c6:9215
+ *   067b:*
+ * @endcode
+ */
+std::vector<std::string> candidate_devices();
+
+
 /**
  * @brief Discover ViaText nodes attached to this Linux host.
  *
  * Operation:
  *   - Scans candidate serial devices (preferring /dev/serial/by-id).
- *   - Probes each device by opening the port and issuing a GET_ID request.
- *   - Returns a vector of NodeInfo entries with id/dev_path/online set.
+ *   - Probes every device concurrently: all ports are opened together and
+ *     their GET_ID replies are read through a single poll() set. GET_ID is
+ *     sent right after open and re-sent every 100 ms to ports that have not
+ *     answered, so nodes that don't reset cost one round trip and nodes that
+ *     do are caught as soon as their firmware is up.
+ *   - The ID is read from the reply's TAG_ID TLV.
+ *   - Ports that can't be nodes are dropped early instead of holding the
+ *     scan for the full deadline: no SLIP END byte within 700 ms (silent
+ *     modems), over 256 bytes without one (GPS NMEA, AT banners), or our own
+ *     GET_ID echoed back.
+ *   - Returns a vector of NodeInfo entries with id/dev_path/online set;
+ *     ready_ms records whether each node reset on open (see NodeInfo).
  *
  * Why it matters:
  *   Downstream tools need a reliable roster before they can target nodes
@@ -133,20 +174,24 @@ struct NodeInfo {
  *     no nodes are connected or none responded within timeout.
  *
  * Side effects:
- *   - Opens serial ports briefly for probing.
+ *   - Opens serial ports briefly for probing (at most 32 at once; larger hosts
+ *     are probed in waves).
  *
  * Example:
  * @code
- *   auto nodes = viatext::discover_nodes();
+ *   long long epoch;
+ *   auto nodes = viatext::discover_nodes(&epoch);
  *   for (const auto& n : nodes) {
  *       std::cout << (n.online ? "[up]   " : "[down] ")
  *                 << n.id << " -> " << n.dev_path << "\n";
  *   }
  * @endcode
  *
+ * @param epoch Optional; receives the device_epoch() taken before the ports
+ *              were listed, the stamp to pass to save_registry().
  * @return List of discovered NodeInfo records.
  */
-std::vector<NodeInfo> discover_nodes();
+std::vector<NodeInfo> discover_nodes(long long* epoch = nullptr);
 
 
 /**
@@ -157,25 +202,189 @@ std::vector<NodeInfo> discover_nodes();
  *   so other tools and later sessions know what was found and where.
  *
  * Notes:
- *   - The JSON format is intentionally minimal so you can read/edit it by hand.
+ *   - The JSON format is intentionally minimal so you can read/edit it by hand:
+ *     one object per node per line, strings JSON-escaped.
  *   - Intended for Linux. Paths assume a typical $HOME layout.
+ *   - The file records `by_id_mtime` (mtime of /dev/serial/by-id, or /dev when
+ *     absent) so load_registry() can tell when devices were plugged/unplugged.
+ *   - Atomic: written to a temp file in the same directory, fsync'ed and
+ *     rename()d over nodes.json, so a reader sees the old or the new file,
+ *     never a torn one. Writers in different processes take an advisory
+ *     flock() on nodes.json.lock; readers take no lock.
+ *   - Incremental: an entry keeps the stored ready_ms of the same ID and
+ *     path unless reset vs no reset changed; one that doesn't carry
+ *     last_seen/latency (0/-1) keeps the stored ones; a last_seen within
+ *     REGISTRY_SEEN_SLACK_S of the stored one (latency within a quarter or 1 ms)
+ *     keeps the stored values. If the result is byte-for-byte the file on
+ *     disk, nothing is written.
  *
  * Failure modes:
- *   - Returns false if the config directory cannot be created or the file
- *     cannot be written.
+ *   - Returns false if the config directory cannot be created, the file
+ *     cannot be written, or another process held the lock for longer than
+ *     REGISTRY_LOCK_WAIT_MS (the snapshot is dropped; it is only a cache).
  *
  * Example:
  * @code
- *   auto nodes = viatext::discover_nodes();
- *   if (!viatext::save_registry(nodes)) {
+ *   long long epoch;
+ *   auto nodes = viatext::discover_nodes(&epoch);
+ *   if (!viatext::save_registry(nodes, epoch)) {
  *       std::cerr << "Could not save registry.\n";
  *   }
  * @endcode
  *
  * @param nodes The in-memory roster to serialize.
+ * @param epoch device_epoch() taken *before* the device list behind @p nodes
+ *              was read (discover_nodes() reports it), recorded as
+ *              `by_id_mtime`. A port plugged after that point then makes the
+ *              file stale instead of hiding behind a fresh stamp. Pass -1 for a
+ *              roster known to be incomplete: it is saved as stale.
  * @return true on success, false on error.
  */
-bool save_registry(const std::vector<NodeInfo>& nodes);
+bool save_registry(const std::vector<NodeInfo>& nodes, long long epoch);
+
+/** @brief save_registry(): freshness updates smaller than this don't rewrite the file. */
+inline constexpr int REGISTRY_SEEN_SLACK_S = 60;
+/** @brief save_registry(): how long a writer waits for another process's lock. */
+inline constexpr int REGISTRY_LOCK_WAIT_MS = 250;
+
+
+/**
+ * @brief Load nodes.json back as a cached roster.
+ *
+ * Purpose:
+ *   Lets a one-shot CLI call target a node without re-probing every port.
+ *
+ * Behavior:
+ *   - Parses the objects written by save_registry() in one pass, with JSON
+ *     string escapes (older bare-array files are read too, but always count
+ *     as stale). Unknown fields are ignored; missing ones keep NodeInfo's
+ *     defaults.
+ *   - Compares the recorded `by_id_mtime` with the current device directory
+ *     mtime; any plug/unplug since the save makes the cache stale.
+ *
+ * @param nodes Filled with the cached entries (also when stale).
+ * @return true if the file was read and is still fresh; false if it is
+ *         missing, unreadable, or stale.
+ */
+bool load_registry(std::vector<NodeInfo>& nodes);
+
+/**
+ * @brief Stamp of the current set of serial devices.
+ *
+ * The mtime (ns) of /dev/serial/by-id, or of /dev when that does not exist:
+ * udev touches it on every plug and unplug. A roster scanned at the same
+ * stamp is still current; nodes.json records it as `by_id_mtime`.
+ */
+long long device_epoch();
+
+
+/**
+ * @brief Probe one device for its node ID (a single targeted GET_ID).
+ *
+ * Costs one round trip (plus the node's boot time if it resets on open)
+ * instead of a full scan.
+ *
+ * @param dev_path Device to open and query.
+ * @return The reported ID, or an empty string if the device did not answer.
+ */
+std::string probe_node(const std::string& dev_path);
+
+
+/**
+ * @brief Probe several devices concurrently (one shared wave), without a directory walk.
+ *
+ * @param devs       Device paths to query.
+ * @param ready_ms   Optional; receives each device's NodeInfo::ready_ms
+ *                   (-1 where it did not answer), in the same order.
+ * @param latency_us Optional; receives each device's NodeInfo::latency_us
+ *                   (-1 where it did not answer), in the same order.
+ * @return Reported IDs in the same order as @p devs; empty string where a device did not answer.
+ */
+std::vector<std::string> probe_nodes(const std::vector<std::string>& devs,
+                                     std::vector<int>* ready_ms = nullptr,
+                                     std::vector<int>* latency_us = nullptr);
+
+
+/** @brief Unix time now (s), for NodeInfo::last_seen. */
+long long unix_now();
+
+
+/**
+ * Readiness PINGs (open_node(), and the fan-out's event loop which does the
+ * same wait without blocking):
+ * - READY_RETRY_MS: wait per PING before sending the next one.
+ * - READY_SEQ_BASE: readiness PINGs use seq 0xF0..0xFF; commands count up
+ *   from 1, so a late PING reply is never mistaken for a command reply.
+ * - READY_DEADLINE_MS: give up waiting; the caller's request goes out anyway.
+ */
+inline constexpr int READY_RETRY_MS      = 60;
+inline constexpr uint8_t READY_SEQ_BASE  = 0xF0;
+inline constexpr int READY_DEADLINE_MS   = 2000;
+
+/**
+ * @brief Open a node's port and wait only as long as the node actually needs.
+ *
+ * Replaces the fixed open_serial() boot delay:
+ *   - If nodes.json (fresh) says this device does not reset on open
+ *     (ready_ms == 0), the port is used immediately.
+ *   - Otherwise a PING is sent right after open and repeated every 60 ms
+ *     until one is answered or @p deadline_ms passes. Readiness PINGs use
+ *     seq 0xF0..0xFF and only the reply to the latest one counts, so a late
+ *     answer can never be taken for the caller's first reply.
+ *   - What was observed (answered at once, or only after a reset) is written
+ *     back to the device's registry entry when it differs from what was
+ *     stored, so the next open skips the wait.
+ *
+ * A node that never answers is not an error here: the fd is returned and the
+ * caller's own request times out as it would have.
+ *
+ * Safe to call for different devices from several threads at once (fan-out):
+ * registry updates are serialized within the process.
+ *
+ * @param dev         Device path (symlinks are matched by canonical path).
+ * @param baud        Line speed, as for open_serial().
+ * @param deadline_ms Upper bound on the readiness wait.
+ * @return fd (>=0) or -1 with errno set, exactly as open_serial().
+ */
+int open_node(const std::string& dev, int baud = 115200, int deadline_ms = READY_DEADLINE_MS);
+
+
+/**
+ * @brief What nodes.json (fresh) knows about @p dev's readiness, and updating it.
+ *
+ * learned_ready_ms() returns NodeInfo::ready_ms of the online entry for @p dev
+ * (0: no reset on open, >0: needed the wait), or -1 if unknown or stale.
+ * record_ready_ms() stores an observation the way open_node() does: only
+ * when it changes what was known, serialized within the process.
+ */
+int learned_ready_ms(const std::string& dev);
+void record_ready_ms(const std::string& dev, int ready_ms);
+
+
+/**
+ * @brief Resolve a node ID to its device path, cheapest source first.
+ *
+ * Order:
+ *   1) nodes.json entries for @p id, most recently seen first (then lowest
+ *      latency), each confirmed by probe_node() on that one path. A fresh
+ *      registry tries every such entry; a stale one (devices were plugged
+ *      since) only the most recent, since its path may be other hardware.
+ *   2) Full discover_nodes() scan as a last resort (result is saved, so the
+ *      next lookup is served from the cache again). Skipped when the registry
+ *      is fresh and has no entry for @p id: that is node_not_found at once.
+ *
+ * Example:
+ * @code
+ *   std::string dev;
+ *   if (!viatext::resolve_node("N3", dev)) { // not connected  }
+ * @endcode
+ *
+ * @param id        Node ID to look up.
+ * @param dev_path  Receives the device path on success.
+ * @param scanned   Optional; set to true if a full scan was needed.
+ * @return true if the node was found online.
+ */
+bool resolve_node(const std::string& id, std::string& dev_path, bool* scanned = nullptr);
 
 
 /**
@@ -210,4 +419,16 @@ bool save_registry(const std::vector<NodeInfo>& nodes);
 bool create_symlinks(const std::vector<NodeInfo>& nodes);
 
 
+/**
+ * @brief Remove the runtime alias for one node ID (inverse of create_symlinks()).
+ *
+ * Used when a node is unplugged or reports a different ID, so its alias does
+ * not outlive the device. A missing link is not an error.
+ *
+ * @param id Node ID whose `viatext-node-<id>` link should go.
+ * @return true if the link is gone afterwards.
+ */
+bool remove_symlink(const std::string& id);
+
+
 } // namespace vt
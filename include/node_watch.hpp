@@ -0,0 +1,65 @@
+#pragma once
+/**
+ * @page vt-node-watch ViaText Hot-Plug Watcher
+ * @file node_watch.hpp
+ * @brief Keep the node registry and runtime aliases live while radios come and go.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * On a host where radios are plugged and replugged all day, scanning on
+ * demand means every `--node` miss pays a full discovery. The watcher turns
+ * that around: one long-running process follows device hot-plug events and
+ * keeps `nodes.json` and the `viatext-node-<id>` aliases current, so one-shot
+ * `--node` calls resolve through the alias and never touch discover_nodes().
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Runs one discover_nodes() at startup to seed the roster, saves it, and
+ *   creates aliases for every online node.
+ * - Watches `/dev` with inotify for `ttyACM*` / `ttyUSB*` entries appearing,
+ *   disappearing, or changing attributes (udev fixes permissions right after
+ *   the kernel creates the node; `/dev/serial/by-id` links follow the same
+ *   tty and vanish with the directory when the last device goes).
+ * - Probes only the device that changed, after a short settle period that
+ *   also coalesces the burst of events one plug produces.
+ * - Updates the roster incrementally: new/changed nodes get fresh aliases,
+ *   removed ones lose theirs, and nodes.json is rewritten only on change.
+ * - Prints one line per roster change:
+ *     event=add id=<id> dev=<path> online=<0|1>
+ *     event=remove id=<id> dev=<path>
+ *
+ * OPERATIONAL NOTES
+ * -----------------
+ * - Stops cleanly on SIGINT/SIGTERM.
+ * - Must be able to open the devices it probes (dialout group or similar).
+ * - A node moved to another port shows up as an add on the new path; the
+ *   old entry is dropped so the alias follows the radio.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   viatext-cli --watch &          # keeps aliases current
+ *   viatext-cli --node N3 --get rssi
+ * @endcode
+ *
+ * @see node_registry.hpp
+ */
+
+#include <iosfwd>
+
+namespace viatext {
+
+/**
+ * @brief Follow serial hot-plug events until SIGINT/SIGTERM, keeping the registry live.
+ *
+ * Parameters:
+ *   @param out  Destination for one `event=...` line per roster change
+ *               (and the initial roster as `event=add` lines).
+ *
+ * Returns:
+ *   @return 0 on a clean stop; 1 if the inotify watch could not be set up.
+ */
+int watch_nodes(std::ostream& out);
+
+} // namespace viatext
@@ -0,0 +1,96 @@
+#pragma once
+/**
+ * @page vt-output-format ViaText Output Formats
+ * @file output_format.hpp
+ * @brief Machine-oriented renderings of node replies: JSON lines, CSV, raw hex.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * decode_pretty() produces `key=value` text for people and shell scripts.
+ * Collectors that ingest many replies should not have to regex that text
+ * back into numbers. This layer serializes the typed decode (NodeReply from
+ * commands.hpp) directly, or passes the raw frame bytes through as hex.
+ *
+ * FORMATS
+ * -------
+ * - pretty : decode_pretty() / decode_snapshot() text (default).
+ * - jsonl  : one JSON object per reply, only the fields the node sent:
+ *              {"status":"ok","seq":1,"freq_hz":915000000,"sf":7}
+ *            Keys match the pretty names. Numbers are JSON numbers (`cr` is
+ *            the denominator, so 5 means 4/5; `temp_c` has one decimal).
+ *            Unknown tags appear as "tagN":"<hex>".
+ * - csv    : fixed columns (see csv_header()); absent fields are empty cells.
+ *            Unknown tags go to the last column as `tagN=<hex>;...`.
+ * - raw    : the decoded frame bytes as lowercase hex; frames of a streamed
+ *            reply are separated by single spaces. No TLV parsing at all.
+ *
+ * Fan-out results carry their node: see tag_with_node().
+ *
+ * Errors that never reached the wire (bad input, timeouts) are rendered in
+ * the same format via format_error(), so a stream stays uniformly parseable
+ * (raw has no frame to dump and uses the pretty `status=error` line).
+ *
+ * COST
+ * ----
+ * Formatting appends into a caller-owned std::string with std::to_chars; no
+ * ostringstream, no locale, no flag juggling. Reusing one string across
+ * replies makes steady-state formatting allocation-free.
+ *
+ * @see commands.hpp (NodeReply, decode_reply())
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace viatext {
+
+/** @brief Selected rendering for reply lines. */
+enum class OutputFormat { Pretty, Jsonl, Csv, Raw };
+
+/**
+ * @brief Map a `--format` argument ("pretty", "jsonl", "csv", "raw") to an OutputFormat.
+ * @return false for an unknown name (@p fmt untouched).
+ */
+bool parse_output_format(const std::string& name, OutputFormat& fmt);
+
+/**
+ * @brief Column header line for OutputFormat::Csv (no trailing newline).
+ *
+ * Print once before the first row. Other formats have no header.
+ */
+const char* csv_header();
+
+/**
+ * @brief Append one reply, rendered in @p fmt, to @p out (no trailing newline).
+ *
+ * Parameters:
+ *   @param fmt    Output format.
+ *   @param frames The reply: one frame, or every frame of a streamed GET_ALL
+ *                 (merged like decode_snapshot()).
+ *   @param out    Destination; appended to, not cleared.
+ */
+void format_reply(OutputFormat fmt, const std::vector<std::vector<uint8_t>>& frames, std::string& out);
+
+/** @brief Single-frame convenience form of format_reply(). */
+void format_reply(OutputFormat fmt, const std::vector<uint8_t>& frame, std::string& out);
+
+/**
+ * @brief Append an error that has no reply frame (e.g. "timeout") in @p fmt.
+ *
+ * Pretty renders `status=error reason=<reason>`; @p seq > 0 adds ` seq=N`.
+ */
+void format_error(OutputFormat fmt, const std::string& reason, unsigned seq, std::string& out);
+
+/**
+ * @brief Mark a finished line (reply or error) with the node it came from.
+ *
+ * Used by multi-node fan-out (fanout.hpp):
+ *   - pretty / raw : `node=<id> ` is prepended,
+ *   - jsonl        : `"node":"<id>"` becomes the first key,
+ *   - csv          : a leading `node` cell; print `node,` before csv_header().
+ */
+void tag_with_node(OutputFormat fmt, const std::string& node, std::string& line);
+
+} // namespace viatext
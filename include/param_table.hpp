@@ -0,0 +1,275 @@
+#pragma once
+/**
+ * @page vt-param-table ViaText Parameter Table
+ * @file param_table.hpp
+ * @brief One constexpr table describing every parameter: names, tag, wire type, range, keys.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * Before this table the same knowledge lived in three places: the name chain
+ * in name_to_kind(), the 40-case builder switch in build_packet_from_kind(),
+ * and the tag switch in decode_pretty(). Each new parameter meant three edits
+ * that had to agree. Now a parameter is one row here, and
+ *   - name lookup  (CLI name or alias → row),
+ *   - building     (GET/SET frame, with range validation),
+ *   - decoding     (tag → key and wire type for pretty/jsonl/csv output)
+ * all read that row.
+ *
+ * LOOKUP COST
+ * -----------
+ * - Names: a compile-time sorted array of every name and alias, searched by
+ *   binary search over std::string_view after a stack-buffer lowercase.
+ *   No allocation, ~5 comparisons for the current vocabulary.
+ * - Tags:  a 256-entry compile-time index, tag → row, O(1).
+ * - Kinds: a compile-time index, CommandKind → row, O(1).
+ *
+ * ROW SEMANTICS
+ * -------------
+ * - `get_verb` / `set_verb`: the request verb for each direction. Most rows
+ *   use GET_PARAM / SET_PARAM; `id` uses the legacy GET_ID / SET_ID verbs;
+ *   `ping` and `all` are verb-only rows (tag 0). A set_verb of 0 means the
+ *   parameter is read-only.
+ * - `lo..hi` bounds SET values (inclusive) for integer types. `hint` is the
+ *   suffix of the error string, e.g. "(7..12)" in "bad_value:sf(7..12)".
+ * - `key` is the stable output name (`freq_hz=`, `"freq_hz":`); `display`
+ *   tweaks the pretty rendering (`cr=4/5`, `temp_c=23.5`).
+ * - `cache` is the lifetime class of a read value in the daemon/session
+ *   reply cache; the class → TTL mapping is in reply_cache.cpp.
+ *
+ * MAINTENANCE
+ * -----------
+ * - Adding a parameter: TAG_* in commands.hpp, a CommandKind pair in
+ *   command_dispatch.hpp, one row below, and a NodeReply field if typed
+ *   consumers need it. The static_asserts at the bottom catch duplicate names.
+ * - Rows may be in any order; the indices are derived at compile time.
+ *
+ * @see docs/add_parameter_steps.md
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "commands.hpp"           // verbs and TAG_* values
+#include "command_dispatch.hpp"   // CommandKind
+
+namespace viatext {
+
+/** @brief Encoding of a parameter's value on the wire. */
+enum class WireType : uint8_t { None, Str, U8, I8, U16, I16, U32 };
+
+/** @brief Pretty-print variant for a value (jsonl/csv print the plain number). */
+enum class Display : uint8_t { Plain, CrDen, Tenths };
+
+/**
+ * @brief How long a read value may be served from a cache (reply_cache.hpp).
+ *
+ * Identity changes only on SET (or a reflash), config only on SET, live
+ * readings drift; `None` is never cached (rssi/snr describe the last packet,
+ * uptime is always moving).
+ */
+enum class Cache : uint8_t { None, Live, Config, Identity };
+
+/** @brief One parameter (or verb-only command) row. */
+struct ParamDef {
+    std::string_view name;      /**< canonical CLI name, e.g. "freq" */
+    std::string_view alias;     /**< optional extra spelling, "" if none */
+    uint8_t  tag;               /**< TLV tag, 0 for verb-only rows */
+    WireType type;              /**< value encoding */
+    uint8_t  get_verb;          /**< request verb for reads, 0 if not readable */
+    uint8_t  set_verb;          /**< request verb for writes, 0 if read-only */
+    int64_t  lo, hi;            /**< inclusive SET range (integers) */
+    std::string_view key;       /**< output key, e.g. "freq_hz" */
+    std::string_view hint;      /**< bad_value suffix, e.g. "(7..12)" */
+    Display  display;           /**< pretty rendering tweak */
+    CommandKind get_kind;       /**< dispatcher kind for reads */
+    CommandKind set_kind;       /**< dispatcher kind for writes (= get_kind if read-only) */
+    Cache    cache;             /**< cache lifetime class for read values */
+};
+
+// One row per parameter. Keep the columns aligned; the table is meant to be read.
+inline constexpr ParamDef PARAMS[] = {
+//   name         alias          tag             type            get        set        lo     hi           key           hint          display           get_kind                          set_kind                          cache
+    {"id",        "",            TAG_ID,         WireType::Str,  GET_ID,    SET_ID,    0,     0,           "id",         "",           Display::Plain,   CommandKind::GET_ID,              CommandKind::SET_ID,              Cache::Identity},
+    {"ping",      "",            0,              WireType::None, PING,      0,         0,     0,           "",           "",           Display::Plain,   CommandKind::PING,                CommandKind::PING,                Cache::None},
+    {"alias",     "",            TAG_ALIAS,      WireType::Str,  GET_PARAM, SET_PARAM, 0,     0,           "alias",      "",           Display::Plain,   CommandKind::GET_ALIAS,           CommandKind::SET_ALIAS,           Cache::Identity},
+    {"fw",        "fw_version",  TAG_FW_VERSION, WireType::Str,  GET_PARAM, 0,         0,     0,           "fw",         "",           Display::Plain,   CommandKind::GET_FW_VERSION,      CommandKind::GET_FW_VERSION,      Cache::Identity},
+    {"uptime",    "uptime_s",    TAG_UPTIME_S,   WireType::U32,  GET_PARAM, 0,         0,     0xFFFFFFFF,  "uptime_s",   "",           Display::Plain,   CommandKind::GET_UPTIME_S,        CommandKind::GET_UPTIME_S,        Cache::None},
+    {"boot_time", "boot_time_s", TAG_BOOT_TIME,  WireType::U32,  GET_PARAM, 0,         0,     0xFFFFFFFF,  "boot_time",  "",           Display::Plain,   CommandKind::GET_BOOT_TIME_S,     CommandKind::GET_BOOT_TIME_S,     Cache::Identity},
+
+    {"freq",      "",            TAG_FREQ_HZ,    WireType::U32,  GET_PARAM, SET_PARAM, 0,     0xFFFFFFFF,  "freq_hz",    "",           Display::Plain,   CommandKind::GET_FREQ_HZ,         CommandKind::SET_FREQ_HZ,         Cache::Config},
+    {"sf",        "",            TAG_SF,         WireType::U8,   GET_PARAM, SET_PARAM, 7,     12,          "sf",         "(7..12)",    Display::Plain,   CommandKind::GET_SF,              CommandKind::SET_SF,              Cache::Config},
+    {"bw",        "",            TAG_BW_HZ,      WireType::U32,  GET_PARAM, SET_PARAM, 0,     0xFFFFFFFF,  "bw_hz",      "",           Display::Plain,   CommandKind::GET_BW_HZ,           CommandKind::SET_BW_HZ,           Cache::Config},
+    {"cr",        "",            TAG_CR,         WireType::U8,   GET_PARAM, SET_PARAM, 5,     8,           "cr",         "(5..8)",     Display::CrDen,   CommandKind::GET_CR_DEN,          CommandKind::SET_CR_DEN,          Cache::Config},
+    {"tx_pwr",    "pwr",         TAG_TX_PWR_DBM, WireType::I8,   GET_PARAM, SET_PARAM, -20,   23,          "tx_pwr_dbm", "(-20..23)",  Display::Plain,   CommandKind::GET_TX_PWR_DBM,      CommandKind::SET_TX_PWR_DBM,      Cache::Config},
+    {"chan",      "",            TAG_CHAN,       WireType::U8,   GET_PARAM, SET_PARAM, 0,     255,         "chan",       "",           Display::Plain,   CommandKind::GET_CHAN,            CommandKind::SET_CHAN,            Cache::Config},
+
+    {"mode",      "",            TAG_MODE,       WireType::U8,   GET_PARAM, SET_PARAM, 0,     255,         "mode",       "",           Display::Plain,   CommandKind::GET_MODE,            CommandKind::SET_MODE,            Cache::Config},
+    {"hops",      "",            TAG_HOPS,       WireType::U8,   GET_PARAM, SET_PARAM, 0,     255,         "hops",       "",           Display::Plain,   CommandKind::GET_HOPS,            CommandKind::SET_HOPS,            Cache::Config},
+    {"beacon",    "beacon_s",    TAG_BEACON_SEC, WireType::U32,  GET_PARAM, SET_PARAM, 0,     0xFFFFFFFF,  "beacon_s",   "",           Display::Plain,   CommandKind::GET_BEACON_S,        CommandKind::SET_BEACON_S,        Cache::Config},
+    {"buf_size",  "",            TAG_BUF_SIZE,   WireType::U16,  GET_PARAM, SET_PARAM, 0,     65535,       "buf_size",   "",           Display::Plain,   CommandKind::GET_BUF_SIZE,        CommandKind::SET_BUF_SIZE,        Cache::Config},
+    {"ack",       "",            TAG_ACK_MODE,   WireType::U8,   GET_PARAM, SET_PARAM, 0,     1,           "ack",        "(0|1)",      Display::Plain,   CommandKind::GET_ACK_MODE,        CommandKind::SET_ACK_MODE,        Cache::Config},
+
+    {"rssi",      "",            TAG_RSSI_DBM,   WireType::I16,  GET_PARAM, 0,         0,     0,           "rssi_dbm",   "",           Display::Plain,   CommandKind::GET_RSSI_DBM,        CommandKind::GET_RSSI_DBM,        Cache::None},
+    {"snr",       "",            TAG_SNR_DB,     WireType::I8,   GET_PARAM, 0,         0,     0,           "snr_db",     "",           Display::Plain,   CommandKind::GET_SNR_DB,          CommandKind::GET_SNR_DB,          Cache::None},
+    {"vbat",      "",            TAG_VBAT_MV,    WireType::U16,  GET_PARAM, 0,         0,     0,           "vbat_mv",    "",           Display::Plain,   CommandKind::GET_VBAT_MV,         CommandKind::GET_VBAT_MV,         Cache::Live},
+    {"temp",      "",            TAG_TEMP_C10,   WireType::I16,  GET_PARAM, 0,         0,     0,           "temp_c",     "",           Display::Tenths,  CommandKind::GET_TEMP_C,          CommandKind::GET_TEMP_C,          Cache::Live},
+    {"free_mem",  "",            TAG_FREE_MEM,   WireType::U32,  GET_PARAM, 0,         0,     0,           "free_mem",   "",           Display::Plain,   CommandKind::GET_FREE_MEM_B,      CommandKind::GET_FREE_MEM_B,      Cache::Live},
+    {"free_flash","",            TAG_FREE_FLASH, WireType::U32,  GET_PARAM, 0,         0,     0,           "free_flash", "",           Display::Plain,   CommandKind::GET_FREE_FLASH_B,    CommandKind::GET_FREE_FLASH_B,    Cache::Live},
+    {"log_count", "",            TAG_LOG_COUNT,  WireType::U16,  GET_PARAM, 0,         0,     0,           "log_count",  "",           Display::Plain,   CommandKind::GET_LOG_COUNT,       CommandKind::GET_LOG_COUNT,       Cache::Live},
+
+    {"all",       "get_all",     0,              WireType::None, GET_ALL,   0,         0,     0,           "",           "",           Display::Plain,   CommandKind::GET_ALL,             CommandKind::GET_ALL,             Cache::None},
+};
+
+inline constexpr size_t PARAM_COUNT = sizeof(PARAMS) / sizeof(PARAMS[0]);
+inline constexpr uint8_t NO_PARAM = 0xFF;   /**< "no row" marker in the indices below */
+
+
+// ------------------------- compile-time indices -------------------------
+
+/** @brief Directions a spelling is valid for (ParamName::dirs). */
+inline constexpr uint8_t DIR_GET = 0x01;
+inline constexpr uint8_t DIR_SET = 0x02;
+
+/** @brief One searchable spelling (name or alias) and the row it selects. */
+struct ParamName {
+    std::string_view name;
+    uint8_t row;
+    uint8_t dirs;   /**< DIR_GET | DIR_SET, before the row's read-only rule */
+};
+
+/**
+ * @brief Legacy one-way spellings: `get-id` only reads, `set-id` only writes.
+ *
+ * Kept out of the rows so a row stays one line; the entries point at rows by
+ * name and are resolved when the index is built.
+ */
+struct DirAlias {
+    std::string_view name;
+    std::string_view row_name;
+    uint8_t dirs;
+};
+
+inline constexpr DirAlias DIR_ALIASES[] = {
+    {"get-id", "id", DIR_GET},
+    {"set-id", "id", DIR_SET},
+};
+
+constexpr size_t param_name_count() {
+    size_t n = sizeof(DIR_ALIASES) / sizeof(DIR_ALIASES[0]);
+    for (const auto& p : PARAMS) n += 1 + !p.alias.empty();
+    return n;
+}
+
+/** @brief Every spelling, sorted for binary search (built at compile time). */
+constexpr std::array<ParamName, param_name_count()> make_param_names() {
+    std::array<ParamName, param_name_count()> a{};
+    size_t n = 0;
+    for (size_t i = 0; i < PARAM_COUNT; ++i) {
+        a[n++] = {PARAMS[i].name, static_cast<uint8_t>(i), DIR_GET | DIR_SET};
+        if (!PARAMS[i].alias.empty()) a[n++] = {PARAMS[i].alias, static_cast<uint8_t>(i), DIR_GET | DIR_SET};
+    }
+    for (const auto& d : DIR_ALIASES) {
+        for (size_t i = 0; i < PARAM_COUNT; ++i)
+            if (PARAMS[i].name == d.row_name) a[n++] = {d.name, static_cast<uint8_t>(i), d.dirs};
+    }
+    for (size_t i = 1; i < n; ++i) {                  // insertion sort: constexpr-friendly
+        for (size_t j = i; j > 0 && a[j].name < a[j - 1].name; --j) {
+            ParamName t = a[j]; a[j] = a[j - 1]; a[j - 1] = t;
+        }
+    }
+    return a;
+}
+
+inline constexpr auto PARAM_NAMES = make_param_names();
+
+constexpr bool param_names_unique() {
+    if (PARAM_NAMES[0].name.empty()) return false;            // a DIR_ALIASES row_name didn't resolve
+    for (size_t i = 1; i < PARAM_NAMES.size(); ++i)
+        if (PARAM_NAMES[i].name == PARAM_NAMES[i - 1].name) return false;
+    return true;
+}
+static_assert(param_names_unique(), "duplicate or unresolved parameter name/alias in PARAMS");
+
+/** @brief tag → row (NO_PARAM if the tag has no row). */
+constexpr std::array<uint8_t, 256> make_tag_index() {
+    std::array<uint8_t, 256> a{};
+    for (auto& v : a) v = NO_PARAM;
+    for (size_t i = 0; i < PARAM_COUNT; ++i)
+        if (PARAMS[i].tag) a[PARAMS[i].tag] = static_cast<uint8_t>(i);
+    return a;
+}
+
+inline constexpr auto PARAM_BY_TAG = make_tag_index();
+
+/** @brief CommandKind → row (every kind appears in exactly one row). */
+constexpr std::array<uint8_t, static_cast<size_t>(CommandKind::GET_ALL) + 1> make_kind_index() {
+    std::array<uint8_t, static_cast<size_t>(CommandKind::GET_ALL) + 1> a{};
+    for (auto& v : a) v = NO_PARAM;
+    for (size_t i = 0; i < PARAM_COUNT; ++i) {
+        a[static_cast<size_t>(PARAMS[i].get_kind)] = static_cast<uint8_t>(i);
+        a[static_cast<size_t>(PARAMS[i].set_kind)] = static_cast<uint8_t>(i);
+    }
+    return a;
+}
+
+inline constexpr auto PARAM_BY_KIND = make_kind_index();
+
+constexpr bool every_kind_has_row() {
+    for (auto v : PARAM_BY_KIND) if (v == NO_PARAM) return false;
+    return true;
+}
+static_assert(every_kind_has_row(), "a CommandKind has no row in PARAMS");
+
+
+// ------------------------------- lookups -------------------------------
+
+/**
+ * @brief Find the row for a CLI name or alias (case-insensitive) in one direction.
+ *
+ * @param name    CLI spelling, any case.
+ * @param is_set  true for a write: read-only rows and read-only spellings
+ *                ("get-id") don't match.
+ * @return Pointer into PARAMS, or nullptr if unknown for that direction.
+ */
+const ParamDef* find_param(std::string_view name, bool is_set);
+
+/** @brief Row for a TLV tag, or nullptr if the host doesn't know the tag. */
+inline const ParamDef* param_for_tag(uint8_t tag) {
+    const uint8_t i = PARAM_BY_TAG[tag];
+    return i == NO_PARAM ? nullptr : &PARAMS[i];
+}
+
+/** @brief Row for a dispatcher kind (never null for a valid enum value). */
+inline const ParamDef* param_for_kind(CommandKind kind) {
+    const size_t k = static_cast<size_t>(kind);
+    if (k >= PARAM_BY_KIND.size()) return nullptr;
+    const uint8_t i = PARAM_BY_KIND[k];
+    return i == NO_PARAM ? nullptr : &PARAMS[i];
+}
+
+/** @brief Number of rows that carry a TLV tag (the typed output columns). */
+constexpr size_t param_field_count() {
+    size_t n = 0;
+    for (const auto& p : PARAMS) n += p.tag != 0;
+    return n;
+}
+
+/**
+ * @brief Read a numeric TLV according to the row's wire type.
+ * @return false for string/verb rows or a length that doesn't match the type.
+ */
+inline bool param_value(const ParamDef& p, const TlvView& t, int64_t& v) {
+    switch (p.type) {
+        case WireType::U8:  { uint8_t  x; if (!t.as_u8(x))  return false; v = x; return true; }
+        case WireType::I8:  { int8_t   x; if (!t.as_i8(x))  return false; v = x; return true; }
+        case WireType::U16: { uint16_t x; if (!t.as_u16(x)) return false; v = x; return true; }
+        case WireType::I16: { int16_t  x; if (!t.as_i16(x)) return false; v = x; return true; }
+        case WireType::U32: { uint32_t x; if (!t.as_u32(x)) return false; v = x; return true; }
+        default:            return false;
+    }
+}
+
+} // namespace viatext
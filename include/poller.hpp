@@ -0,0 +1,106 @@
+#pragma once
+/**
+ * @page vt-poller ViaText Telemetry Poller
+ * @file poller.hpp
+ * @brief Sample health parameters on a fixed schedule, one batched read per node per slot.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * Polling rssi/snr/vbat/temp from cron means one process per sample, each
+ * paying open + readiness, one GET_PARAM per tag, and cron's whole-minute
+ * jitter. The poller stays running, keeps each link open, and reads every
+ * tag that is due on a node in a single multi-TLV GET_PARAM.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Groups: each `--poll <interval> <tags>` is one PollGroup, e.g. rssi,snr
+ *   every 5 s and vbat,temp every 60 s. Whenever several groups are due on
+ *   a node at once, their tags are merged (de-duplicated) into one request.
+ * - Spreading: node i of N starts at i/N of the shortest interval, so N
+ *   nodes on one USB hub are read one after another instead of all in the
+ *   same millisecond; intervals that are multiples of the shortest stay in
+ *   step and keep coalescing.
+ * - One thread per node: its link is opened once and kept;
+ *   a failed open or write is retried at the next slot. With a daemon
+ *   running, each thread uses its own socket connection instead of a tty.
+ * - Samples: one line per poll, appended to the sample stream:
+ *     <epoch_ms> <node> rssi_dbm=-92 snr_db=7 vbat_mv=3711
+ *     <epoch_ms> <node> status=error reason=timeout
+ *   Values use the pretty keys (decode_pretty()), without status/seq.
+ * - Deadlines: a poll gets at most the shortest interval as its timeout, so
+ *   it never runs into its own next slot. A slot that could not start on
+ *   time (previous poll or open still running past it) is skipped and
+ *   counted as missed; timeouts are counted separately. Counters are
+ *   printed per node on stop:
+ *     event=poll_summary node=N3 polls=120 ok=119 timeouts=1 missed=0
+ *
+ * Runs until SIGINT/SIGTERM.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   viatext-cli --nodes all --poll 5s rssi,snr --poll 1m vbat,temp --poll-out /var/log/vt.ts
+ * @endcode
+ *
+ * @see fanout.hpp, daemon.hpp, commands.hpp (make_get_params())
+ */
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "node_registry.hpp"   // NodeInfo
+
+namespace viatext {
+
+/** @brief Tags sampled together at one interval. */
+struct PollGroup {
+    int interval_ms = 0;          /**< Period between samples. */
+    std::vector<uint8_t> tags;    /**< TAG_* values read each period. */
+};
+
+/** @brief Link settings for every polled node. */
+struct PollOptions {
+    int baud          = 115200;  /**< Line speed (direct links). */
+    int boot_delay_ms = -1;      /**< -1: open_node() readiness wait; >=0: fixed open_serial() delay. */
+    int timeout_ms    = 1500;    /**< Reply deadline, capped at the shortest interval. */
+    std::string daemon_socket;   /**< Non-empty: talk to viatextd on this socket instead of the ttys. */
+};
+
+
+/**
+ * @brief Parse one `--poll <interval> <tags>` pair.
+ *
+ * Parameters:
+ *   @param interval  "250ms", "5s", "2m", or plain seconds ("10"); 100 ms minimum.
+ *   @param tags      Comma-separated readable parameter names ("rssi,snr,vbat").
+ *   @param g         Filled on success.
+ *   @param err       "bad_value:poll_interval" or "unknown_get:<name>" on failure.
+ *
+ * Returns:
+ *   @return true if both parts are valid.
+ */
+bool parse_poll_group(const std::string& interval, const std::string& tags,
+                      PollGroup& g, std::string& err);
+
+
+/**
+ * @brief Sample @p groups on every target until SIGINT/SIGTERM.
+ *
+ * Parameters:
+ *   @param targets  Nodes to poll (the label in the samples is the ID, or
+ *                   the device path when the ID is empty).
+ *   @param groups   At least one group.
+ *   @param opt      Link settings.
+ *   @param samples  Time-series destination; each line written whole and flushed.
+ *   @param log      Destination for the per-node summary lines.
+ *
+ * Returns:
+ *   @return Number of nodes that never answered a poll.
+ */
+int run_poll(const std::vector<NodeInfo>& targets, const std::vector<PollGroup>& groups,
+             const PollOptions& opt, std::ostream& samples, std::ostream& log);
+
+} // namespace viatext
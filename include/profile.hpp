@@ -0,0 +1,114 @@
+#pragma once
+/**
+ * @page vt-profile ViaText Configuration Profiles
+ * @file profile.hpp
+ * @brief `--apply profile.conf`: bring many nodes to one radio profile, touching only what differs.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * Rolling a new radio plan (freq/sf/bw/cr/tx_pwr/chan) out to a fleet used
+ * to be one `--set` per parameter per node: a port open and a readiness wait
+ * each, and no check whether the node already had the value. A profile is
+ * the wanted end state; applying it reads what each node has, writes only
+ * the difference in one frame, and reads it back.
+ *
+ * PROFILE FILE
+ * ------------
+ * One `name = value` (or `name value`) per line, names and values as for
+ * `--set`; blank lines and `#` comments are skipped:
+ * @code
+ *   # 915 MHz plan B
+ *   freq   = 915000000
+ *   sf     = 9
+ *   bw     = 125000
+ *   cr     = 5
+ *   tx_pwr = 14
+ *   chan   = 3
+ * @endcode
+ * Every value is range-checked when the file is read, so a typo stops the
+ * run before any node is touched. A name given twice is an error. Only
+ * SET_PARAM parameters (not `id`) may appear, and the whole profile must
+ * fit one SET_PARAM frame.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * run_apply(), per node, all nodes concurrently (run_fanout_steps(), one
+ * open port per node):
+ *   1) snapshot  one GET_PARAM for every profile tag. Through the daemon
+ *                this is answered from its reply cache while fresh
+ *                (config values: 5 min), so often no radio traffic at all.
+ *   2) diff      a tag whose bytes already equal the profile's is left
+ *                alone. Nothing differs: the node is done.
+ *   3) set       one SET_PARAM with only the differing tags (all or
+ *                nothing on the node side).
+ *   4) verify    one GET_PARAM of those tags (the SET dropped them from any
+ *                cache, so this reaches the node) compared with the profile.
+ *   One line per node:
+ *     node=N3 status=ok changed=sf:7>9,bw:250000>125000 unchanged=4
+ *     node=N4 status=ok changed=none unchanged=6
+ *     node=N5 status=error reason=set_refused:tx_pwr changed=none unchanged=5
+ *     node=N6 status=error reason=verify_failed:sf changed=sf:7>9 unchanged=5
+ *     node=N7 status=error reason=timeout step=set changed=sf:7>9 unchanged=5
+ *   `step=set` after an error means the SET may or may not have been
+ *   applied; rerun to find out (it only writes what still differs).
+ *
+ * @see fanout.hpp (run_fanout_steps()), command_dispatch.hpp (build_param_set_batch()),
+ *      reply_cache.hpp
+ */
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "fanout.hpp"          // FanoutOptions, NodeInfo
+
+namespace viatext {
+
+/** @brief One `name = value` line of a profile, checked and encoded. */
+struct ProfileItem {
+    std::string name;             /**< canonical parameter name ("tx_pwr") */
+    std::string value;            /**< as written in the file */
+    uint8_t tag = 0;              /**< TLV tag */
+    std::vector<uint8_t> tlv;     /**< [tag][len][value...] exactly as a SET sends it */
+};
+
+/** @brief A parsed profile, in file order. */
+using Profile = std::vector<ProfileItem>;
+
+
+/**
+ * @brief Read and validate a profile.
+ *
+ * Parameters:
+ *   @param in    Profile text.
+ *   @param prof  Filled in file order.
+ *   @param err   On failure: `<reason> line=<n>`, reason as for `--set`
+ *                (`unknown_set:foo`, `bad_value:sf(7..12)`, `not_batchable:id`),
+ *                or `profile_duplicate:<name>`, `profile_empty`, `batch_too_large`.
+ *
+ * Returns:
+ *   @return true if every line is valid and the profile fits one frame.
+ */
+bool parse_profile(std::istream& in, Profile& prof, std::string& err);
+
+
+/**
+ * @brief Apply @p prof to every target concurrently; one result line per node.
+ *
+ * Parameters:
+ *   @param targets      Nodes to configure (IDs only are enough with a daemon).
+ *   @param prof         From parse_profile().
+ *   @param opt          I/O settings; only the pretty format is produced.
+ *   @param daemon_sock  >= 0: go through the daemon on this connection
+ *                       (and its cache); < 0: open the ports directly.
+ *   @param out          Result lines, in completion order.
+ *
+ * Returns:
+ *   @return Number of nodes that failed (I/O error, refusal or verify mismatch).
+ */
+int run_apply(const std::vector<NodeInfo>& targets, const Profile& prof, const FanoutOptions& opt,
+              int daemon_sock, std::ostream& out);
+
+} // namespace viatext
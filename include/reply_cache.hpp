@@ -0,0 +1,125 @@
+#pragma once
+/**
+ * @page vt-reply-cache ViaText Reply Cache
+ * @file reply_cache.hpp
+ * @brief Serve read-mostly parameters from memory instead of the radio link.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * `fw`, `id`, `alias`, `boot_time` and the radio config (`freq`, `sf`, `bw`,
+ * ...) only change when someone sets them, yet every dashboard refresh used
+ * to read them over the serial link again. The daemon and session mode keep
+ * the last value of each (node, tag) and answer from it while it is fresh.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Every parameter row carries a lifetime class (ParamDef::cache):
+ *     Identity  id, alias, fw, boot_time            10 min
+ *     Config    freq, sf, bw, cr, tx_pwr, chan,
+ *               mode, hops, beacon, buf_size, ack     5 min
+ *     Live      vbat, temp, free_mem, free_flash,
+ *               log_count                             2 s
+ *     None      rssi, snr, uptime                     never cached
+ * - cache_lookup(): for GET_ID / GET_PARAM, collects the fresh values. If
+ *   every asked tag is fresh, the whole reply is built from the cache; if
+ *   only some are, the request is narrowed to the missing tags.
+ * - cache_update(): after the node answered, stores every cacheable TLV of
+ *   a RESP_OK (GET_ID, GET_PARAM and GET_ALL replies all feed it), merges the
+ *   cached part back into a narrowed reply, and drops the entries a
+ *   SET_PARAM / SET_ID touched (whatever the outcome, since a failed SET
+ *   leaves the value unknown).
+ * - cache_forget(): drops everything about one node (device reopened, maybe
+ *   replugged or rebooted).
+ *
+ * A read that was looked up before a SET to the same node (pipelined
+ * session: `get sf`, then `set sf 9`, both on the wire) may carry the old
+ * value; its reply is passed through but not stored.
+ *
+ * A cached reply looks exactly like a real one (RESP_OK, the request's seq,
+ * one TLV per asked tag, in the order they were asked), so nothing
+ * downstream can tell the difference.
+ *
+ * THREADING
+ * ---------
+ * One ReplyCache may be shared by several device workers; every function
+ * takes its mutex.
+ *
+ * @see param_table.hpp (Cache column), daemon.hpp, session.hpp
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace viatext {
+
+/** @brief Last known values, keyed by (node, tag). */
+struct ReplyCache {
+    struct Entry {
+        std::vector<uint8_t> tlv;                       /**< [tag][len][value...] as the node sent it */
+        std::chrono::steady_clock::time_point expires;  /**< stale from this point on */
+    };
+    std::map<std::pair<std::string, uint8_t>, Entry> entries;
+    std::map<std::string, uint64_t> writes;   /**< per node: SETs seen so far */
+    std::mutex mu;
+    uint64_t hits   = 0;   /**< tags answered from the cache */
+    uint64_t misses = 0;   /**< cacheable tags that had to go to the node */
+};
+
+/** @brief Result of cache_lookup(): what was answered and what still has to be sent. */
+struct CacheLookup {
+    std::vector<uint8_t> cached;  /**< TLV bytes answered from the cache */
+    std::vector<uint8_t> fetch;   /**< request to send; empty when @ref reply is complete */
+    std::vector<uint8_t> reply;   /**< full RESP_OK frame when everything was cached */
+    uint64_t writes = 0;          /**< node's SET count at lookup time */
+};
+
+/** @brief Lifetime of a cached value for @p tag in ms (0: never cached). */
+int cache_ttl_ms(uint8_t tag);
+
+
+/**
+ * @brief Answer (part of) a request from the cache.
+ *
+ * Parameters:
+ *   @param c     Shared cache.
+ *   @param node  Node key (ID, or device path when the ID is unknown).
+ *   @param req   Encoded request about to be sent.
+ *   @param lk    Filled: @ref CacheLookup::reply if fully served, otherwise
+ *                @ref CacheLookup::fetch (= @p req, or narrowed to the
+ *                missing tags with the same seq).
+ *
+ * Returns:
+ *   @return true if @p lk.reply answers the request and nothing must be sent.
+ */
+bool cache_lookup(ReplyCache& c, const std::string& node, const std::vector<uint8_t>& req,
+                  CacheLookup& lk);
+
+
+/**
+ * @brief Learn from a reply and complete it for the original request.
+ *
+ * Parameters:
+ *   @param c       Shared cache.
+ *   @param node    Same key as for cache_lookup().
+ *   @param req     The original request (before narrowing).
+ *   @param lk      From cache_lookup() for @p req.
+ *   @param frames  The node's reply frames to lk.fetch; a narrowed single
+ *                  RESP_OK gets the cached TLVs merged back in.
+ *
+ * For a SET only @p req matters: call it when the SET is sent if reads to
+ * the same node can be in flight behind it, otherwise once it is answered.
+ */
+void cache_update(ReplyCache& c, const std::string& node, const std::vector<uint8_t>& req,
+                  const CacheLookup& lk, std::vector<std::vector<uint8_t>>& frames);
+
+
+/** @brief Drop every entry of @p node. */
+void cache_forget(ReplyCache& c, const std::string& node);
+
+} // namespace viatext
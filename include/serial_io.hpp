@@ -15,9 +15,13 @@
  * ---------------
  * - viatext::open_serial: acquire a file descriptor to a TTY, set raw mode, and
  *   absorb the usual boot noise after device reset.
- * - viatext::write_frame: SLIP-encode one payload and write it as a single frame.
+ * - viatext::write_frame: SLIP-encode one payload and write it as a single frame,
+ *   riding out partial writes and a full TX buffer up to a deadline.
+ * - viatext::write_frames: the same for several frames in one write (pipelining).
  * - viatext::read_frame: poll and accumulate bytes until a full SLIP frame is decoded.
  * - viatext::close_serial: close the descriptor cleanly.
+ * - viatext::Reactor: one epoll loop for many fds at once (per-fd decoder,
+ *   write queue and timers), so fan-out needs no thread per device.
  *
  * These functions are used by:
  * - viatext-cli: one-shot send/receive from shell scripts or other programs.
@@ -26,7 +30,8 @@
  *
  * DESIGN CHOICES
  * --------------
- * - Simplicity: free functions, no class hierarchy, no hidden threads.
+ * - Simplicity: free functions, no class hierarchy, no hidden threads. The
+ *   Reactor is the one class: it owns an epoll set and runs on the caller's thread.
  * - Portability: relies on POSIX termios and poll. Runs on laptops, Pi, thin clients.
  * - Autonomy: no manager process required. Your process opens the port and talks.
  *
@@ -42,8 +47,8 @@
  *   with explicit access.
  * - Timeouts: read_frame uses poll with a millisecond timeout. A false return can mean a
  *   clean timeout, or an underlying poll/read error. Upper layers decide how to retry.
- * - Framing: SLIP provides boundaries only. If you need integrity or receipts, add them
- *   at the ViaText message layer.
+ * - Framing: SLIP provides boundaries only. Integrity is the optional CRC-32C trailer of
+ *   link_guard.hpp (--crc), applied inside write_frame/read_frame on guarded fds.
  *
  * EXAMPLE
  * -------
@@ -54,7 +59,7 @@
  *
  *   std::vector<uint8_t> payload = {'p','i','n','g'};
  *   if (!write_frame(fd, payload)) {
- *       // handle write failure (fd may be invalid or output buffer full)
+ *       // handle write failure (fd invalid, device gone, or TX stalled past the deadline)
  *   }
  *
  *   std::vector<uint8_t> frame;
@@ -69,18 +74,22 @@
  *
  * LIMITATIONS AND TRADE-OFFS
  * --------------------------
- * - Baud table: the implementation maps a small set of common baud rates to termios speeds.
- *   Unknown values fall back to 115200. Extend as needed for your hardware.
- * - Atomic writes: write_frame attempts to write the entire encoded frame in one call.
- *   If only a partial write occurs, it returns false rather than looping. This keeps the
- *   code small and predictable. For very large frames or very small driver buffers, add a
- *   higher-layer retry or a looping writer.
+ * - Baud rates: standard rates go through their termios constant, any other positive
+ *   rate through termios2/BOTHER. A rate the driver refuses, or sets more than 3% off,
+ *   fails open_serial() with errno EINVAL; nothing falls back to 115200 behind your back.
+ * - Writes: write_frame/write_frames keep writing after a short write and wait for
+ *   POLLOUT while the driver's TX buffer is full, until every byte is out or
+ *   WRITE_TIMEOUT_MS (or the caller's timeout) passes. A false return means the
+ *   deadline passed or the fd failed; part of the frame may already be on the wire.
  * - Concurrency: do not share a single fd between threads without external synchronization.
  *
  * DEPENDENCIES
  * ------------
  * - serial_io.cpp: termios configuration, poll loop, and syscalls.
+ * - serial_reactor.cpp: the Reactor (epoll, eventfd).
  * - slip.hpp: SLIP encoder and bytewise decoder.
+ * - stats.hpp: open/boot_delay/flush/write/first_byte/frame timings and byte,
+ *   frame, SLIP-error and retry counters, recorded here when --stats is on.
  *
  * MAINTENANCE
  * -----------
@@ -93,6 +102,10 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 
 namespace viatext {
 
@@ -102,7 +115,11 @@ namespace viatext {
  * What it does:
  *   - Opens the device path (e.g., "/dev/ttyACM0") with O_RDWR | O_NOCTTY | O_NONBLOCK.
  *   - Puts the port into "raw" mode (8N1, no echo, no line processing).
- *   - Sets the baud rate using a small internal mapping (9600..230400; otherwise 115200).
+ *   - Sets the baud rate: standard rates (1200..4000000, including 460800, 921600,
+ *     2000000) via their termios constant, any other positive rate via
+ *     termios2/BOTHER (see set_custom_baud()).
+ *   - Enables low-latency mode on usb-serial bridges when the driver supports it
+ *     (see set_low_latency()).
  *   - Waits briefly after open to let USB CDC ACM devices finish their auto-reset.
  *   - Flushes any boot chatter from the driver buffers.
  *
@@ -111,13 +128,19 @@ namespace viatext {
  *
  * Parameters:
  *   @param dev            Absolute device path, e.g. "/dev/serial/by-id/usb-..." or "/dev/ttyACM0".
- *   @param baud           Requested baud rate (common values supported: 9600, 19200, 38400,
- *                         57600, 115200 (default), 230400). Unknown values fall back to 115200.
+ *   @param baud           Requested baud rate, e.g. 115200 (default), 921600, 2000000, or a
+ *                         custom rate such as 250000. Never silently replaced.
  *   @param boot_delay_ms  Milliseconds to sleep after opening before first I/O
  *                         (typical 200–500 ms for USB CDC auto-reset). Default: 400 ms.
+ *                         0 skips the wait; node_registry's open_node() uses that and
+ *                         PINGs the node until it answers instead.
  *
  * Returns:
- *   @return File descriptor (non-negative) on success, or -1 on failure.
+ *   @return File descriptor (non-negative) on success, or -1 on failure. errno is
+ *           EINVAL when the rate is not positive or the driver would not take it
+ *           (callers report `baud_unsupported`), EBUSY when set_exclusive_open()
+ *           is on and another process holds the port (`port_busy`); otherwise it
+ *           comes from open(2) or the termios/ioctl call that failed (EIO, ENOTTY, ...).
  *
  * Notes:
  *   - The returned fd is non-blocking. The higher layers use poll() for reads with timeouts.
@@ -125,28 +148,100 @@ namespace viatext {
  */
 int open_serial(const std::string& dev, int baud = 115200, int boot_delay_ms = 400);
 
+/**
+ * @brief Make every later open_serial() in this process take the port exclusively.
+ *
+ * Off by default. The daemon, --session and --get-log turn it on: they keep a
+ * port open and pipeline on it, so a second viatext process writing to the
+ * same port would interleave its frames with theirs. open_serial() then takes
+ * flock(LOCK_EX | LOCK_NB) right after open(2), before any byte is written,
+ * and fails with errno = EBUSY if another process holds the port that way.
+ *
+ * Advisory: it binds viatext processes (root included, unlike TIOCEXCL), not
+ * other programs. The lock goes with close_serial().
+ */
+void set_exclusive_open(bool on);
+
+/**
+ * @brief Apply an arbitrary baud rate through termios2/BOTHER.
+ *
+ * For rates without a B* constant (e.g. 250000 for some CDC bridges). The
+ * rest of the termios state is kept. The rate read back from the driver must
+ * be within 3% of @p baud, since drivers round to their divisor.
+ *
+ * @return false if the ioctl fails (its errno) or the driver kept another
+ *         rate (errno = EINVAL).
+ */
+bool set_custom_baud(int fd, int baud);
+
+/**
+ * @brief Ask a usb-serial driver for low-latency receive (ASYNC_LOW_LATENCY).
+ *
+ * On FTDI (ftdi_sio) this drops the latency timer from 16 ms to 1 ms, which
+ * otherwise stalls every short response. Drivers without TIOCSSERIAL support
+ * (CDC-ACM, ptys) return false; open_serial() treats that as harmless.
+ *
+ * @return true if the flag is now set.
+ */
+bool set_low_latency(int fd);
+
+
+/** @brief Default deadline for pushing one write out of a full TX buffer. */
+inline constexpr int WRITE_TIMEOUT_MS = 1000;
 
 /**
  * @brief SLIP-encode one payload and write it to the serial port as a single frame.
  *
  * What it does:
  *   - Takes a raw payload buffer and SLIP-encodes it (adds frame delimiters and escapes).
- *   - Attempts a single write(2) of the entire encoded frame.
+ *   - Writes the encoded frame; a partial write continues with the rest, and
+ *     EAGAIN (TX buffer full) waits for POLLOUT, both until @p timeout_ms.
+ *
+ * Parameters:
+ *   @param fd          File descriptor previously returned by open_serial().
+ *   @param payload     Raw, unframed bytes to send (will be SLIP-encoded internally).
+ *   @param timeout_ms  Deadline for the whole frame to leave.
+ *
+ * Returns:
+ *   @return true if the entire encoded frame was written; false on an I/O
+ *           error, a hang-up, or the deadline.
+ *
+ * Notes:
+ *   - A false return means the frame may have been sent in part; the peer's
+ *     SLIP decoder drops the fragment at the next END.
+ *   - Integrity lives in link_guard.hpp: on a guarded fd the frame goes out with
+ *     FLAG_CRC_OK or a CRC-32C trailer and is remembered for a fast resend.
+ */
+bool write_frame(int fd, const std::vector<uint8_t>& payload, int timeout_ms = WRITE_TIMEOUT_MS);
+
+/**
+ * @brief Pointer form of write_frame(), e.g. for a FrameBuf from commands.hpp.
  *
  * Parameters:
  *   @param fd       File descriptor previously returned by open_serial().
- *   @param payload  Raw, unframed bytes to send (will be SLIP-encoded internally).
+ *   @param payload  Raw, unframed bytes to send.
+ *   @param n        Number of bytes at @p payload.
  *
  * Returns:
- *   @return true if the entire encoded frame was written in one system call; false otherwise.
+ *   @return Same contract as the vector overload.
  *
  * Notes:
- *   - If the underlying driver accepts only a partial write, this returns false rather than looping.
- *     If you need guaranteed delivery, add a higher-level retry/loop on the caller side.
- *   - This function does not add checksums or acknowledgments. If you need integrity or receipts,
- *     implement them at the ViaText message layer.
+ *   - Neither overload allocates once warm: the SLIP copy lives in a per-thread
+ *     buffer that is reused across calls.
+ */
+bool write_frame(int fd, const uint8_t* payload, size_t n, int timeout_ms = WRITE_TIMEOUT_MS);
+
+/**
+ * @brief Write several frames with one write(2) (pipelined batches).
+ *
+ * All payloads are SLIP-encoded back to back into one buffer and written
+ * as one stream, with the same partial-write/POLLOUT handling and deadline
+ * as write_frame(). One syscall for a whole window instead of one per frame.
+ *
+ * @return true if every frame was written completely.
  */
-bool write_frame(int fd, const std::vector<uint8_t>& payload);
+bool write_frames(int fd, const std::vector<std::vector<uint8_t>>& payloads,
+                  int timeout_ms = WRITE_TIMEOUT_MS);
 
 
 /**
@@ -154,8 +249,11 @@ bool write_frame(int fd, const std::vector<uint8_t>& payload);
  *
  * What it does:
  *   - Uses poll(2) to wait for readability up to timeout_ms.
- *   - Feeds incoming bytes to a SLIP decoder until one full frame is reconstructed.
+ *   - Reads whatever is available (up to 4 KiB per read(2)) and feeds it to a
+ *     per-fd SLIP decoder until one full frame is reconstructed.
  *   - On success, places the raw (decoded) payload into @p out.
+ *   - Bytes that arrived after the frame's closing END are kept for the next
+ *     call on the same fd, so back-to-back frames are never lost.
  *
  * Parameters:
  *   @param fd          File descriptor previously returned by open_serial().
@@ -170,7 +268,9 @@ bool write_frame(int fd, const std::vector<uint8_t>& payload);
  * Notes:
  *   - A false return value does not distinguish between a clean timeout and an error;
  *     the caller should decide whether to retry, reopen, or abort based on context.
- *   - This reads one frame at a time. If you expect multiple frames, call repeatedly.
+ *   - This reads one frame at a time. If you expect multiple frames, call repeatedly;
+ *     later calls are served from the carry-over buffer before touching the fd.
+ *   - @p timeout_ms bounds the whole frame, not the gap between bytes.
  */
 bool read_frame(int fd, std::vector<uint8_t>& out, int timeout_ms = 1500);
 
@@ -183,6 +283,7 @@ bool read_frame(int fd, std::vector<uint8_t>& out, int timeout_ms = 1500);
  *
  * Side effects:
  *   - Releases the underlying OS handle and any associated kernel resources.
+ *   - Discards any receive bytes read_frame() was carrying over for @p fd.
  *
  * Notes:
  *   - Safe to call exactly once per descriptor ownership. Do not use @p fd after closing.
@@ -190,4 +291,100 @@ bool read_frame(int fd, std::vector<uint8_t>& out, int timeout_ms = 1500);
 void close_serial(int fd);
 
 
+/**
+ * @brief Event loop that drives many serial fds from one thread (epoll).
+ *
+ * The blocking calls above serve one fd per caller, so talking to N nodes at
+ * once used to mean N threads. A Reactor watches every registered fd with one
+ * epoll set and keeps, per fd, its own SLIP decoder and write queue; timers
+ * share the same loop. Implemented in serial_reactor.cpp.
+ *
+ * What it does:
+ *   - add(): watch an fd from open_serial(); every decoded frame is handed
+ *     to its callback, a hang-up or read error to the close callback.
+ *   - send(): SLIP-encode a payload onto the fd's queue and write what the
+ *     driver takes now; the rest goes out on EPOLLOUT, in order. Never blocks.
+ *   - after() / cancel(): one-shot timers (reply deadlines, retries, idle gaps).
+ *   - run_once() / run(): wait for the next fd event or timer and dispatch.
+ *   - stop(): end run() from any thread or a signal handler (eventfd wakeup).
+ *
+ * Threading:
+ *   All calls except stop() belong to the thread running the loop, and every
+ *   callback runs on it; callbacks may add, remove, send and set timers. One
+ *   loop thread decodes at well over line rate for hundreds of 115200-baud
+ *   ports. A host that ever needs more cores runs one Reactor per thread and
+ *   splits the fds between them; no fd is shared between loops.
+ *
+ * Notes:
+ *   - An fd is either reactor driven or used with read_frame(), not both:
+ *     bytes read_frame() had carried over are not seen by the reactor.
+ *   - remove() stops watching without closing; the caller still owns the fd
+ *     and closes it with close_serial().
+ *
+ * @code
+ *   Reactor r;
+ *   r.add(fd, [&](int fd, std::vector<uint8_t>& f) { handle(f); r.stop(); });
+ *   r.send(fd, make_ping(1));
+ *   r.after(1500, [&] { r.stop(); });     // deadline
+ *   r.run();
+ * @endcode
+ */
+class Reactor {
+public:
+    /** Decoded payload; may be swapped out (the reactor reuses the buffer). */
+    using FrameFn = std::function<void(int fd, std::vector<uint8_t>& frame)>;
+    /** Hang-up or I/O error; the fd is no longer watched when this runs. */
+    using CloseFn = std::function<void(int fd)>;
+    using TimerFn = std::function<void()>;
+
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /** @brief Watch @p fd; false if epoll refused it or it is already watched. */
+    bool add(int fd, FrameFn on_frame, CloseFn on_close = {});
+
+    /** @brief Stop watching @p fd and drop its unsent bytes (does not close it). */
+    void remove(int fd);
+
+    /**
+     * @brief Queue one frame for @p fd.
+     * @return false if @p fd is not watched, its queue is full (TX_QUEUE_MAX),
+     *         or the write failed outright; the close callback follows on the
+     *         next dispatch in the last case.
+     */
+    bool send(int fd, const uint8_t* payload, size_t n);
+    bool send(int fd, const std::vector<uint8_t>& payload) { return send(fd, payload.data(), payload.size()); }
+
+    /** @brief Run @p fn once, @p ms from now. @return id for cancel() (never 0). */
+    uint64_t after(int ms, TimerFn fn);
+
+    /** @brief Drop a pending timer; unknown or already fired ids are ignored. */
+    void cancel(uint64_t id);
+
+    /**
+     * @brief Wait up to @p max_wait_ms (-1: until something happens) and dispatch.
+     * @return Number of fd events and timers handled, or -1 if epoll failed.
+     */
+    int run_once(int max_wait_ms = -1);
+
+    /** @brief Dispatch until stop(), or until no fd and no timer is left. */
+    void run();
+
+    /** @brief Make run() return; safe from other threads and signal handlers. */
+    void stop();
+
+    /** @brief Number of fds being watched. */
+    size_t watched() const;
+
+    /** @brief Bytes one fd may have queued for sending before send() refuses. */
+    static constexpr size_t TX_QUEUE_MAX = 64 * 1024;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+
 } // namespace vt
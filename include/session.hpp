@@ -0,0 +1,176 @@
+#pragma once
+/**
+ * @page vt-session ViaText Session Mode
+ * @file session.hpp
+ * @brief Run many commands over one already-open serial port.
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * A one-shot `viatext-cli` call spends almost all of its wall time on setup:
+ * opening the TTY, waiting for the node to be ready after a USB CDC reset, and often a
+ * discovery scan. The request itself is a handful of bytes. Session mode pays
+ * that setup once and then streams commands through the same descriptor.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Reads commands from a stream (stdin or a file), one per line.
+ * - Builds each request through the dispatcher (same names, same validation
+ *   and error strings as the one-shot CLI).
+ * - Writes the frame, waits for the reply carrying the matching sequence
+ *   number, and prints `decode_pretty()` output immediately.
+ * - Optionally pipelines: up to `window` requests are written before their
+ *   replies are awaited. Each request gets its own sequence number and its
+ *   own deadline, and replies are matched back by the echoed `seq` byte.
+ *   On high-latency links (USB CDC round trips) this multiplies throughput.
+ * - `get all` collects every streamed frame of the snapshot and prints one
+ *   merged line (see collect_reply() / decode_snapshot()).
+ *
+ * LINE FORMAT
+ * -----------
+ *   get <name>            e.g. "get freq"
+ *   set <name> <value>    e.g. "set sf 9"   (value is the rest of the line)
+ *   ping
+ *   get-id
+ *   set-id <new_id>
+ *
+ * A leading "--" on the verb is accepted so CLI flags can be pasted as-is
+ * ("--get rssi"). Blank lines and lines starting with '#' are skipped.
+ *
+ * OUTPUT
+ * ------
+ * Exactly one line per command, in input order (also when pipelined):
+ *   - the decoded reply, e.g. `status=ok seq=7 sf=9`, or
+ *   - `status=error reason=<err>` for bad input, timeouts, or I/O failure.
+ * With a non-default OutputFormat the same lines come out as JSON, CSV rows
+ * or raw hex (see output_format.hpp).
+ * Lines are flushed as they are produced so a reading process sees results
+ * without waiting for the session to end.
+ *
+ * EXAMPLE
+ * -------
+ * @code
+ *   printf 'get rssi\nget snr\nget vbat\n' | viatext-cli --node N3 --session -
+ * @endcode
+ *
+ * @see docs/commands.md
+ */
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "output_format.hpp"   // OutputFormat for result lines
+
+namespace viatext {
+
+struct ReplyCache;             // reply_cache.hpp
+
+/**
+ * @brief Build one request packet from a session line.
+ *
+ * Parameters:
+ *   @param line  One input line (see LINE FORMAT above).
+ *   @param seq   Sequence number to stamp into the request.
+ *   @param out   Filled with the encoded packet on success.
+ *   @param err   On failure, a stable error string ("unknown_command",
+ *                "missing_value", or any dispatcher error such as "unknown_get").
+ *
+ * Returns:
+ *   @return true if a packet was built; false with @p err set otherwise.
+ *           Blank and comment lines return false with @p err left empty.
+ */
+bool build_packet_from_line(const std::string& line, uint8_t seq,
+                            std::vector<uint8_t>& out, std::string& err);
+
+
+/**
+ * @brief Read frames until one echoes @p seq, discarding stale replies.
+ *
+ * Parameters:
+ *   @param fd          Open serial descriptor.
+ *   @param seq         Sequence number the reply must carry (frame byte [2]).
+ *   @param resp        Receives the matching frame on success.
+ *   @param timeout_ms  Overall deadline for the matching reply.
+ *
+ * Returns:
+ *   @return true if a frame with @p seq arrived in time; false on timeout/error.
+ */
+bool read_reply(int fd, uint8_t seq, std::vector<uint8_t>& resp, int timeout_ms);
+
+
+/**
+ * @brief Collect a multi-frame reply (e.g. GET_ALL) to @p req, already written.
+ *
+ * The node may stream several RESP_OK frames for one request. This keeps
+ * reading until an end marker (RESP_ERR or a frame with no TLVs) or until no
+ * further frame arrives within @p idle_gap_ms. Pass the result to
+ * decode_snapshot() to print it as one line.
+ *
+ * If the link reported damage while the stream arrived (link_damage(): a bad
+ * CRC, a decoder drop or a NACK), a frame of the snapshot may be the one that
+ * was lost. Once the stream has ended its frames are dropped and @p req goes
+ * out again under next_request_seq() (re-stamped in place), at most
+ * LINK_RESENDS times; only a stream that arrives undamaged is returned.
+ *
+ * Parameters:
+ *   @param fd           Open serial descriptor.
+ *   @param req          The request as written; byte [2] is the seq every frame
+ *                       must carry. On return it holds the seq last used.
+ *   @param frames       Receives the frames in arrival order.
+ *   @param timeout_ms   Deadline for the first frame.
+ *   @param idle_gap_ms  Maximum silence between frames before the stream is done.
+ *   @param damaged      Optional; set to true when the call failed because every
+ *                       try was damaged (report it, not a timeout).
+ *
+ * Returns:
+ *   @return true if a complete stream arrived; false on timeout/error/damage,
+ *           with @p frames empty.
+ */
+bool collect_reply(int fd, std::vector<uint8_t>& req, std::vector<std::vector<uint8_t>>& frames,
+                   int timeout_ms, int idle_gap_ms = 200, bool* damaged = nullptr);
+
+/**
+ * @brief Seq of the next request on a node link: @p seq + 1, wrapping to 1
+ *        below READY_SEQ_BASE so it never collides with the readiness PINGs
+ *        of open_node(); 0 stays unused. Session commands and stream redos.
+ */
+uint8_t next_request_seq(uint8_t seq);
+
+/** @brief True if @p f ends a streamed reply early (RESP_ERR, or no TLVs). */
+bool is_stream_end(const std::vector<uint8_t>& f);
+
+
+/**
+ * @brief Execute every command read from @p in over @p fd, printing replies to @p out.
+ *
+ * Parameters:
+ *   @param fd          Open serial descriptor (from open_serial()); not closed here.
+ *   @param in          Command source, one command per line.
+ *   @param out         Destination for one result line per command.
+ *   @param timeout_ms  Per-command read timeout.
+ *   @param window      Maximum requests in flight (1 = lock-step). With a window
+ *                      above 1 the next lines are read before earlier replies
+ *                      print, so use it for files/pipes, not interactive input.
+ *   @param idle_gap_ms For "get all": silence that ends a streamed snapshot.
+ *   @param fmt         Rendering of each result line (errors included); Csv
+ *                      prints csv_header() first.
+ *   @param cache       Optional reply cache: fresh identity/config reads are
+ *                      answered without a round trip, partly fresh batches are
+ *                      narrowed (reply_cache.hpp). nullptr disables caching.
+ *   @param node        Cache key for the node behind @p fd (ID or device path).
+ *
+ * Returns:
+ *   @return Number of commands that did not produce a reply (bad input, timeout,
+ *           or write failure). 0 means every command was answered.
+ *
+ * Notes:
+ *   - A write failure is reported and the session continues; a dead link will
+ *     surface as a run of errors rather than a silent stop.
+ */
+int run_session(int fd, std::istream& in, std::ostream& out, int timeout_ms, int window = 1,
+                int idle_gap_ms = 200, OutputFormat fmt = OutputFormat::Pretty,
+                ReplyCache* cache = nullptr, const std::string& node = {});
+
+} // namespace viatext
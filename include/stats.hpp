@@ -0,0 +1,135 @@
+#pragma once
+/**
+ * @page vt-stats ViaText I/O Statistics
+ * @file stats.hpp
+ * @brief Per-device phase latency histograms and I/O counters (--stats, daemon --metrics).
+ *
+ * @details
+ * PURPOSE
+ * -------
+ * "The node is slow" can mean the open, the boot delay, the scan, the radio
+ * or the host. Without numbers per phase every guess is as good as the next.
+ * This module records where the time goes on each device and how much
+ * traffic, noise and loss each link saw, with the least possible overhead
+ * when nobody asked for it.
+ *
+ * WHAT THIS DOES
+ * --------------
+ * - Phases (one histogram each, per device):
+ *     open        open(2) + termios setup (open_serial())
+ *     boot_delay  fixed sleep, or readiness PINGs until the node answered
+ *     flush       tcflush() of reboot chatter
+ *     write       write_frame()/write_frames() until the kernel took every byte
+ *     first_byte  last request written -> first reply byte read
+ *     frame       last request written -> reply frame complete
+ *     decode      reply frames -> output line
+ *     scan        one whole discovery probe (host-wide)
+ * - Counters per device: bytes_tx/rx, frames_tx/rx, slip_errors (partial
+ *   frames the decoder dropped: bad escape or oversize), timeouts (requests
+ *   reported as timed out), retries (readiness re-PINGs, writes that had to
+ *   wait for POLLOUT), crc_errors (frames that failed their CRC trailer here
+ *   or, as a NACK, on the node), resends (requests the link guard wrote again
+ *   after damage). Host-wide: cache_hits/cache_misses of the reply cache.
+ * - Histograms are log-linear in microseconds (HDR style): exact below
+ *   16 us, then 16 sub-buckets per power of two, so any percentile is within
+ *   6.25% of the true value from 1 us to hours, in fixed memory.
+ * - Devices are keyed by the path given to open_serial(); fds are bound to
+ *   it on open and unbound on close_serial(). Calls for an unbound fd (or
+ *   fd < 0) land in the host-wide entry.
+ *
+ * FIRST BYTE / FRAME
+ * ------------------
+ * The clock starts when a write finishes with no reply outstanding and stops
+ * at the first reply byte / first complete frame. With several requests in
+ * flight (session --window, daemon queues) only the first of each burst is
+ * timed; later frames are counted, not timed.
+ *
+ * OUTPUT
+ * ------
+ * - stats_print() (--stats, on exit, to stderr): per device and phase
+ *     stats dev=/dev/ttyACM0 phase=frame count=20 p50_us=2210 p90_us=2470 p99_us=3010 max_us=3105 mean_us=2251
+ *     stats dev=/dev/ttyACM0 bytes_tx=240 bytes_rx=610 frames_tx=20 frames_rx=20 slip_errors=0 timeouts=0 retries=0 crc_errors=0 resends=0
+ *     stats cache_hits=12 cache_misses=3
+ * - stats_prometheus(): Prometheus text format (viatext_phase_seconds
+ *   histogram with dev/phase labels, viatext_<counter>_total counters),
+ *   served by the daemon on --metrics <port>.
+ *
+ * COST
+ * ----
+ * Off (the default) every hook is one relaxed atomic load. On, a hook takes
+ * one process-wide mutex for a table lookup and an array increment.
+ *
+ * @see serial_io.hpp, daemon.hpp (DaemonOptions::metrics_port)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace viatext {
+
+/** @brief Timed phases; order is the output order. */
+enum class Phase : uint8_t { Open, BootDelay, Flush, Write, FirstByte, Frame, Decode, Scan, Count };
+
+/** @brief Event counters; CacheHits/CacheMisses are host-wide only. */
+enum class Counter : uint8_t { BytesTx, BytesRx, FramesTx, FramesRx, SlipErrors, Timeouts, Retries,
+                               CrcErrors, Resends, CacheHits, CacheMisses, Count };
+
+/** @brief Set once by stats_enable(); read by every hook. */
+extern std::atomic<bool> stats_enabled;
+
+/** @brief Start collecting (--stats, --metrics). There is no way back; totals only grow. */
+void stats_enable();
+
+/** @brief True if stats_enable() was called. */
+inline bool stats_on() { return stats_enabled.load(std::memory_order_relaxed); }
+
+
+/** @brief Attribute everything on @p fd to device @p dev (open_serial()). */
+void stats_bind(int fd, const std::string& dev);
+
+/** @brief Forget @p fd (close_serial()); the device's totals stay. */
+void stats_unbind(int fd);
+
+
+/** @brief Add one sample of @p d to phase @p p of @p fd's device. */
+void stats_time(int fd, Phase p, std::chrono::steady_clock::duration d);
+
+/** @brief Add @p n to counter @p c of @p fd's device. */
+void stats_count(int fd, Counter c, uint64_t n = 1);
+
+/** @brief A request of @p bytes went out on @p fd (frames_tx, bytes_tx; starts first_byte/frame). */
+void stats_sent(int fd, size_t bytes, size_t frames = 1);
+
+/** @brief @p bytes arrived on @p fd (bytes_rx; stops first_byte). */
+void stats_received(int fd, size_t bytes);
+
+/** @brief A frame was decoded on @p fd (frames_rx; stops frame). */
+void stats_frame(int fd);
+
+
+/** @brief Times its own lifetime into one phase; free when stats are off. */
+struct StatsTimer {
+    StatsTimer(int fd, Phase p) : fd(fd), p(p), on(stats_on()) {
+        if (on) t0 = std::chrono::steady_clock::now();
+    }
+    ~StatsTimer() { if (on) stats_time(fd, p, std::chrono::steady_clock::now() - t0); }
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+    int fd;
+    Phase p;
+    bool on;
+    std::chrono::steady_clock::time_point t0{};
+};
+
+
+/** @brief Everything collected so far as `stats ...` lines (format in the file header). */
+void stats_print(std::ostream& out);
+
+/** @brief Everything collected so far in Prometheus text exposition format 0.0.4. */
+void stats_prometheus(std::ostream& out);
+
+} // namespace viatext
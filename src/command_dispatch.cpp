@@ -8,251 +8,130 @@
 // Notes for maintainers:
 // - This file is implementation-only. The header explains *what*; here we show
 //   *how* and *why*.
-// - Focus is on local parsing, validation, and switch-based dispatch.
+// - Focus is on local parsing, validation, and table-driven dispatch
+//   (rows live in param_table.hpp).
 // - Style is defensive and transparent: no exceptions, no hidden magic.
 // -----------------------------------------------------------------------------
 
 #include "command_dispatch.hpp"  // matching header: declares dispatcher API and enums
-#include "commands.hpp"          // low-level builders (make_get_id, make_set_freq, etc.)
+#include "commands.hpp"          // FrameBuf + frame_*() builders, verbs, TAG_* values
+#include "param_table.hpp"       // PARAMS: names, tags, wire types and ranges
 
-#include <algorithm>             // std::tolower helper needs a loop-friendly include
 #include <cctype>                // character classification and case conversion
-#include <cstdlib>               // strtol / strtoull for safe string→number parsing
+#include <cstdlib>               // strtoll for safe string→number parsing
 
 namespace viatext {
 
-// ---------- local parsing helpers (no exceptions) ----------
-// These functions convert strings from CLI input into fixed-width integers.
-// - All parsing is done with strtol/strtoull (C stdlib) for predictability.
-// - No exceptions are thrown; failure is always signaled by "false".
-// - Each parser enforces explicit bounds so bad values never leak downstream.
-// - Chosen ranges match the expected fields in ViaText protocol headers.
-
-static bool parse_u8(const std::string& s, uint8_t& out,
-                     uint32_t lo=0, uint32_t hi=255) {
-    // strtol: parse string as integer, "e" marks the end pointer
+// ---------- local parsing helper (no exceptions) ----------
+// Convert a CLI value into an integer within the row's inclusive range.
+// - strtoll with base 0 accepts decimal, 0x-hex and 0-octal like before.
+// - Empty strings and trailing junk are rejected ("" used to slip through as 0).
+// - The range comes from the table, so every SET is bounds-checked the same way.
+static bool parse_ranged(const std::string& s, int64_t lo, int64_t hi, int64_t& out) {
+    const char* b = s.c_str();
     char* e = nullptr;
-    long v = std::strtol(s.c_str(), &e, 0);
-
-    // Reject if parsing failed or leftover junk chars exist
-    if (!e || *e) return false;
-
-    // Range check: must fit within lo..hi
-    if (v < (long)lo || v > (long)hi) return false;
-
-    // Safe to cast down to 8-bit
-    out = (uint8_t)v;
-    return true;
-}
-
-static bool parse_i8(const std::string& s, int8_t& out,
-                     int32_t lo=-128, int32_t hi=127) {
-    char* e = nullptr;
-    long v = std::strtol(s.c_str(), &e, 0);
-    if (!e || *e) return false;
+    long long v = std::strtoll(b, &e, 0);
+    if (!e || e == b || *e) return false;
     if (v < lo || v > hi) return false;
-
-    // Signed case: cast down into int8_t after checks
-    out = (int8_t)v;
+    out = v;
     return true;
 }
 
-static bool parse_u16(const std::string& s, uint16_t& out,
-                      uint32_t lo=0, uint32_t hi=65535) {
-    char* e = nullptr;
-    long v = std::strtol(s.c_str(), &e, 0);
-    if (!e || *e) return false;
-    if (v < (long)lo || v > (long)hi) return false;
+// ---------- name lookup ----------
+// Lowercase into a stack buffer, then binary-search the sorted PARAM_NAMES.
+// Names longer than any known spelling can't match, so they fail fast.
+// Direction is checked last: one-way spellings ("get-id") and read-only rows
+// don't resolve for the other direction.
+const ParamDef* find_param(std::string_view name, bool is_set) {
+    char buf[32];
+    if (name.empty() || name.size() > sizeof(buf)) return nullptr;
+    for (size_t i = 0; i < name.size(); ++i)
+        buf[i] = (char)std::tolower((unsigned char)name[i]);
+    const std::string_view key(buf, name.size());
+
+    size_t lo = 0, hi = PARAM_NAMES.size();
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if (PARAM_NAMES[mid].name < key) lo = mid + 1;
+        else                             hi = mid;
+    }
+    if (lo == PARAM_NAMES.size() || PARAM_NAMES[lo].name != key) return nullptr;
 
-    // Fits within 16-bit unsigned
-    out = (uint16_t)v;
-    return true;
+    const ParamName& hit = PARAM_NAMES[lo];
+    const ParamDef& p = PARAMS[hit.row];
+    if (!(hit.dirs & (is_set ? DIR_SET : DIR_GET))) return nullptr;
+    if (is_set && !p.set_verb) return nullptr;
+    return &p;
 }
 
-static bool parse_u32(const std::string& s, uint32_t& out,
-                      uint64_t lo=0, uint64_t hi=0xFFFFFFFFull) {
-    char* e = nullptr;
-    unsigned long long v = std::strtoull(s.c_str(), &e, 0);
-    if (!e || *e) return false;
-    if (v < lo || v > hi) return false;
-
-    // Fits within 32-bit unsigned
-    out = (uint32_t)v;
+// ---------- mapping: (name, is_set) -> CommandKind ----------
+// Table lookup; a read-only row (set_verb == 0) has no SET form, so
+// "SET rssi" is rejected here before any builder runs.
+bool name_to_kind(const std::string& raw_name, bool is_set, CommandKind& out_kind) {
+    const ParamDef* p = find_param(raw_name, is_set);
+    if (!p) return false;
+    out_kind = is_set ? p->set_kind : p->get_kind;
     return true;
 }
 
-// ---------- lowercase normalizer ----------
-// Convert a string into lowercase, char by char.
-// - Helps normalize CLI parameters so aliases match consistently.
-// - Cast to unsigned char first so std::tolower is well-defined
-//   (avoids UB on chars with high bit set).
-static std::string lower(std::string s) {
-    for (auto& c : s)
-        c = (char)std::tolower((unsigned char)c);
-    return s;
-}
-
-// ---------- mapping: (name, is_set) -> CommandKind ----------
-// Translate a user-facing name plus operation bit (is_set) into a canonical enum.
-// - Input "raw_name" may contain mixed case or legacy spellings; we normalize.
-// - We prefer explicit branches over tables here for transparency and offline audit.
-// - Lookup is O(n) and fine for this small, fixed vocabulary; clarity > micro-optimizations.
-bool name_to_kind(const std::string& raw_name, bool is_set, CommandKind& out_kind) {
-    const std::string name = lower(raw_name);  // normalize early so aliases match reliably
-
-    // Legacy / explicit names
-    // Ambiguity note: "id" is overloaded; GET when !is_set, SET when is_set.
-    // This split ensures "id" alone routes correctly based on operation.
-    if (!is_set) {
-        // GET: return the node’s current ID
-        if (name == "id" || name == "get-id") { out_kind = CommandKind::GET_ID; return true; }
-
-        // GET: basic connectivity check
-        if (name == "ping")                   { out_kind = CommandKind::PING;   return true; }
-    } else {
-        // SET: assign a new node ID
-        if (name == "id" || name == "set-id") { out_kind = CommandKind::SET_ID; return true; }
+// ---------- value encoding ----------
+// Append one SET TLV for row `p`, parsing `value` per its wire type.
+// Errors keep the historical names: "bad_value:" + output key + range hint.
+static bool add_set_value(FrameBuf& f, const ParamDef& p, const std::string& value, std::string& err) {
+    if (p.type == WireType::Str) {
+        frame_add_str(f, p.tag, value.data(), value.size());
+        return true;
     }
 
-    // Identity / inventory
-    // Note: "alias" is both GET and SET; "fw" has a synonym "fw_version".
-    // "uptime" vs "uptime_s" and "boot_time" vs "boot_time_s" are accepted for ergonomics.
-    if (!is_set) {
-        // Request node alias string
-        if (name == "alias")         { out_kind = CommandKind::GET_ALIAS; return true; }
-
-        // Request firmware version
-        if (name == "fw" || name=="fw_version") { out_kind = CommandKind::GET_FW_VERSION; return true; }
-
-        // Request node uptime in seconds
-        if (name == "uptime" || name=="uptime_s"){ out_kind = CommandKind::GET_UPTIME_S;   return true; }
-
-        // Request node boot time in seconds since epoch
-        if (name == "boot_time" || name=="boot_time_s") { out_kind = CommandKind::GET_BOOT_TIME_S; return true; }
-    } else {
-        // Set node alias string
-        if (name == "alias")         { out_kind = CommandKind::SET_ALIAS; return true; }
+    int64_t v = 0;
+    if (!parse_ranged(value, p.lo, p.hi, v)) {
+        err = "bad_value:";
+        err.append(p.key.data(), p.key.size());
+        err.append(p.hint.data(), p.hint.size());
+        return false;
     }
-
-
-    // Radio
-    // Aliases accepted for power: "tx_pwr" and short "pwr".
-    // Ambiguity note: these names are terse by design; ranges are enforced later at build time.
-    if (!is_set) {
-        // GET: operating frequency in Hz (e.g. 915000000)
-        if (name == "freq")    { out_kind = CommandKind::GET_FREQ_HZ; return true; }
-
-        // GET: spreading factor (LoRa SF7..SF12, controls range vs data rate)
-        if (name == "sf")      { out_kind = CommandKind::GET_SF;      return true; }
-
-        // GET: bandwidth in Hz (e.g. 125000, 250000, 500000)
-        if (name == "bw")      { out_kind = CommandKind::GET_BW_HZ;   return true; }
-
-        // GET: coding rate denominator (LoRa CR 5..8, adds error correction overhead)
-        if (name == "cr")      { out_kind = CommandKind::GET_CR_DEN;  return true; }
-
-        // GET: transmit power in dBm (alias "tx_pwr" or short "pwr")
-        if (name == "tx_pwr" || name == "pwr") { out_kind = CommandKind::GET_TX_PWR_DBM; return true; }
-
-        // GET: logical channel index (firmware-defined channel plan)
-        if (name == "chan")    { out_kind = CommandKind::GET_CHAN;    return true; }
-    } else {
-        // SET: operating frequency in Hz
-        if (name == "freq")    { out_kind = CommandKind::SET_FREQ_HZ; return true; }
-
-        // SET: spreading factor (7–12)
-        if (name == "sf")      { out_kind = CommandKind::SET_SF;      return true; }
-
-        // SET: bandwidth in Hz
-        if (name == "bw")      { out_kind = CommandKind::SET_BW_HZ;   return true; }
-
-        // SET: coding rate denominator (5–8)
-        if (name == "cr")      { out_kind = CommandKind::SET_CR_DEN;  return true; }
-
-        // SET: transmit power in dBm
-        if (name == "tx_pwr" || name == "pwr") { out_kind = CommandKind::SET_TX_PWR_DBM; return true; }
-
-        // SET: logical channel index
-        if (name == "chan")    { out_kind = CommandKind::SET_CHAN;    return true; }
+    switch (p.type) {
+        case WireType::U8:  frame_add_u8 (f, p.tag, (uint8_t)v);  break;
+        case WireType::I8:  frame_add_i8 (f, p.tag, (int8_t)v);   break;
+        case WireType::U16: frame_add_u16(f, p.tag, (uint16_t)v); break;
+        case WireType::I16: frame_add_i16(f, p.tag, (int16_t)v);  break;
+        case WireType::U32: frame_add_u32(f, p.tag, (uint32_t)v); break;
+        default:            err = "unhandled_command"; return false;
     }
+    return true;
+}
 
+// ---------- table-driven builder ----------
+// One row describes both directions:
+//   GET: [get_verb]           + GET TLV for the tag when the verb is GET_PARAM
+//   SET: [set_verb]           + one value TLV encoded per the row's wire type
+// This yields byte-for-byte the frames the per-parameter make_*() builders do.
+bool build_frame_from_kind(CommandKind kind,
+                           uint8_t seq,
+                           const std::string& value,
+                           FrameBuf& f,
+                           std::string& err)
+{
+    const ParamDef* p = param_for_kind(kind);
+    if (!p) { err = "unhandled_command"; return false; }
 
-    // Behavior
-    // Symmetric GET/SET pairs; "beacon" and "beacon_s" both mean seconds.
-    // Ambiguity note: "mode" is an opaque numeric enum at this layer; decoding is firmware-side.
-    if (!is_set) {
-        // GET: operating mode (numeric, meaning defined in firmware)
-        if (name == "mode")     { out_kind = CommandKind::GET_MODE;     return true; }
-
-        // GET: maximum hop count (TTL) for relayed packets
-        if (name == "hops")     { out_kind = CommandKind::GET_HOPS;     return true; }
-
-        // GET: beacon interval in seconds (alias: "beacon_s")
-        if (name == "beacon" || name=="beacon_s") { out_kind = CommandKind::GET_BEACON_S; return true; }
-
-        // GET: buffer size for queued messages
-        if (name == "buf_size") { out_kind = CommandKind::GET_BUF_SIZE; return true; }
-
-        // GET: acknowledgment mode (0 = off, 1 = on)
-        if (name == "ack")      { out_kind = CommandKind::GET_ACK_MODE; return true; }
-    } else {
-        // SET: operating mode
-        if (name == "mode")     { out_kind = CommandKind::SET_MODE;     return true; }
-
-        // SET: maximum hop count (TTL)
-        if (name == "hops")     { out_kind = CommandKind::SET_HOPS;     return true; }
-
-        // SET: beacon interval in seconds
-        if (name == "beacon" || name=="beacon_s") { out_kind = CommandKind::SET_BEACON_S; return true; }
-
-        // SET: buffer size for queued messages
-        if (name == "buf_size") { out_kind = CommandKind::SET_BUF_SIZE; return true; }
-
-        // SET: acknowledgment mode
-        if (name == "ack")      { out_kind = CommandKind::SET_ACK_MODE; return true; }
-    }
-
-    // Diagnostics (RO)
-    // Read-only probes. If "is_set" is true for these names, we fall through and return false.
-    // This early rejection prevents "SET rssi" style invalid ops from reaching the builder stage.
-    if (!is_set) {
-        // GET: last received signal strength (RSSI, in dBm)
-        if (name == "rssi")       { out_kind = CommandKind::GET_RSSI_DBM;   return true; }
-
-        // GET: last signal-to-noise ratio (in dB)
-        if (name == "snr")        { out_kind = CommandKind::GET_SNR_DB;     return true; }
-
-        // GET: supply voltage (in millivolts)
-        if (name == "vbat")       { out_kind = CommandKind::GET_VBAT_MV;    return true; }
-
-        // GET: onboard temperature (in °C)
-        if (name == "temp")       { out_kind = CommandKind::GET_TEMP_C;     return true; }
-
-        // GET: free memory (in bytes)
-        if (name == "free_mem")   { out_kind = CommandKind::GET_FREE_MEM_B; return true; }
-
-        // GET: free flash storage (in bytes)
-        if (name == "free_flash") { out_kind = CommandKind::GET_FREE_FLASH_B; return true; }
+    const bool is_set = p->set_verb && kind == p->set_kind;
+    frame_begin(f, is_set ? p->set_verb : p->get_verb, seq);
 
-        // GET: number of stored log entries
-        if (name == "log_count")  { out_kind = CommandKind::GET_LOG_COUNT;  return true; }
+    if (is_set) {
+        if (!add_set_value(f, *p, value, err)) return false;
+    } else if (p->get_verb == GET_PARAM) {
+        frame_add_get(f, p->tag);
     }
 
-    // Bulk
-    // "all" is a convenience alias for a snapshot read of common fields.
-    if (!is_set) {
-        // GET: one-shot snapshot of all parameters
-        if (name == "all" || name == "get_all") { out_kind = CommandKind::GET_ALL; return true; }
+    if (!frame_finalize(f)) {
+        err = "bad_value:";
+        err.append(p->key.data(), p->key.size());
+        return false;
     }
-
-
-    // No match found.
-    // Maintenance note: add new names in the appropriate section above.
-    // Prefer explicit alias pairs (GET/SET) to keep failure modes obvious.
-    return false;
+    return true;
 }
 
-// ---------- switch-based builder ----------
 bool build_packet_from_kind(CommandKind kind,
                             uint8_t seq,
                             const std::string& value,
@@ -260,275 +139,10 @@ bool build_packet_from_kind(CommandKind kind,
                             std::string& err)
 {
     out.clear();
-
-    switch (kind) {
-
-        // ===== Legacy / basic =====
-
-        case CommandKind::GET_ID: {
-            // Build a GET request for the node's unique ID string.
-            out = make_get_id(seq);
-            return true;
-        }
-
-        case CommandKind::SET_ID: {
-            // Build a SET request to assign the node's unique ID (uses `value` as new ID).
-            out = make_set_id(seq, value);
-            return true;
-        }
-
-        case CommandKind::PING: {
-            // Build a PING request (round-trip sanity check).
-            out = make_ping(seq);
-            return true;
-        }
-
-        // ===== Identity / inventory =====
-
-        case CommandKind::GET_ALIAS: {
-            // Read the node's human-readable alias.
-            out = make_get_alias(seq);
-            return true;
-        }
-
-        case CommandKind::SET_ALIAS: {
-            // Set the node's human-readable alias (uses `value`).
-            out = make_set_alias(seq, value);
-            return true;
-        }
-
-        case CommandKind::GET_FW_VERSION: {
-            // Read firmware version string.
-            out = make_get_fw_version(seq);
-            return true;
-        }
-
-        case CommandKind::GET_UPTIME_S: {
-            // Read uptime in seconds since last boot.
-            out = make_get_uptime(seq);
-            return true;
-        }
-
-        case CommandKind::GET_BOOT_TIME_S: {
-            // Read absolute boot time (epoch seconds).
-            out = make_get_boot_time(seq);
-            return true;
-        }
-
-        // ===== Radio =====
-
-        case CommandKind::GET_FREQ_HZ: {
-            // Read RF center frequency in Hz.
-            out = make_get_freq(seq);
-            return true;
-        }
-
-        case CommandKind::SET_FREQ_HZ: {
-            // Set RF center frequency in Hz; parse and validate numeric `value`.
-            uint32_t hz;
-            if (!parse_u32(value, hz)) { err = "bad_value:freq_hz"; return false; }
-            out = make_set_freq(seq, hz);
-            return true;
-        }
-
-        case CommandKind::GET_SF: {
-            // Read LoRa spreading factor (SF7..SF12).
-            out = make_get_sf(seq);
-            return true;
-        }
-
-        case CommandKind::SET_SF: {
-            // Set LoRa spreading factor (must be 7..12).
-            uint8_t sf;
-            if (!parse_u8(value, sf, 7, 12)) { err = "bad_value:sf(7..12)"; return false; }
-            out = make_set_sf(seq, sf);
-            return true;
-        }
-
-        case CommandKind::GET_BW_HZ: {
-            // Read LoRa bandwidth in Hz (e.g., 125000/250000/500000).
-            out = make_get_bw(seq);
-            return true;
-        }
-
-        case CommandKind::SET_BW_HZ: {
-            // Set LoRa bandwidth in Hz; parse and validate numeric `value`.
-            uint32_t bw;
-            if (!parse_u32(value, bw)) { err = "bad_value:bw_hz"; return false; }
-            out = make_set_bw(seq, bw);
-            return true;
-        }
-
-        case CommandKind::GET_CR_DEN: {
-            // Read LoRa coding rate denominator (5..8).
-            out = make_get_cr(seq);
-            return true;
-        }
-
-        case CommandKind::SET_CR_DEN: {
-            // Set LoRa coding rate denominator (must be 5..8).
-            uint8_t cr;
-            if (!parse_u8(value, cr, 5, 8)) { err = "bad_value:cr(5..8)"; return false; }
-            out = make_set_cr(seq, cr);
-            return true;
-        }
-
-        case CommandKind::GET_TX_PWR_DBM: {
-            // Read TX power in dBm.
-            out = make_get_tx_pwr(seq);
-            return true;
-        }
-
-        case CommandKind::SET_TX_PWR_DBM: {
-            // Set TX power in dBm (must be -20..23).
-            int8_t dbm;
-            if (!parse_i8(value, dbm, -20, 23)) { err = "bad_value:tx_pwr_dbm(-20..23)"; return false; }
-            out = make_set_tx_pwr(seq, dbm);
-            return true;
-        }
-
-        case CommandKind::GET_CHAN: {
-            // Read logical channel index.
-            out = make_get_chan(seq);
-            return true;
-        }
-
-        case CommandKind::SET_CHAN: {
-            // Set logical channel index; parse and validate numeric `value`.
-            uint8_t ch;
-            if (!parse_u8(value, ch)) { err = "bad_value:chan"; return false; }
-            out = make_set_chan(seq, ch);
-            return true;
-        }
-
-        // ===== Behavior =====
-
-        case CommandKind::GET_MODE: {
-            // Read operating mode (opaque numeric enum; defined in firmware).
-            out = make_get_mode(seq);
-            return true;
-        }
-
-        case CommandKind::SET_MODE: {
-            // Set operating mode (opaque numeric enum); parse `value`.
-            uint8_t m;
-            if (!parse_u8(value, m)) { err = "bad_value:mode"; return false; }
-            out = make_set_mode(seq, m);
-            return true;
-        }
-
-        case CommandKind::GET_HOPS: {
-            // Read maximum hop count (TTL) for relayed packets.
-            out = make_get_hops(seq);
-            return true;
-        }
-
-        case CommandKind::SET_HOPS: {
-            // Set maximum hop count (TTL); parse `value`.
-            uint8_t h;
-            if (!parse_u8(value, h)) { err = "bad_value:hops"; return false; }
-            out = make_set_hops(seq, h);
-            return true;
-        }
-
-        case CommandKind::GET_BEACON_S: {
-            // Read beacon interval in seconds.
-            out = make_get_beacon(seq);
-            return true;
-        }
-
-        case CommandKind::SET_BEACON_S: {
-            // Set beacon interval in seconds; parse `value`.
-            uint32_t s;
-            if (!parse_u32(value, s)) { err = "bad_value:beacon_s"; return false; }
-            out = make_set_beacon(seq, s);
-            return true;
-        }
-
-        case CommandKind::GET_BUF_SIZE: {
-            // Read buffer size for queued messages (bytes/entries; firmware-defined).
-            out = make_get_buf_size(seq);
-            return true;
-        }
-
-        case CommandKind::SET_BUF_SIZE: {
-            // Set buffer size; parse `value`.
-            uint16_t n;
-            if (!parse_u16(value, n)) { err = "bad_value:buf_size"; return false; }
-            out = make_set_buf_size(seq, n);
-            return true;
-        }
-
-        case CommandKind::GET_ACK_MODE: {
-            // Read acknowledgment mode (0=off, 1=on).
-            out = make_get_ack_mode(seq);
-            return true;
-        }
-
-        case CommandKind::SET_ACK_MODE: {
-            // Set acknowledgment mode (must be 0 or 1).
-            uint8_t on;
-            if (!parse_u8(value, on, 0, 1)) { err = "bad_value:ack(0|1)"; return false; }
-            out = make_set_ack_mode(seq, on);
-            return true;
-        }
-
-        // ===== Diagnostics (RO) =====
-
-        case CommandKind::GET_RSSI_DBM: {
-            // Read last received signal strength (RSSI, dBm).
-            out = make_get_rssi(seq);
-            return true;
-        }
-
-        case CommandKind::GET_SNR_DB: {
-            // Read last signal-to-noise ratio (dB).
-            out = make_get_snr(seq);
-            return true;
-        }
-
-        case CommandKind::GET_VBAT_MV: {
-            // Read supply voltage (millivolts).
-            out = make_get_vbat(seq);
-            return true;
-        }
-
-        case CommandKind::GET_TEMP_C: {
-            // Read onboard temperature (°C).
-            out = make_get_temp(seq);
-            return true;
-        }
-
-        case CommandKind::GET_FREE_MEM_B: {
-            // Read free RAM (bytes).
-            out = make_get_free_mem(seq);
-            return true;
-        }
-
-        case CommandKind::GET_FREE_FLASH_B: {
-            // Read free flash storage (bytes).
-            out = make_get_free_flash(seq);
-            return true;
-        }
-
-        case CommandKind::GET_LOG_COUNT: {
-            // Read count of stored log entries.
-            out = make_get_log_count(seq);
-            return true;
-        }
-
-        // ===== Bulk =====
-
-        case CommandKind::GET_ALL: {
-            // Request a one-shot snapshot of common parameters.
-            out = make_get_all(seq);
-            return true;
-        }
-    }
-
-    // If we ever add a new enum and forget to handle it here:
-    err = "unhandled_command";
-    return false;
+    FrameBuf f;
+    if (!build_frame_from_kind(kind, seq, value, f, err)) return false;
+    out.assign(f.bytes.begin(), f.bytes.begin() + f.len);   // reuses out's capacity
+    return true;
 }
 
 
@@ -574,6 +188,69 @@ bool build_legacy_packet(bool get_id,
 }
 
 
+// ---------- batched helpers ----------
+// Pack several parameters into one GET_PARAM / SET_PARAM frame.
+//
+// Names resolve through the same table as the single form, so aliases,
+// read-only rules and range checks are identical; TLVs go straight into one
+// FrameBuf. Errors name the offending parameter, e.g. "unknown_get:foo".
+
+// Split "a,b,c" into names; empty items (",," or trailing ",") are skipped.
+static std::vector<std::string> split_names(const std::string& csv) {
+    std::vector<std::string> names;
+    size_t start = 0;
+    while (start <= csv.size()) {
+        size_t comma = csv.find(',', start);
+        if (comma == std::string::npos) comma = csv.size();
+        if (comma > start) names.push_back(csv.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return names;
+}
+
+bool build_param_get_batch(const std::vector<std::string>& names, uint8_t seq,
+                           std::vector<uint8_t>& out, std::string& err)
+{
+    out.clear();
+    if (names.empty()) { err = "unknown_get"; return false; }
+
+    FrameBuf f;
+    frame_begin(f, GET_PARAM, seq);
+    for (const auto& name : names) {
+        const ParamDef* p = find_param(name, /*is_set=*/false);
+        if (!p) { err = "unknown_get:" + name; return false; }
+
+        // "id" rides along as TAG_ID; verb-only rows ("ping", "all") have no tag.
+        if (!p->tag) { err = "not_batchable:" + name; return false; }
+        frame_add_get(f, p->tag);
+    }
+
+    if (!frame_finalize(f)) { err = "batch_too_large"; return false; }
+    out.assign(f.bytes.begin(), f.bytes.begin() + f.len);
+    return true;
+}
+
+bool build_param_set_batch(const std::vector<std::pair<std::string, std::string>>& kv, uint8_t seq,
+                           std::vector<uint8_t>& out, std::string& err)
+{
+    out.clear();
+    if (kv.empty()) { err = "unknown_set"; return false; }
+
+    FrameBuf f;
+    frame_begin(f, SET_PARAM, seq);
+    for (const auto& [name, value] : kv) {
+        const ParamDef* p = find_param(name, /*is_set=*/true);
+        if (!p) { err = "unknown_set:" + name; return false; }
+        if (p->set_verb != SET_PARAM) { err = "not_batchable:" + name; return false; }   // id uses SET_ID
+        if (!add_set_value(f, *p, value, err)) return false;                             // bad_value:...
+    }
+
+    if (!frame_finalize(f)) { err = "batch_too_large"; return false; }
+    out.assign(f.bytes.begin(), f.bytes.begin() + f.len);
+    return true;
+}
+
+
 // ---------- public helpers ----------
 // Build a GET_* packet from a user-facing parameter name.
 //
@@ -582,12 +259,17 @@ bool build_legacy_packet(bool get_id,
 //  2) Resolve the human-facing `name` into a canonical CommandKind (GET variant).
 //  3) If unknown, fail with a stable error string ("unknown_get").
 //  4) Otherwise, build the packet (GET ignores `value`).
+// A comma-separated name ("freq,sf,bw") is routed to build_param_get_batch().
 bool build_param_get_packet(const std::string& name, uint8_t seq,
                             std::vector<uint8_t>& out, std::string& err)
 {
     out.clear();              // 1) ensure no stale bytes are left in `out`
     CommandKind kind;         //    resolved command kind will be stored here
 
+    // "a,b,c" asks for several parameters in one frame
+    if (name.find(',') != std::string::npos)
+        return build_param_get_batch(split_names(name), seq, out, err);
+
     // 2) map name → CommandKind (GET). If not recognized:
     if (!name_to_kind(name, /*is_set=*/false, kind)) {
         err = "unknown_get";  // 3) stable error for scripts / callers
@@ -1,4 +1,7 @@
 #include "commands.hpp"   // Our own header: declares the builders, TLV tags, and decode API
+#include "slip.hpp"       // slip::encode() into a caller buffer for frame_seal()
+#include "param_table.hpp" // tag → key / wire type for decode_pretty()
+#include "crc32c.hpp"     // crc32c() for crc_seal() / crc_check()
 
 #include <algorithm>      // std::find, std::copy, std::min/max — handy when slicing TLVs
 #include <sstream>        // std::ostringstream: assemble human-readable summaries in decode_pretty
@@ -13,18 +16,52 @@ namespace viatext {
 // file leans on them. They make it easy to push verbs, TLVs, and values into
 // a byte vector without repeating boilerplate.
 
+// ---------------------------------------------------------------------------
+// Byte sinks
+// The helpers below are templates over the output buffer so the same TLV
+// layout code serves both the vector-returning make_*() builders and the
+// zero-allocation FrameBuf API. A sink only needs put() and size().
+// FrameBuf refuses bytes past MAX_FRAME and records the overflow instead.
+// ---------------------------------------------------------------------------
+static inline void put(std::vector<uint8_t>& b, uint8_t v) { b.push_back(v); }
+static inline void put(std::vector<uint8_t>& b, const uint8_t* p, size_t n) {
+    b.insert(b.end(), p, p + n);
+}
+
+static inline void put(FrameBuf& f, uint8_t v) {
+    if (f.len >= MAX_FRAME) { f.overflow = true; return; }
+    f.bytes[f.len++] = v;
+}
+static inline void put(FrameBuf& f, const uint8_t* p, size_t n) {
+    if (n > MAX_FRAME - f.len) { f.overflow = true; return; }
+    std::copy(p, p + n, f.bytes.data() + f.len);
+    f.len += n;
+}
+
+static inline size_t sink_size(const std::vector<uint8_t>& b) { return b.size(); }
+static inline size_t sink_size(const FrameBuf& f) { return f.len; }
+
+static inline uint8_t& sink_at(std::vector<uint8_t>& b, size_t i) { return b[i]; }
+static inline uint8_t& sink_at(FrameBuf& f, size_t i) { return f.bytes[i]; }
+
+
 // ---------------------------------------------------------------------------
 // Start a new frame header.
 // Layout: [verb][0][seq][0] where [3] is a TLV-length placeholder.
-// Reserve some space so small packets don’t reallocate mid-build.
+// The vector form reserves some space so small packets don’t reallocate mid-build.
 // ---------------------------------------------------------------------------
+template <class Buf>
+static inline void put_header(Buf& b, uint8_t verb, uint8_t seq) {
+    put(b, verb);                      // verb: what this frame does
+    put(b, 0);                         // reserved (unused / future-proof)
+    put(b, seq);                       // host-supplied sequence number
+    put(b, 0);                         // TLV length (filled later)
+}
+
 static inline std::vector<uint8_t> header(uint8_t verb, uint8_t seq) {
     std::vector<uint8_t> b;
     b.reserve(64);                     // pre-size to avoid churn
-    b.push_back(verb);                 // verb: what this frame does
-    b.push_back(0);                    // reserved (unused / future-proof)
-    b.push_back(seq);                  // host-supplied sequence number
-    b.push_back(0);                    // TLV length (filled later)
+    put_header(b, verb, seq);
     return b;
 }
 
@@ -32,14 +69,15 @@ static inline std::vector<uint8_t> header(uint8_t verb, uint8_t seq) {
 // Append a raw TLV (tag + length + optional value bytes).
 // All other add_tlv_* helpers feed into this.
 // ---------------------------------------------------------------------------
-static inline void add_tlv_bytes(std::vector<uint8_t>& b,
+template <class Buf>
+static inline void add_tlv_bytes(Buf& b,
                                  uint8_t tag,
                                  const uint8_t* p,
                                  uint8_t len) {
-    b.push_back(tag);                  // TLV tag
-    b.push_back(len);                  // TLV length
+    put(b, tag);                       // TLV tag
+    put(b, len);                       // TLV length
     if (len)                           // only copy if data present
-        b.insert(b.end(), p, p+len);   // append value bytes
+        put(b, p, len);                // append value bytes
 }
 
 // ---------------------------------------------------------------------------
@@ -47,31 +85,36 @@ static inline void add_tlv_bytes(std::vector<uint8_t>& b,
 // They marshal native values into little-endian byte arrays and
 // hand off to add_tlv_bytes() above.
 // ---------------------------------------------------------------------------
-static inline void add_tlv_u8 (std::vector<uint8_t>& b, uint8_t tag, uint8_t v) {
+template <class Buf>
+static inline void add_tlv_u8 (Buf& b, uint8_t tag, uint8_t v) {
     uint8_t x[1] = { v };
     add_tlv_bytes(b, tag, x, 1);
 }
 
 
-static inline void add_tlv_i8 (std::vector<uint8_t>& b, uint8_t tag, int8_t v) {
+template <class Buf>
+static inline void add_tlv_i8 (Buf& b, uint8_t tag, int8_t v) {
     uint8_t x[1] = { static_cast<uint8_t>(v) };  // reinterpret signed as raw byte
     add_tlv_bytes(b, tag, x, 1);
 }
 
 
-static inline void add_tlv_u16(std::vector<uint8_t>& b, uint8_t tag, uint16_t v) {
+template <class Buf>
+static inline void add_tlv_u16(Buf& b, uint8_t tag, uint16_t v) {
     uint8_t x[2] = { (uint8_t)(v & 0xFF),        // low byte first
                      (uint8_t)(v >> 8) };        // high byte
     add_tlv_bytes(b, tag, x, 2);
 }
 
 
-static inline void add_tlv_i16(std::vector<uint8_t>& b, uint8_t tag, int16_t v) {
+template <class Buf>
+static inline void add_tlv_i16(Buf& b, uint8_t tag, int16_t v) {
     add_tlv_u16(b, tag, static_cast<uint16_t>(v));
 }
 
 
-static inline void add_tlv_u32(std::vector<uint8_t>& b, uint8_t tag, uint32_t v) {
+template <class Buf>
+static inline void add_tlv_u32(Buf& b, uint8_t tag, uint32_t v) {
     uint8_t x[4] = { (uint8_t)(v & 0xFF),
                      (uint8_t)((v >> 8) & 0xFF),
                      (uint8_t)((v >> 16) & 0xFF),
@@ -80,14 +123,21 @@ static inline void add_tlv_u32(std::vector<uint8_t>& b, uint8_t tag, uint32_t v)
 }
 
 
-static inline void add_tlv_str(std::vector<uint8_t>& b, uint8_t tag, const std::string& s) {
+template <class Buf>
+static inline void add_tlv_str(Buf& b, uint8_t tag, const char* s, size_t n) {
     // Clamp to 255 bytes because TLV length is one byte.
-    const uint8_t L = static_cast<uint8_t>(std::min<size_t>(s.size(), 255));
-    add_tlv_bytes(b, tag, reinterpret_cast<const uint8_t*>(s.data()), L);
+    const uint8_t L = static_cast<uint8_t>(std::min<size_t>(n, 255));
+    add_tlv_bytes(b, tag, reinterpret_cast<const uint8_t*>(s), L);
+}
+
+template <class Buf>
+static inline void add_tlv_str(Buf& b, uint8_t tag, const std::string& s) {
+    add_tlv_str(b, tag, s.data(), s.size());
 }
 
 
-static inline void add_tlv_get(std::vector<uint8_t>& b, uint8_t tag) {
+template <class Buf>
+static inline void add_tlv_get(Buf& b, uint8_t tag) {
     // Special form: ask for this tag’s value via GET_PARAM (no value included).
     add_tlv_bytes(b, tag, nullptr, 0);
 }
@@ -97,8 +147,81 @@ static inline void add_tlv_get(std::vector<uint8_t>& b, uint8_t tag) {
 // Finalize the frame by backfilling the TLV-length field at [3].
 // This makes the packet self-consistent: length = total size minus header.
 // ---------------------------------------------------------------------------
-static inline void finalize(std::vector<uint8_t>& b) {
-    b[3] = static_cast<uint8_t>(b.size() - 4);
+template <class Buf>
+static inline void finalize(Buf& b) {
+    sink_at(b, 3) = static_cast<uint8_t>(sink_size(b) - 4);
+}
+
+
+// ============================================================================
+// Zero-allocation frame building (FrameBuf)
+// ---------------------------------------------------------------------------
+// Public face of the templates above for callers that keep one FrameBuf (and
+// one wire buffer) alive across many requests: session, fan-out, daemon.
+// ============================================================================
+
+void frame_begin(FrameBuf& f, uint8_t verb, uint8_t seq) {
+    f.len = 0;
+    f.overflow = false;
+    put_header(f, verb, seq);
+}
+
+void frame_add_get(FrameBuf& f, uint8_t tag)                 { add_tlv_get(f, tag); }
+void frame_add_u8 (FrameBuf& f, uint8_t tag, uint8_t v)      { add_tlv_u8(f, tag, v); }
+void frame_add_i8 (FrameBuf& f, uint8_t tag, int8_t v)       { add_tlv_i8(f, tag, v); }
+void frame_add_u16(FrameBuf& f, uint8_t tag, uint16_t v)     { add_tlv_u16(f, tag, v); }
+void frame_add_i16(FrameBuf& f, uint8_t tag, int16_t v)      { add_tlv_i16(f, tag, v); }
+void frame_add_u32(FrameBuf& f, uint8_t tag, uint32_t v)     { add_tlv_u32(f, tag, v); }
+void frame_add_str(FrameBuf& f, uint8_t tag, const char* s, size_t n) { add_tlv_str(f, tag, s, n); }
+
+bool frame_finalize(FrameBuf& f) {
+    if (f.overflow || f.len < 4) return false;
+    finalize(f);
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// frame_seal()
+// Finalize + SLIP-encode straight into the caller's wire buffer. The wire
+// array is sized for the worst case (every byte escaped), so encoding can't
+// run out of room; the only failure is an overflowed/empty frame.
+// ---------------------------------------------------------------------------
+bool frame_seal(FrameBuf& f, WireBuf& w) {
+    w.len = 0;
+    if (!frame_finalize(f)) return false;
+    w.len = slip::encode(f.bytes.data(), f.len, w.bytes.data(), w.bytes.size());
+    return w.len != 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// crc_seal() / crc_check()
+// Trailer = CRC-32C over everything before it, flags byte included, so a
+// flipped FLAG_CRC bit can't hide damage from a peer that expects trailers
+// (link_guard.cpp treats an unflagged frame from such a peer as damaged).
+// ---------------------------------------------------------------------------
+void crc_seal(const uint8_t* f, size_t n, std::vector<uint8_t>& out) {
+    out.assign(f, f + n);
+    crc_seal(out);
+}
+
+void crc_seal(std::vector<uint8_t>& f) {
+    if (f.size() < FRAME_HEADER) return;
+    f[1] |= FLAG_CRC | FLAG_CRC_OK;
+    const uint32_t c = crc32c(f.data(), f.size());
+    for (size_t i = 0; i < CRC_LEN; ++i) f.push_back(static_cast<uint8_t>(c >> (8 * i)));
+}
+
+CrcCheck crc_check(const uint8_t* f, size_t n) {
+    if (n < FRAME_HEADER || !(f[1] & FLAG_CRC)) return CrcCheck::None;
+    if (n < FRAME_HEADER + CRC_LEN) return CrcCheck::Bad;
+    const size_t body = n - CRC_LEN;
+    const uint32_t want = static_cast<uint32_t>(f[body]) |
+                          (static_cast<uint32_t>(f[body + 1]) << 8) |
+                          (static_cast<uint32_t>(f[body + 2]) << 16) |
+                          (static_cast<uint32_t>(f[body + 3]) << 24);
+    return crc32c(f, body) == want ? CrcCheck::Ok : CrcCheck::Bad;
 }
 // ============================================================================
 // Convenience builders (thin wrappers around the low-level helpers)
@@ -483,6 +606,16 @@ std::vector<uint8_t> make_get_log_count(uint8_t seq) {
 }
 
 
+// Ask for up to `max` log entries starting at `from` (streamed reply).
+std::vector<uint8_t> make_get_log(uint8_t seq, uint32_t from, uint16_t max) {
+    auto b = header(GET_LOG, seq);
+    add_tlv_u32(b, TAG_LOG_FROM, from);
+    add_tlv_u16(b, TAG_LOG_MAX, max);
+    finalize(b);
+    return b;
+}
+
+
 // ============================================================================
 // Bulk snapshot
 // ---------------------------------------------------------------------------
@@ -494,6 +627,42 @@ std::vector<uint8_t> make_get_all(uint8_t seq) {
     finalize(b);
     return b;
 }
+
+// ============================================================================
+// Batched parameter access
+// ---------------------------------------------------------------------------
+// GET_PARAM and SET_PARAM both accept several TLVs per frame. These builders
+// pack many parameters into one request so a multi-value read/write costs a
+// single serial round trip. The TLV section is capped at 255 bytes because
+// its length lives in the one-byte header field at [3].
+// ============================================================================
+static constexpr size_t MAX_TLV_SECTION = 255;
+
+
+// Ask for several parameters at once: one len=0 TLV per tag.
+std::vector<uint8_t> make_get_params(uint8_t seq, const std::vector<uint8_t>& tags) {
+    if (tags.empty() || tags.size() * 2 > MAX_TLV_SECTION) return {};
+    auto b = header(GET_PARAM, seq);
+    for (uint8_t tag : tags)
+        add_tlv_get(b, tag);
+    finalize(b);
+    return b;
+}
+
+
+// Merge the TLVs of several single-parameter SET_PARAM requests into one frame.
+// Each part went through its own make_set_*() builder, so typing is preserved.
+std::vector<uint8_t> make_set_params(uint8_t seq, const std::vector<std::vector<uint8_t>>& parts) {
+    if (parts.empty()) return {};
+    auto b = header(SET_PARAM, seq);
+    for (const auto& p : parts) {
+        if (p.size() < 4 || p[0] != SET_PARAM) return {};    // only SET_PARAM bodies merge
+        b.insert(b.end(), p.begin() + 4, p.end());           // copy TLVs, skip header
+    }
+    if (b.size() - 4 > MAX_TLV_SECTION) return {};           // would overflow length byte
+    finalize(b);
+    return b;
+}
 // ============================================================================
 // Response decoding
 // ---------------------------------------------------------------------------
@@ -502,99 +671,182 @@ std::vector<uint8_t> make_get_all(uint8_t seq) {
 // ============================================================================
 
 
-// A parsed TLV: tag + raw value string.
-// Note: value may contain '\0' and other binary junk.
-struct Tlv {
-    uint8_t tag;
-    std::string val;
-};
-
-
 // ---------------------------------------------------------------------------
-// Parse TLVs out of a raw frame.
+// TlvCursor
 //
 // Frame layout: [verb][0][seq][TLV_len][TLV...]
 // - Skip first 4 bytes (header).
-// - TLV_len tells us how many bytes follow.
-// - Each TLV: [tag][len][value...]
+// - TLV_len tells us how many bytes follow (clamped to what was received).
+// - Each TLV: [tag][len][value...], handed out as a view into the frame.
 // ---------------------------------------------------------------------------
-static std::vector<Tlv> parse_tlvs(const std::vector<uint8_t>& f) {
-    std::vector<Tlv> tv;
-
-    // Bail early if header not even present
-    if (f.size() < 4)
-        return tv;
-
-    const size_t tl = f[3];                        // total TLV section length
-    size_t off = 4;                                // cursor after header
-    size_t end = std::min(f.size(), size_t(4 + tl));
-
-    // Walk TLVs until we run out
-    while (off + 2 <= end) {
-        uint8_t tag = f[off++];                    // TLV tag
-        uint8_t len = f[off++];                    // TLV length
-
-        // Bounds check: bail if length runs past TLV section
-        if (off + len > end)
-            break;
-
-        // Construct TLV entry with raw bytes as a string
-        tv.push_back({
-            tag,
-            std::string(reinterpret_cast<const char*>(&f[off]),
-                        reinterpret_cast<const char*>(&f[off + len]))
-        });
-
-        off += len;                                // advance cursor
+TlvCursor::TlvCursor(const uint8_t* frame, size_t n) {
+    if (!frame || n < 4) return;                   // header not even present
+    p   = frame + 4;
+    end = frame + std::min(n, size_t(4) + frame[3]);
+}
+
+bool TlvCursor::next(TlvView& t) {
+    if (!p || end - p < 2) return false;           // no room for another tag+len
+    const uint8_t tag = p[0];
+    const uint8_t len = p[1];
+    if (end - (p + 2) < len) {                     // length runs past TLV section
+        truncated = true;
+        p = end;
+        return false;
     }
-
-    return tv;
+    t = TlvView{tag, len, p + 2};
+    p += 2 + len;
+    return true;
 }
 
 
 // ---------------------------------------------------------------------------
 // Safe byte→int helpers (little endian).
-// Each validates string length before decoding. Returns false on mismatch.
+// Each validates the value length before decoding. Returns false on mismatch.
 // ---------------------------------------------------------------------------
-static inline bool as_u8(const std::string& s, uint8_t& out) {
-    if (s.size() != 1) return false;
-    out = static_cast<uint8_t>(static_cast<unsigned char>(s[0]));
+bool TlvView::as_u8(uint8_t& out) const {
+    if (len != 1) return false;
+    out = val[0];
     return true;
 }
 
-static inline bool as_i8(const std::string& s, int8_t& out) {
-    if (s.size() != 1) return false;
-    out = static_cast<int8_t>(static_cast<signed char>(s[0]));
+bool TlvView::as_i8(int8_t& out) const {
+    if (len != 1) return false;
+    out = static_cast<int8_t>(val[0]);
     return true;
 }
 
-static inline bool as_u16(const std::string& s, uint16_t& out) {
-    if (s.size() != 2) return false;
-
-    out = static_cast<uint16_t>(
-              static_cast<uint16_t>(static_cast<uint8_t>(s[0])) |
-             (static_cast<uint16_t>(static_cast<uint8_t>(s[1])) << 8)
-          );
+bool TlvView::as_u16(uint16_t& out) const {
+    if (len != 2) return false;
+    out = static_cast<uint16_t>(val[0] | (val[1] << 8));
     return true;
 }
 
-static inline bool as_i16(const std::string& s, int16_t& out) {
+bool TlvView::as_i16(int16_t& out) const {
     uint16_t u;
-    if (!as_u16(s, u)) return false;
+    if (!as_u16(u)) return false;
     out = static_cast<int16_t>(u);
     return true;
 }
 
-static inline bool as_u32(const std::string& s, uint32_t& out) {
-    if (s.size() != 4) return false;
+bool TlvView::as_u32(uint32_t& out) const {
+    if (len != 4) return false;
+    out =  static_cast<uint32_t>(val[0]) |
+          (static_cast<uint32_t>(val[1]) << 8) |
+          (static_cast<uint32_t>(val[2]) << 16) |
+          (static_cast<uint32_t>(val[3]) << 24);
+    return true;
+}
 
-    out =  static_cast<uint32_t>(static_cast<uint8_t>(s[0])) |
-          (static_cast<uint32_t>(static_cast<uint8_t>(s[1])) << 8) |
-          (static_cast<uint32_t>(static_cast<uint8_t>(s[2])) << 16) |
-          (static_cast<uint32_t>(static_cast<uint8_t>(s[3])) << 24);
 
+// ============================================================================
+// decode_reply()
+// ---------------------------------------------------------------------------
+// Typed decode: one pass over the TLVs, straight into NodeReply fields.
+// A TLV whose length doesn't match its wire type is counted as bad and its
+// field left unset, mirroring decode_pretty() which skips it.
+// decode_reply_into() keeps what `r` already holds, so calling it once per
+// frame of a streamed GET_ALL merges the snapshot (later values win).
+// ============================================================================
+bool decode_reply_into(const uint8_t* f, size_t n, NodeReply& r) {
+    if (!f || n < 4) return false;
+
+    if (r.frames == 0) r.seq = f[2];              // seq of the first frame
+    if (r.verb != RESP_ERR) r.verb = f[0];        // an error anywhere sticks
+    ++r.frames;
+
+    TlvCursor cur(f, n);
+    TlvView t;
+    while (cur.next(t)) {
+        bool ok = true;
+        switch (t.tag) {
+            // Identity / System
+            case TAG_ID:         r.id    = t.str(); break;
+            case TAG_ALIAS:      r.alias = t.str(); break;
+            case TAG_FW_VERSION: r.fw    = t.str(); break;
+            case TAG_UPTIME_S:   ok = t.as_u32(r.uptime_s);  break;
+            case TAG_BOOT_TIME:  ok = t.as_u32(r.boot_time); break;
+
+            // Radio
+            case TAG_FREQ_HZ:    ok = t.as_u32(r.freq_hz);   break;
+            case TAG_SF:         ok = t.as_u8(r.sf);         break;
+            case TAG_BW_HZ:      ok = t.as_u32(r.bw_hz);     break;
+            case TAG_CR:         ok = t.as_u8(r.cr);         break;
+            case TAG_TX_PWR_DBM: ok = t.as_i8(r.tx_pwr_dbm); break;
+            case TAG_CHAN:       ok = t.as_u8(r.chan);       break;
+
+            // Behavior
+            case TAG_MODE:       ok = t.as_u8(r.mode);       break;
+            case TAG_HOPS:       ok = t.as_u8(r.hops);       break;
+            case TAG_BEACON_SEC: ok = t.as_u32(r.beacon_s);  break;
+            case TAG_BUF_SIZE:   ok = t.as_u16(r.buf_size);  break;
+            case TAG_ACK_MODE:   ok = t.as_u8(r.ack);        break;
+
+            // Diagnostics
+            case TAG_RSSI_DBM:   ok = t.as_i16(r.rssi_dbm);  break;
+            case TAG_SNR_DB:     ok = t.as_i8(r.snr_db);     break;
+            case TAG_VBAT_MV:    ok = t.as_u16(r.vbat_mv);   break;
+            case TAG_TEMP_C10:   ok = t.as_i16(r.temp_c10);  break;
+            case TAG_FREE_MEM:   ok = t.as_u32(r.free_mem);  break;
+            case TAG_FREE_FLASH: ok = t.as_u32(r.free_flash); break;
+            case TAG_LOG_COUNT:  ok = t.as_u16(r.log_count); break;
+
+            default: ++r.unknown; continue;
+        }
+        if (ok) r.present |= NodeReply::bit(t.tag);
+        else    ++r.bad;
+    }
+    if (cur.truncated) ++r.bad;
     return true;
 }
+
+bool decode_reply(const uint8_t* f, size_t n, NodeReply& r) {
+    r = NodeReply{};
+    return decode_reply_into(f, n, r);
+}
+
+bool decode_reply(const std::vector<uint8_t>& frame, NodeReply& r) {
+    return decode_reply(frame.data(), frame.size(), r);
+}
+
+
+// ---------------------------------------------------------------------------
+// append_pretty()
+// ---------------
+// Append one TLV as " key=value" using the stable key names scripts rely on.
+// Shared by decode_pretty() (one frame) and decode_snapshot() (many frames).
+// Key and wire type come from the tag's PARAMS row; a value whose length
+// doesn't match its type is skipped. Unknown tags fall back to a hex dump.
+// ---------------------------------------------------------------------------
+static void append_pretty(std::ostringstream& os, const TlvView& t) {
+    if (const ParamDef* p = param_for_tag(t.tag)) {
+        if (p->type == WireType::Str) {
+            os << ' ' << p->key << '=' << t.str();
+            return;
+        }
+        int64_t v;
+        if (!param_value(*p, t, v)) return;
+        os << ' ' << p->key << '=';
+        if      (p->display == Display::CrDen)  os << "4/" << v;
+        else if (p->display == Display::Tenths) os << (v / 10.0);
+        else                                    os << v;
+        return;
+    }
+
+    // Unknown / fallback: dump raw bytes as hex
+    os << " tag" << unsigned(t.tag) << "=0x";
+
+    // Save/restore stream flags (so hex formatting doesn’t leak)
+    std::ios_base::fmtflags f0 = os.flags();
+    char fill0 = os.fill();
+
+    for (uint8_t i = 0; i < t.len; ++i)
+        os << std::hex << std::setw(2) << std::setfill('0') << (unsigned)t.val[i];
+
+    os.flags(f0);
+    os.fill(fill0);
+}
+
 // ============================================================================
 // decode_pretty()
 // ---------------------------------------------------------------------------
@@ -620,7 +872,7 @@ std::string decode_pretty(const std::vector<uint8_t>& f) {
     }
 
     uint8_t verb  = f[0];
-    // uint8_t flags = f[1]; // reserved for future use
+    // f[1] holds header flags (FLAG_CRC...); trailers are stripped before decode
     uint8_t seq   = f[2];
 
     // Status verb → human string
@@ -630,140 +882,57 @@ std::string decode_pretty(const std::vector<uint8_t>& f) {
 
     os << " seq=" << unsigned(seq);
 
-    // Walk parsed TLVs and append key=value fields
-    for (auto& t : parse_tlvs(f)) {
-        switch (t.tag) {
+    // Walk TLVs in place and append key=value fields
+    TlvCursor cur(f.data(), f.size());
+    TlvView t;
+    while (cur.next(t))
+        append_pretty(os, t);
+
+    return os.str();
+}
 
-            // ---------------- Identity / System ----------------
-            case TAG_ID:         os << " id=" << t.val; break;
-            case TAG_ALIAS:      os << " alias=" << t.val; break;
-            case TAG_FW_VERSION: os << " fw=" << t.val; break;
-            case TAG_UPTIME_S: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " uptime_s=" << v; 
-                break; 
-            }
-            case TAG_BOOT_TIME: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " boot_time=" << v; 
-                break; 
-            }
-
-            // ---------------- Radio ----------------
-            case TAG_FREQ_HZ: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " freq_hz=" << v; 
-                break; 
-            }
-            case TAG_SF: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " sf=" << unsigned(v); 
-                break; 
-            }
-            case TAG_BW_HZ: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " bw_hz=" << v; 
-                break; 
-            }
-            case TAG_CR: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " cr=4/" << unsigned(v); 
-                break; 
-            }
-            case TAG_TX_PWR_DBM: { 
-                int8_t v; 
-                if (as_i8(t.val, v)) os << " tx_pwr_dbm=" << int(v); 
-                break; 
-            }
-            case TAG_CHAN: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " chan=" << unsigned(v); 
-                break; 
-            }
-
-            // ---------------- Behavior ----------------
-            case TAG_MODE: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " mode=" << unsigned(v); 
-                break; 
-            }
-            case TAG_HOPS: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " hops=" << unsigned(v); 
-                break; 
-            }
-            case TAG_BEACON_SEC: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " beacon_s=" << v; 
-                break; 
-            }
-            case TAG_BUF_SIZE: { 
-                uint16_t v; 
-                if (as_u16(t.val, v)) os << " buf_size=" << v; 
-                break; 
-            }
-            case TAG_ACK_MODE: { 
-                uint8_t v; 
-                if (as_u8(t.val, v)) os << " ack=" << unsigned(v); 
-                break; 
-            }
-
-            // ---------------- Diagnostics ----------------
-            case TAG_RSSI_DBM: { 
-                int16_t v; 
-                if (as_i16(t.val, v)) os << " rssi_dbm=" << v; 
-                break; 
-            }
-            case TAG_SNR_DB: { 
-                int8_t v; 
-                if (as_i8(t.val, v)) os << " snr_db=" << int(v); 
-                break; 
-            }
-            case TAG_VBAT_MV: { 
-                uint16_t v; 
-                if (as_u16(t.val, v)) os << " vbat_mv=" << v; 
-                break; 
-            }
-            case TAG_TEMP_C10: { 
-                int16_t v; 
-                if (as_i16(t.val, v)) os << " temp_c=" << (v / 10.0); 
-                break; 
-            }
-            case TAG_FREE_MEM: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " free_mem=" << v; 
-                break; 
-            }
-            case TAG_FREE_FLASH: { 
-                uint32_t v; 
-                if (as_u32(t.val, v)) os << " free_flash=" << v; 
-                break; 
-            }
-            case TAG_LOG_COUNT: { 
-                uint16_t v; 
-                if (as_u16(t.val, v)) os << " log_count=" << v; 
-                break; 
-            }
-
-            // ---------------- Unknown / fallback ----------------
-            default: {
-                // Dump raw bytes as hex
-                os << " tag" << unsigned(t.tag) << "=0x";
-
-                // Save/restore stream flags (so hex formatting doesn’t leak)
-                std::ios_base::fmtflags f0 = os.flags();
-                char fill0 = os.fill();
-
-                for (unsigned char c : t.val)
-                    os << std::hex << std::setw(2) << std::setfill('0') << (unsigned)c;
-
-                os.flags(f0);
-                os.fill(fill0);
-                break;
-            }
+
+// ============================================================================
+// decode_snapshot()
+// ---------------------------------------------------------------------------
+// Merge the TLVs of several RESP_* frames (a streamed GET_ALL reply) into one
+// line. Status is "error" if any frame was RESP_ERR. A tag repeated in a later
+// frame replaces the earlier value but keeps its first position, so the line
+// reads like a single big frame.
+// ============================================================================
+
+std::string decode_snapshot(const std::vector<std::vector<uint8_t>>& frames) {
+    std::ostringstream os;
+
+    if (frames.empty() || frames.front().size() < 4) {
+        os << "status=error reason=bad_frame";
+        return os.str();
+    }
+
+    bool any_err = false, all_ok = true;
+    std::vector<TlvView> merged;                  // views into `frames`, which outlive this call
+    for (const auto& f : frames) {
+        if (f.size() < 4) continue;
+        any_err = any_err || f[0] == RESP_ERR;
+        all_ok  = all_ok  && f[0] == RESP_OK;
+        TlvCursor cur(f.data(), f.size());
+        TlvView t;
+        while (cur.next(t)) {
+            auto it = std::find_if(merged.begin(), merged.end(),
+                                   [&](const TlvView& m) { return m.tag == t.tag; });
+            if (it != merged.end()) *it = t;       // last value wins
+            else                    merged.push_back(t);
         }
     }
 
+    if (any_err)     os << "status=error";
+    else if (all_ok) os << "status=ok";
+    else             os << "status=unknown";
+
+    os << " seq=" << unsigned(frames.front()[2]);
+    for (const auto& t : merged)
+        append_pretty(os, t);
+
     return os.str();
 }
 
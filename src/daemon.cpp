@@ -0,0 +1,731 @@
+// ============================================================================
+// daemon.cpp — implementation for daemon.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file daemon.cpp
+ */
+
+#include "daemon.hpp"         // run_daemon(), daemon_* client helpers
+#include "commands.hpp"       // GET_ALL verb
+#include "node_registry.hpp"  // discover_nodes(), candidate_devices(), probe_nodes(), open_node(), device_epoch()
+#include "reply_cache.hpp"    // cache_lookup(), cache_update() around each job
+#include "serial_io.hpp"      // open_serial(), write_frame(), close_serial(), set_exclusive_open()
+#include "session.hpp"        // read_reply(), collect_reply()
+#include "stats.hpp"          // --metrics: stats_prometheus(); timeouts
+
+#include <algorithm>          // std::find over the ports a rescan is probing
+#include <atomic>             // stop flag shared by the handler and client threads
+#include <cerrno>             // EINTR, EINVAL, EBUSY
+#include <chrono>             // client-side reply deadlines
+#include <condition_variable> // per-device queue wakeups
+#include <csignal>            // SIGINT/SIGTERM stop the daemon
+#include <cstdlib>            // getenv for the runtime dir
+#include <deque>              // per-device request queue
+#include <filesystem>         // socket directory, canonical device paths
+#include <map>                // device path -> Device
+#include <memory>             // shared ownership of clients/daemon state across threads
+#include <mutex>
+#include <ostream>            // lifecycle log lines
+#include <sstream>            // request line parsing
+#include <thread>             // device workers, client readers
+#include <unordered_map>      // client-side per-socket line buffers
+#include <netinet/in.h>       // sockaddr_in for the --metrics listener
+#include <poll.h>             // poll(2) with a tick so stop signals are noticed
+#include <sys/socket.h>       // socket/bind/listen/accept4/send
+#include <sys/stat.h>         // chmod(2) on the socket
+#include <sys/un.h>           // sockaddr_un
+#include <unistd.h>           // ::read, ::close, ::unlink, getuid
+
+namespace fs = std::filesystem;
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - DAEMON_SEQ_MAX: the daemon's own seq space is 1..DAEMON_SEQ_MAX; the
+//   readiness PINGs of open_node() use 0xF0 and up.
+// - TICK_MS: upper bound on one poll() so a stop signal is noticed promptly.
+// - MAX_LINE: a client line longer than this is a protocol error.
+// ---------------------------------------------------------------------------
+static constexpr uint8_t DAEMON_SEQ_MAX = 0xEF;
+static constexpr int TICK_MS = 1000;
+static constexpr size_t MAX_LINE = 64 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+// Read by every client thread, so atomic rather than node_watch's plain
+// sig_atomic_t (lock-free, hence still safe to set from the handler).
+static std::atomic<bool> stop_requested{false};
+
+static void on_stop_signal(int) { stop_requested = true; }
+
+
+// -------- line / hex helpers --------
+
+static void put_hex(std::string& out, const uint8_t* p, size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back(digits[p[i] >> 4]);
+        out.push_back(digits[p[i] & 0x0F]);
+    }
+}
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool parse_hex(const std::string& s, std::vector<uint8_t>& out) {
+    out.clear();
+    if (s.size() % 2) return false;
+    for (size_t i = 0; i < s.size(); i += 2) {
+        const int hi = hex_nibble(s[i]), lo = hex_nibble(s[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out.push_back(static_cast<uint8_t>(hi << 4 | lo));
+    }
+    return true;
+}
+
+// Whole-line send; MSG_NOSIGNAL so a vanished peer is an error, not SIGPIPE.
+static bool send_all(int fd, const std::string& s) {
+    size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// read_line()
+// -----------
+// Next '\n'-terminated line from fd, buffering the rest in `buf`.
+// Returns 1 with `line` set, 0 on timeout, -1 on EOF/error/oversized line.
+// ---------------------------------------------------------------------------
+static int read_line(int fd, std::string& buf, std::string& line, int timeout_ms) {
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    char chunk[4096];
+    while (true) {
+        const auto nl = buf.find('\n');
+        if (nl != std::string::npos) {
+            line.assign(buf, 0, nl);
+            buf.erase(0, nl + 1);
+            return 1;
+        }
+        if (buf.size() > MAX_LINE) return -1;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - Clock::now()).count();
+        if (left <= 0) return 0;
+        pollfd pfd{fd, POLLIN, 0};
+        int pr = ::poll(&pfd, 1, static_cast<int>(left));
+        if (pr < 0 && errno == EINTR) continue;
+        if (pr < 0) return -1;
+        if (pr == 0) return 0;
+
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;                              // peer closed
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+
+// -------- daemon state --------
+
+/*
+ * Client
+ * ------
+ * One accepted connection. Device workers reply from their own threads, so
+ * every write takes wmu; the fd closes when the last reference goes.
+ */
+struct Client {
+    explicit Client(int f) : fd(f) {}
+    ~Client() { ::close(fd); }
+    void reply(const std::string& line) {
+        std::lock_guard<std::mutex> lk(wmu);
+        send_all(fd, line + "\n");                          // a gone client is not our problem
+    }
+    int fd;
+    std::mutex wmu;
+};
+
+struct Job {
+    std::shared_ptr<Client> client;
+    std::string tag;
+    std::vector<uint8_t> req;
+    int timeout_ms = 1500;
+};
+
+/*
+ * Device
+ * ------
+ * Sole owner of one port: its queue is drained by one worker thread, which
+ * is the only code that ever touches the fd.
+ */
+struct Device {
+    std::string id;               // node ID ("" if targeted by path only)
+    std::string dev;              // canonical device path (map key)
+    std::mutex mu;                // guards q and stop
+    std::condition_variable cv;
+    std::deque<Job> q;
+    bool stop = false;
+    std::thread worker;
+};
+
+struct Daemon {
+    Daemon(const DaemonOptions& o, std::ostream& l) : opt(o), log(l) {}
+    DaemonOptions opt;
+    std::ostream& log;            // only used from run_daemon() and device workers (joined)
+    std::mutex log_mu;
+    std::mutex mu;                // guards roster, devices, stopping and the scan state below
+    bool stopping = false;        // set at shutdown: no new Device (and worker) after it
+    std::vector<NodeInfo> roster;
+    long long roster_epoch = -1;  // device_epoch() the roster was last scanned at
+    bool scanning = false;        // rescan_unowned() is probing with mu released
+    std::vector<std::string> probing;   // ports that scan has open: no Device for them yet
+    std::condition_variable scan_cv;    // notified when the scan has merged its result
+    std::map<std::string, std::unique_ptr<Device>> devices;
+    ReplyCache cache;             // shared by all workers (locks itself)
+};
+
+static std::string canonical_or_self(const std::string& p) {
+    std::error_code ec;
+    auto c = fs::canonical(p, ec);
+    return ec ? p : c.string();
+}
+
+static void log_line(Daemon& d, const std::string& line) {
+    std::lock_guard<std::mutex> lk(d.log_mu);
+    d.log << line << std::endl;
+}
+
+
+// ---------------------------------------------------------------------------
+// device_worker()
+// ---------------
+// Serve one device's queue in order: answer from the cache if it can, open
+// on first use, re-stamp the seq, write, read the reply (or the GET_ALL
+// stream), restore the client's seq, answer. A write failure closes the fd
+// so the next job reopens it; both drop the node's cached values.
+// ---------------------------------------------------------------------------
+static void device_worker(Daemon& d, Device& dv) {
+    int fd = -1;
+    uint8_t seq = 0;
+    std::vector<uint8_t> req, resp;
+    std::vector<std::vector<uint8_t>> frames;
+    CacheLookup cl;
+    const std::string key = dv.id.empty() ? dv.dev : dv.id;
+
+    auto answer = [&](const Job& job, std::vector<std::vector<uint8_t>>& fs, uint8_t client_seq) {
+        std::string line = job.tag + " ok";
+        for (auto& f : fs) {
+            f[2] = client_seq;                              // read_reply() guarantees size > 2
+            line.push_back(' ');
+            put_hex(line, f.data(), f.size());
+        }
+        job.client->reply(line);
+    };
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lk(dv.mu);
+            dv.cv.wait(lk, [&] { return dv.stop || !dv.q.empty(); });
+            if (dv.q.empty()) break;                        // stop requested and drained
+            job = std::move(dv.q.front());
+            dv.q.pop_front();
+        }
+
+        const uint8_t client_seq = job.req[2];
+        if (d.opt.cache && cache_lookup(d.cache, key, job.req, cl)) {
+            frames.assign(1, cl.reply);
+            answer(job, frames, client_seq);
+            continue;
+        }
+        if (!d.opt.cache) cl.fetch = job.req;
+
+        if (fd < 0) {
+            fd = d.opt.boot_delay_ms < 0 ? open_node(dv.dev, d.opt.baud)
+                                         : open_serial(dv.dev, d.opt.baud, d.opt.boot_delay_ms);
+            if (fd < 0) {
+                job.client->reply(job.tag + (errno == EINVAL ? " error baud_unsupported"
+                                           : errno == EBUSY  ? " error port_busy"
+                                                             : " error open_failed"));
+                continue;
+            }
+            log_line(d, "event=open id=" + dv.id + " dev=" + dv.dev);
+        }
+
+        seq = seq >= DAEMON_SEQ_MAX ? 1 : static_cast<uint8_t>(seq + 1);
+        req = cl.fetch;
+        req[2] = seq;
+
+        if (!write_frame(fd, req)) {
+            close_serial(fd);
+            fd = -1;
+            cache_forget(d.cache, key);
+            log_line(d, "event=close id=" + dv.id + " dev=" + dv.dev + " reason=write_failed");
+            job.client->reply(job.tag + " error write_failed");
+            continue;
+        }
+
+        bool ok;
+        bool damaged = false;
+        frames.clear();
+        if (req[0] == GET_ALL) {
+            ok = collect_reply(fd, req, frames, job.timeout_ms, d.opt.idle_gap_ms, &damaged);
+            seq = req[2];                                   // a damaged stream was asked again under later seqs
+        } else {
+            ok = read_reply(fd, seq, resp, job.timeout_ms);
+            if (ok) frames.push_back(resp);
+        }
+        if (d.opt.cache) cache_update(d.cache, key, job.req, cl, frames);   // a timed-out SET still invalidates
+        if (!ok) {
+            if (!damaged) stats_count(fd, Counter::Timeouts);
+            job.client->reply(job.tag + (damaged ? " error damaged" : " error timeout"));
+            continue;
+        }
+        answer(job, frames, client_seq);
+    }
+    close_serial(fd);
+}
+
+
+// ---------------------------------------------------------------------------
+// rescan_unowned()
+// ----------------
+// Probe the candidate ports the daemon has not opened and merge the answers
+// into the roster. Owned ports are never probed: their worker is the only
+// code allowed to touch them. Caller holds d.mu through `lk`.
+//
+// The probe wave runs with d.mu released, so clients of devices that are
+// already known are not held up by it. Ports being probed are listed in
+// d.probing; device_for() won't open a Device on them until the scan ends.
+// A second caller joins the scan in flight instead of starting another, and
+// no scan runs at all while device_epoch() still matches the roster's: with
+// nothing plugged since, an ID that isn't in the roster isn't connected (the
+// same rule as resolve_node()).
+// ---------------------------------------------------------------------------
+static void rescan_unowned(Daemon& d, std::unique_lock<std::mutex>& lk) {
+    if (d.scanning) { d.scan_cv.wait(lk, [&] { return !d.scanning; }); return; }
+    const long long epoch = device_epoch();
+    if (epoch == d.roster_epoch) return;
+
+    std::vector<std::string> devs;
+    for (const auto& c : candidate_devices())
+        if (!d.devices.count(c)) devs.push_back(c);
+    d.roster_epoch = epoch;                                 // stamped before probing: a plug during it rescans
+    if (devs.empty()) return;
+
+    d.scanning = true;
+    d.probing = devs;
+    lk.unlock();
+    std::vector<int> ready, latency;
+    const auto ids = probe_nodes(devs, &ready, &latency);
+    const long long now = unix_now();
+    lk.lock();
+
+    for (size_t i = 0; i < devs.size(); ++i) {
+        for (auto it = d.roster.begin(); it != d.roster.end(); )
+            it = (it->dev_path == devs[i] || (!ids[i].empty() && it->id == ids[i]))
+               ? d.roster.erase(it) : it + 1;
+        if (!ids[i].empty()) d.roster.push_back({ids[i], devs[i], true, ready[i], now, latency[i]});
+    }
+    const auto roster = d.roster;
+    const long long stamp = d.roster_epoch;
+    d.probing.clear();
+    d.scanning = false;
+    d.scan_cv.notify_all();
+
+    lk.unlock();
+    save_registry(roster, stamp);                           // may wait for another process's lock
+    lk.lock();
+}
+
+
+// ---------------------------------------------------------------------------
+// device_for()
+// ------------
+// Map a request target to its Device, creating (and starting) it on first
+// use. Caller holds d.mu through `lk` (released while a rescan probes).
+// Returns nullptr with `err` set when the target can't be resolved.
+// ---------------------------------------------------------------------------
+static Device* device_for(Daemon& d, std::unique_lock<std::mutex>& lk,
+                          const std::string& target, std::string& err) {
+    if (d.stopping) { err = "shutting_down"; return nullptr; }
+    std::string id, dev;
+
+    if (target == "@auto") {
+        int online = 0;
+        for (const auto& n : d.roster) {
+            if (!n.online) continue;
+            ++online;
+            id = n.id;
+            dev = n.dev_path;
+        }
+        if (online != 1) { err = online ? "multiple_nodes_connected" : "no_nodes_online"; return nullptr; }
+    } else if (!target.empty() && target[0] == '/') {
+        // a roster entry may be an alias of the same port: key by its path
+        dev = canonical_or_self(target);
+        for (const auto& n : d.roster)
+            if (n.online && canonical_or_self(n.dev_path) == dev) { id = n.id; dev = n.dev_path; }
+    } else {
+        auto find = [&] {
+            for (const auto& n : d.roster)
+                if (n.online && n.id == target) { id = n.id; dev = n.dev_path; return true; }
+            return false;
+        };
+        if (!find()) {
+            rescan_unowned(d, lk);
+            if (d.stopping) { err = "shutting_down"; return nullptr; }
+            if (!find()) { err = "node_not_found"; return nullptr; }
+        }
+    }
+
+    // a rescan has this port open right now: wait until it lets go
+    auto probed = [&] { return std::find(d.probing.begin(), d.probing.end(), dev) != d.probing.end(); };
+    if (!d.devices.count(dev) && probed()) {
+        d.scan_cv.wait(lk, [&] { return !d.scanning; });
+        if (d.stopping) { err = "shutting_down"; return nullptr; }
+    }
+
+    auto& slot = d.devices[dev];
+    if (!slot) {
+        slot = std::make_unique<Device>();
+        slot->id = id;
+        slot->dev = dev;
+        Device* raw = slot.get();
+        raw->worker = std::thread([&d, raw] { device_worker(d, *raw); });
+    }
+    return slot.get();
+}
+
+
+// ---------------------------------------------------------------------------
+// handle_line()
+// -------------
+// Parse one client line and either answer at once (list, errors) or queue
+// the job on its device.
+// ---------------------------------------------------------------------------
+static void handle_line(Daemon& d, const std::shared_ptr<Client>& c, const std::string& line) {
+    std::istringstream is(line);
+    std::string verb, tag;
+    is >> verb >> tag;
+    if (tag.empty()) tag = "0";
+
+    if (verb == "list") {
+        std::string out = tag + " nodes";
+        std::lock_guard<std::mutex> lk(d.mu);
+        for (const auto& n : d.roster)
+            if (n.online) out += " " + n.id + "=" + n.dev_path;
+        c->reply(out);
+        return;
+    }
+    if (verb != "req") { c->reply(tag + " error bad_request"); return; }
+
+    std::string target, hex;
+    int timeout_ms = 0;
+    Job job;
+    if (!(is >> target >> timeout_ms >> hex) || timeout_ms <= 0 ||
+        !parse_hex(hex, job.req) || job.req.size() < 4) {
+        c->reply(tag + " error bad_request");
+        return;
+    }
+    job.client = c;
+    job.tag = tag;
+    job.timeout_ms = timeout_ms;
+
+    Device* dv;
+    std::string err;
+    {
+        std::unique_lock<std::mutex> lk(d.mu);
+        dv = device_for(d, lk, target, err);
+    }
+    if (!dv) { c->reply(tag + " error " + err); return; }
+
+    std::lock_guard<std::mutex> lk(dv->mu);
+    if (dv->stop) { c->reply(tag + " error shutting_down"); return; }
+    dv->q.push_back(std::move(job));
+    dv->cv.notify_one();
+}
+
+
+// ---------------------------------------------------------------------------
+// serve_client()
+// --------------
+// Reader thread for one connection. Detached: it owns a reference to the
+// daemon state, and exits on EOF or once a stop is requested.
+// ---------------------------------------------------------------------------
+static void serve_client(std::shared_ptr<Daemon> d, std::shared_ptr<Client> c) {
+    std::string buf, line;
+    while (!stop_requested) {
+        const int r = read_line(c->fd, buf, line, TICK_MS);
+        if (r < 0) break;
+        if (r == 0) continue;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) handle_line(*d, c, line);
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Metrics endpoint (--metrics <port>)
+// -----------------------------------
+// Just enough HTTP/1.0 for a Prometheus scrape: read the request head (or
+// give up after one tick), answer every path with stats_prometheus(), close.
+// Loopback only; anything wider is a reverse proxy's job.
+// ---------------------------------------------------------------------------
+static int listen_metrics(int port) {
+    int s = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return -1;
+    int one = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(static_cast<uint16_t>(port));
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0 || ::listen(s, 16) != 0) {
+        ::close(s);
+        return -1;
+    }
+    return s;
+}
+
+static void serve_metrics(int cfd) {
+    std::string head;
+    char tmp[1024];
+    while (head.find("\r\n\r\n") == std::string::npos && head.size() < MAX_LINE) {
+        pollfd pfd{cfd, POLLIN, 0};
+        if (::poll(&pfd, 1, TICK_MS) <= 0) break;
+        const ssize_t n = ::read(cfd, tmp, sizeof(tmp));
+        if (n <= 0) break;
+        head.append(tmp, static_cast<size_t>(n));
+    }
+
+    std::ostringstream body;
+    stats_prometheus(body);
+    const std::string b = body.str();
+    const std::string out = "HTTP/1.0 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4\r\n"
+                            "Content-Length: " + std::to_string(b.size()) + "\r\n"
+                            "Connection: close\r\n\r\n" + b;
+    for (size_t off = 0; off < out.size();) {
+        const ssize_t n = ::send(cfd, out.data() + off, out.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        off += static_cast<size_t>(n);
+    }
+    ::close(cfd);
+}
+
+
+// -------- public API --------
+
+std::string daemon_socket_path() {
+    const char* x = std::getenv("XDG_RUNTIME_DIR");
+    std::string base = (x && *x) ? std::string(x)
+                                 : (std::string("/run/user/") + std::to_string(getuid()));
+    return base + "/viatext/viatextd.sock";
+}
+
+
+/*
+ * run_daemon()
+ * ------------
+ * 1) Refuse to start over a live daemon; replace a stale socket file.
+ * 2) Seed the roster with one discover_nodes() (saved), then listen.
+ * 3) Accept loop: one detached reader thread per connection.
+ * 4) On SIGINT/SIGTERM: stop listening, drain and join every device worker.
+ */
+int run_daemon(const std::string& socket_path, const DaemonOptions& opt, std::ostream& log) {
+    if (int other = daemon_connect(socket_path); other >= 0) {
+        daemon_close(other);
+        log << "status=error reason=daemon_already_running socket=" << socket_path << std::endl;
+        return 1;
+    }
+
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) return 1;
+    addr.sun_family = AF_UNIX;
+    socket_path.copy(addr.sun_path, socket_path.size());
+
+    std::error_code ec;
+    fs::create_directories(fs::path(socket_path).parent_path(), ec);
+    ::unlink(socket_path.c_str());                          // stale file from a crashed daemon
+
+    int ls = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (ls < 0) return 1;
+    if (::bind(ls, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::chmod(socket_path.c_str(), 0600) != 0 || ::listen(ls, 64) != 0) {
+        ::close(ls);
+        log << "status=error reason=socket_failed socket=" << socket_path << std::endl;
+        return 1;
+    }
+
+    int ms = -1;
+    if (opt.metrics_port > 0) {
+        ms = listen_metrics(opt.metrics_port);
+        if (ms < 0) {
+            ::close(ls);
+            ::unlink(socket_path.c_str());
+            log << "status=error reason=metrics_listen_failed port=" << opt.metrics_port << std::endl;
+            return 1;
+        }
+        stats_enable();
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = on_stop_signal;                         // no SA_RESTART: poll() returns EINTR
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    set_exclusive_open(true);                               // no session/--get-log on our ports meanwhile
+    auto d = std::make_shared<Daemon>(opt, log);
+    d->roster = discover_nodes(&d->roster_epoch);
+    save_registry(d->roster, d->roster_epoch);
+    int online = 0;
+    for (const auto& n : d->roster) online += n.online ? 1 : 0;
+    log_line(*d, "event=listen socket=" + socket_path + " nodes=" + std::to_string(online)
+                 + (ms >= 0 ? " metrics=127.0.0.1:" + std::to_string(opt.metrics_port) : ""));
+
+    while (!stop_requested) {
+        pollfd pfd[2] = {{ls, POLLIN, 0}, {ms, POLLIN, 0}};   // fd -1 is skipped by poll()
+        int pr = ::poll(pfd, 2, TICK_MS);
+        if (pr < 0 && errno != EINTR) break;
+        if (pr <= 0) continue;
+
+        if (pfd[0].revents & POLLIN) {
+            int cfd = ::accept4(ls, nullptr, nullptr, SOCK_CLOEXEC);
+            if (cfd >= 0) std::thread(serve_client, d, std::make_shared<Client>(cfd)).detach();
+        }
+        if (pfd[1].revents & POLLIN) {
+            int cfd = ::accept4(ms, nullptr, nullptr, SOCK_CLOEXEC);
+            if (cfd >= 0) std::thread(serve_metrics, cfd).detach();
+        }
+    }
+
+    ::close(ls);
+    if (ms >= 0) ::close(ms);
+    ::unlink(socket_path.c_str());
+
+    std::lock_guard<std::mutex> lk(d->mu);
+    d->stopping = true;                                     // no new devices from here on
+    for (auto& kv : d->devices) {
+        std::lock_guard<std::mutex> dl(kv.second->mu);
+        kv.second->stop = true;
+        kv.second->cv.notify_one();
+    }
+    for (auto& kv : d->devices) kv.second->worker.join();
+    log_line(*d, "event=stop cache_hits=" + std::to_string(d->cache.hits)
+                 + " cache_misses=" + std::to_string(d->cache.misses));
+    return 0;
+}
+
+
+// -------- client side --------
+
+// Per-connection receive buffers (bytes after the last complete line).
+static std::mutex client_mu;
+static std::unordered_map<int, std::string> client_rx;
+
+int daemon_connect(const std::string& socket_path) {
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) return -1;
+    addr.sun_family = AF_UNIX;
+    socket_path.copy(addr.sun_path, socket_path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    std::lock_guard<std::mutex> lk(client_mu);
+    client_rx[fd].clear();
+    return fd;
+}
+
+void daemon_close(int sock) {
+    if (sock < 0) return;
+    {
+        std::lock_guard<std::mutex> lk(client_mu);
+        client_rx.erase(sock);
+    }
+    ::close(sock);
+}
+
+bool daemon_send(int sock, unsigned tag, const std::string& target,
+                 const std::vector<uint8_t>& req, int timeout_ms) {
+    std::string line = "req " + std::to_string(tag) + " " + target + " " +
+                       std::to_string(timeout_ms) + " ";
+    put_hex(line, req.data(), req.size());
+    line.push_back('\n');
+    return send_all(sock, line);
+}
+
+bool daemon_recv(int sock, unsigned& tag, std::vector<std::vector<uint8_t>>& frames,
+                 std::string& err, int timeout_ms) {
+    std::string* buf;
+    {
+        std::lock_guard<std::mutex> lk(client_mu);
+        buf = &client_rx[sock];                             // node references stay valid
+    }
+    std::string line;
+    if (read_line(sock, *buf, line, timeout_ms) != 1) return false;
+
+    std::istringstream is(line);
+    std::string status, word;
+    if (!(is >> tag >> status)) return false;
+    frames.clear();
+    err.clear();
+    if (status == "error") {
+        is >> err;
+        if (err.empty()) err = "daemon_error";
+        return true;
+    }
+    if (status != "ok") return false;
+    while (is >> word) {
+        frames.emplace_back();
+        if (!parse_hex(word, frames.back())) return false;
+    }
+    return !frames.empty();
+}
+
+bool daemon_request(int sock, const std::string& target, const std::vector<uint8_t>& req,
+                    int timeout_ms, std::vector<std::vector<uint8_t>>& frames, std::string& err) {
+    static constexpr unsigned TAG = 1;
+    if (!daemon_send(sock, TAG, target, req, timeout_ms)) return false;
+    unsigned tag = 0;
+    return daemon_recv(sock, tag, frames, err, timeout_ms + DAEMON_REPLY_MARGIN_MS) && tag == TAG;
+}
+
+bool daemon_list(int sock, std::vector<NodeInfo>& nodes) {
+    nodes.clear();
+    if (!send_all(sock, "list 0\n")) return false;
+
+    std::string* buf;
+    {
+        std::lock_guard<std::mutex> lk(client_mu);
+        buf = &client_rx[sock];
+    }
+    std::string line;
+    if (read_line(sock, *buf, line, DAEMON_REPLY_MARGIN_MS) != 1) return false;
+
+    std::istringstream is(line);
+    std::string tag, kind, item;
+    if (!(is >> tag >> kind) || kind != "nodes") return false;
+    while (is >> item) {
+        const auto eq = item.find('=');
+        if (eq == std::string::npos) continue;
+        nodes.push_back({item.substr(0, eq), item.substr(eq + 1), true});
+    }
+    return true;
+}
+
+} // namespace viatext
@@ -0,0 +1,423 @@
+// ============================================================================
+// fanout.cpp — implementation for fanout.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file fanout.cpp
+ */
+
+#include "fanout.hpp"         // select_targets(), run_fanout()
+#include "commands.hpp"       // GET_ALL verb, make_ping()
+#include "daemon.hpp"         // daemon_send(), daemon_recv() for run_fanout_remote()
+#include "link_guard.hpp"     // link_damage(), LINK_RESENDS: a damaged GET_ALL stream is asked again
+#include "serial_io.hpp"      // open_serial(), Reactor, close_serial()
+#include "session.hpp"        // is_stream_end(), next_request_seq()
+#include "stats.hpp"          // --stats: boot delay, retries, timeouts, decode
+
+#include <algorithm>          // std::max for the learned readiness
+#include <cerrno>             // EINVAL from open_serial(): baud not taken
+#include <chrono>             // readiness and reply deadlines
+#include <cstring>            // strcmp on the error reason
+#include <fnmatch.h>          // fnmatch(3) for ID globs
+#include <ostream>            // result lines
+#include <termios.h>          // tcflush() after a fixed boot delay
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// split_spec()
+// ------------
+// "all, N1 ,gw-*" -> {"all","N1","gw-*"}; empty items are dropped.
+// ---------------------------------------------------------------------------
+static std::vector<std::string> split_spec(const std::string& spec) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        if (comma == std::string::npos) comma = spec.size();
+        const auto b = spec.find_first_not_of(" \t", start);
+        if (b != std::string::npos && b < comma) {
+            const auto e = spec.find_last_not_of(" \t", comma - 1);
+            items.push_back(spec.substr(b, e - b + 1));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+static bool is_glob(const std::string& item) {
+    return item.find_first_of("*?[") != std::string::npos;
+}
+
+
+// ---------------------------------------------------------------------------
+// match_items()
+// -------------
+// One pass of selection over a roster. Returns false if an exact ID was not
+// found (a rescan may help); globs that match nothing are just reported.
+// ---------------------------------------------------------------------------
+static bool match_items(const std::vector<std::string>& items, const std::vector<NodeInfo>& nodes,
+                        std::vector<NodeInfo>& targets, std::vector<std::string>& missing) {
+    targets.clear();
+    missing.clear();
+    std::vector<bool> picked(nodes.size(), false);
+    bool exact_found = true;
+
+    for (const auto& item : items) {
+        bool any = false;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const auto& n = nodes[i];
+            if (!n.online || n.id.empty()) continue;
+            const bool hit = item == "all" ? true
+                           : is_glob(item) ? ::fnmatch(item.c_str(), n.id.c_str(), 0) == 0
+                           : item == n.id;
+            if (!hit) continue;
+            any = true;
+            picked[i] = true;
+        }
+        if (!any) {
+            missing.push_back(item);
+            if (item != "all" && !is_glob(item)) exact_found = false;
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (picked[i]) targets.push_back(nodes[i]);       // registry order, de-duplicated
+    return exact_found;
+}
+
+
+// Render a reply the same way in both paths: GET_ALL merges its stream.
+static void format_frames(const std::vector<uint8_t>& req, const std::vector<std::vector<uint8_t>>& frames,
+                          OutputFormat fmt, std::string& line) {
+    if (req[0] == GET_ALL) format_reply(fmt, frames, line);
+    else                   format_reply(fmt, frames.front(), line);
+}
+
+
+// ---------------------------------------------------------------------------
+// Fanout / Job
+// ------------
+// Every target is a Job on one Reactor, stepping through what run_one() in a
+// worker thread used to do, with each blocking wait turned into a timer:
+//   Boot   fixed --boot-delay: waiting it out
+//   Ready  adaptive: PINGing until the node answers (open_node()'s wait,
+//          same seqs, same registry bookkeeping)
+//   Reply  request written; collecting its reply (GET_ALL: the stream,
+//          ended by a marker or idle_gap_ms of silence)
+// With a FanoutStep, each complete reply goes to it first; a Send result puts
+// the job straight back into Reply with the next request on the same fd.
+// Error reasons match the single-node CLI (open_failed, baud_unsupported,
+// write_failed, timeout).
+// ---------------------------------------------------------------------------
+using Clock = std::chrono::steady_clock;
+
+struct Job {
+    enum class Step { Boot, Ready, Reply, Done };
+    const NodeInfo* node = nullptr;
+    size_t index = 0;             // position in targets (FanoutStep's node)
+    std::vector<uint8_t> req;     // request in flight (or next to send)
+    Step step = Step::Boot;
+    int fd = -1;
+    uint64_t timer = 0;           // pending deadline/retry, 0 if none
+    unsigned attempt = 0;         // readiness PINGs sent so far
+    Clock::time_point t0;         // port opened
+    Clock::time_point opened;     // open_serial() returned: boot delay / readiness starts
+    std::vector<std::vector<uint8_t>> frames;
+    uint32_t damage = 0;          // link_damage() when the request went out
+    int redo = 0;                 // times a damaged GET_ALL stream was asked again
+};
+
+struct Fanout {
+    const FanoutStep& next_step;
+    const FanoutOptions& opt;
+    std::ostream& out;
+    Reactor r;
+    std::vector<Job> jobs;
+    size_t done = 0;
+    int failures = 0;
+
+    Fanout(const FanoutStep& s, const FanoutOptions& o, std::ostream& os)
+        : next_step(s), opt(o), out(os) {}
+
+    // Print the job's line (err == nullptr: it answered) and release its port,
+    // unless the step has another request for it.
+    void finish(Job& j, const char* err) {
+        if (j.step == Job::Step::Done) return;
+
+        std::string line;                                      // before close: stats still know the fd
+        if (err && std::strcmp(err, "timeout") == 0) stats_count(j.fd, Counter::Timeouts);
+        if (next_step) {
+            std::vector<uint8_t> next;
+            const StepNext n = next_step(j.index, err, j.frames, next, line);
+            if (n == StepNext::Send && !err && !next.empty()) {
+                j.req.swap(next);
+                j.frames.clear();
+                j.redo = 0;
+                send_request(j);
+                return;
+            }
+            if (n != StepNext::Done) ++failures;
+        } else if (err) {
+            format_error(opt.fmt, err, 0, line);
+            ++failures;
+        } else {
+            StatsTimer t(j.fd, Phase::Decode);
+            format_frames(j.req, j.frames, opt.fmt, line);
+        }
+
+        r.cancel(j.timer);
+        r.remove(j.fd);
+        close_serial(j.fd);
+        j.fd = -1;
+        j.step = Job::Step::Done;
+        ++done;
+
+        tag_with_node(opt.fmt, j.node->id, line);
+        out << line << '\n';
+        out.flush();
+    }
+
+    // Reply deadline, or GET_ALL's idle gap once something has arrived.
+    void arm_reply(Job& j, int ms) {
+        r.cancel(j.timer);
+        j.timer = r.after(ms, [this, &j] {
+            j.timer = 0;
+            if (!redo_stream(j)) finish(j, j.frames.empty() ? "timeout" : nullptr);
+        });
+    }
+
+    // A GET_ALL stream is over (end marker, idle gap or timeout). If the link
+    // reported damage since it was asked, a frame may be missing: drop what
+    // came and ask again under a new seq, or fail once LINK_RESENDS are spent.
+    // True if the job was handled here.
+    bool redo_stream(Job& j) {
+        if (j.req[0] != GET_ALL || link_damage(j.fd) == j.damage) return false;
+        j.frames.clear();
+        if (j.redo >= LINK_RESENDS) { finish(j, "damaged"); return true; }
+        ++j.redo;
+        j.req[2] = next_request_seq(j.req[2]);        // late frames of the old pass are now stale
+        stats_count(j.fd, Counter::Resends);
+        send_request(j);
+        return true;
+    }
+
+    void send_request(Job& j) {
+        r.cancel(j.timer);
+        j.timer = 0;
+        j.step = Job::Step::Reply;
+        j.damage = link_damage(j.fd);
+        if (!r.send(j.fd, j.req)) { finish(j, "write_failed"); return; }
+        arm_reply(j, opt.timeout_ms);
+    }
+
+    // One readiness PING per READY_RETRY_MS; a node silent past the deadline
+    // gets the request anyway, as open_node() returns the fd regardless.
+    void ping(Job& j) {
+        j.timer = 0;
+        if (Clock::now() >= j.t0 + std::chrono::milliseconds(READY_DEADLINE_MS)) { send_request(j); return; }
+        if (j.attempt > 0) stats_count(j.fd, Counter::Retries);
+        const uint8_t seq = static_cast<uint8_t>(READY_SEQ_BASE | (j.attempt++ & 0x0F));
+        if (!r.send(j.fd, make_ping(seq))) { finish(j, "write_failed"); return; }
+        j.timer = r.after(READY_RETRY_MS, [this, &j] { ping(j); });
+    }
+
+    void on_frame(Job& j, std::vector<uint8_t>& f) {
+        if (f.size() < 3) return;
+        if (j.step == Job::Step::Ready) {
+            const uint8_t last = static_cast<uint8_t>(READY_SEQ_BASE | ((j.attempt - 1) & 0x0F));
+            if (f[2] != last || (f[0] != RESP_OK && f[0] != RESP_ERR)) return;
+            const int waited = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   Clock::now() - j.t0).count());
+            record_ready_ms(j.node->dev_path, j.attempt == 1 ? 0 : std::max(1, waited));
+            stats_time(j.fd, Phase::BootDelay, Clock::now() - j.opened);
+            send_request(j);
+            return;
+        }
+        if (j.step != Job::Step::Reply || f[2] != j.req[2]) return;   // chatter, late PING replies
+
+        j.frames.emplace_back();
+        j.frames.back().swap(f);
+        if (j.req[0] != GET_ALL || is_stream_end(j.frames.back())) {
+            if (!redo_stream(j)) finish(j, nullptr);
+        } else {
+            arm_reply(j, opt.idle_gap_ms);
+        }
+    }
+
+    void start(Job& j) {
+        const std::string& dev = j.node->dev_path;
+        const int known = opt.boot_delay_ms < 0 ? learned_ready_ms(dev) : -1;
+
+        j.t0 = Clock::now();
+        j.fd = open_serial(dev, opt.baud, /*boot_delay_ms*/0);
+        if (j.fd < 0) { finish(j, errno == EINVAL ? "baud_unsupported" : "open_failed"); return; }
+        j.opened = Clock::now();
+        if (!r.add(j.fd, [this, &j](int, std::vector<uint8_t>& f) { on_frame(j, f); },
+                         [this, &j](int) { finish(j, "timeout"); })) {   // hung up: the CLI's read fails the same way
+            finish(j, "open_failed");
+            return;
+        }
+
+        if (opt.boot_delay_ms >= 0) {
+            j.timer = r.after(opt.boot_delay_ms, [this, &j] {
+                stats_time(j.fd, Phase::BootDelay, Clock::now() - j.opened);
+                {
+                    StatsTimer t(j.fd, Phase::Flush);
+                    tcflush(j.fd, TCIOFLUSH);                  // reboot chatter, as open_serial()
+                }
+                send_request(j);
+            });
+        } else if (known == 0) {
+            send_request(j);                                   // learned: answers straight after open
+        } else {
+            j.step = Job::Step::Ready;
+            ping(j);
+        }
+    }
+};
+
+
+// -------- public API --------
+
+/*
+ * select_targets()
+ * ----------------
+ * Fresh registry first; a stale one, or an exact ID it doesn't know, costs
+ * one discover_nodes() (saved, like resolve_node() does).
+ */
+bool select_targets(const std::string& spec, std::vector<NodeInfo>& targets,
+                    std::vector<std::string>& missing) {
+    const auto items = split_spec(spec);
+
+    std::vector<NodeInfo> nodes;
+    const bool fresh = load_registry(nodes);
+    if (!fresh || !match_items(items, nodes, targets, missing)) {
+        long long epoch;
+        nodes = discover_nodes(&epoch);
+        save_registry(nodes, epoch);
+        match_items(items, nodes, targets, missing);
+    }
+    return !targets.empty();
+}
+
+
+void match_targets(const std::string& spec, const std::vector<NodeInfo>& roster,
+                   std::vector<NodeInfo>& targets, std::vector<std::string>& missing) {
+    match_items(split_spec(spec), roster, targets, missing);
+}
+
+
+/*
+ * run_fanout() / run_fanout_steps()
+ * ---------------------------------
+ * Open every target and start its Job, then run the loop until all of them
+ * have printed their line. One thread however many targets there are.
+ */
+int run_fanout(const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+               const FanoutOptions& opt, std::ostream& out) {
+    return run_fanout_steps(targets, req, FanoutStep{}, opt, out);
+}
+
+int run_fanout_steps(const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                     const FanoutStep& step, const FanoutOptions& opt, std::ostream& out) {
+    if (req.empty()) return static_cast<int>(targets.size());
+
+    Fanout f(step, opt, out);
+    f.jobs.resize(targets.size());                       // fixed from here on: callbacks hold Job&
+    for (size_t i = 0; i < targets.size(); ++i) {
+        f.jobs[i].node = &targets[i];
+        f.jobs[i].index = i;
+        f.jobs[i].req = req;
+    }
+    for (auto& j : f.jobs) f.start(j);
+
+    while (f.done < f.jobs.size())
+        if (f.r.run_once(-1) < 0) break;
+    for (auto& j : f.jobs) f.finish(j, "timeout");       // only if epoll itself failed
+    return f.failures;
+}
+
+
+/*
+ * run_fanout_remote() / run_fanout_steps_remote()
+ * -----------------------------------------------
+ * Queue one request per target on the daemon connection (tag = index),
+ * then print replies as they come back; a step's next request is queued
+ * under the same tag and pushes the deadline out. The daemon works the
+ * devices in parallel; anything unanswered by the deadline is reported as
+ * daemon_failed.
+ */
+int run_fanout_remote(int sock, const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                      const FanoutOptions& opt, std::ostream& out) {
+    return run_fanout_steps_remote(sock, targets, req, FanoutStep{}, opt, out);
+}
+
+int run_fanout_steps_remote(int sock, const std::vector<NodeInfo>& targets, const std::vector<uint8_t>& req,
+                            const FanoutStep& step, const FanoutOptions& opt, std::ostream& out) {
+    if (req.empty()) return static_cast<int>(targets.size());
+
+    std::vector<bool> answered(targets.size(), false);
+    std::vector<std::vector<uint8_t>> inflight(targets.size(), req);
+    size_t pending = 0;
+    for (size_t i = 0; i < targets.size(); ++i)
+        if (daemon_send(sock, static_cast<unsigned>(i), targets[i].id, req, opt.timeout_ms)) ++pending;
+
+    int failures = 0;
+    const auto window = std::chrono::milliseconds(opt.timeout_ms + DAEMON_REPLY_MARGIN_MS);
+    auto deadline = std::chrono::steady_clock::now() + window;
+    std::vector<std::vector<uint8_t>> frames;
+    std::string err;
+    while (pending) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+        unsigned tag = 0;
+        if (left <= 0 || !daemon_recv(sock, tag, frames, err, static_cast<int>(left))) break;
+        if (tag >= targets.size() || answered[tag]) continue;
+
+        std::string line;
+        if (step) {
+            std::vector<uint8_t> next;
+            const StepNext n = step(tag, err.empty() ? nullptr : err.c_str(), frames, next, line);
+            if (n == StepNext::Send && err.empty() && !next.empty() &&
+                daemon_send(sock, tag, targets[tag].id, next, opt.timeout_ms)) {
+                inflight[tag].swap(next);
+                deadline = std::chrono::steady_clock::now() + window;
+                continue;
+            }
+            if (n == StepNext::Send) {                   // the next request didn't go out
+                line.clear();
+                step(tag, "daemon_failed", {}, next, line);
+                ++failures;
+            } else if (n != StepNext::Done) {
+                ++failures;
+            }
+        } else if (err.empty()) {
+            format_frames(inflight[tag], frames, opt.fmt, line);
+        } else {
+            format_error(opt.fmt, err, 0, line);
+            ++failures;
+        }
+        answered[tag] = true;
+        --pending;
+        tag_with_node(opt.fmt, targets[tag].id, line);
+        out << line << '\n';
+        out.flush();
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (answered[i]) continue;
+        std::string line;
+        std::vector<uint8_t> next;
+        if (step) step(i, "daemon_failed", {}, next, line);
+        else      format_error(opt.fmt, "daemon_failed", 0, line);
+        tag_with_node(opt.fmt, targets[i].id, line);
+        out << line << '\n';
+        ++failures;
+    }
+    out.flush();
+    return failures;
+}
+
+} // namespace viatext
@@ -0,0 +1,196 @@
+// ============================================================================
+// link_guard.cpp — implementation for link_guard.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file link_guard.cpp
+ */
+
+#include "link_guard.hpp"     // LinkGuard, link_open(), link_guard()
+#include "commands.hpp"       // FLAG_CRC*, crc_seal(), crc_check(), RESP_NACK, verbs, TlvCursor
+#include "stats.hpp"          // --stats: crc_errors, resends
+
+#include <algorithm>          // std::remove_if, std::find: drop expired and superseded entries
+#include <atomic>             // process-wide default policy
+#include <mutex>              // guards the fd table
+#include <unordered_map>      // fd -> LinkGuard
+
+namespace viatext {
+
+static std::atomic<LinkCrc> default_mode{LinkCrc::Auto};
+
+static std::mutex link_mu;
+static std::unordered_map<int, LinkGuard> link_table;   // node references stay valid across inserts
+
+
+bool parse_link_crc(const std::string& s, LinkCrc& out) {
+    if (s == "auto") { out = LinkCrc::Auto; return true; }
+    if (s == "on")   { out = LinkCrc::On;   return true; }
+    if (s == "off")  { out = LinkCrc::Off;  return true; }
+    return false;
+}
+
+void set_default_link_crc(LinkCrc mode) { default_mode.store(mode, std::memory_order_relaxed); }
+
+LinkCrc default_link_crc() { return default_mode.load(std::memory_order_relaxed); }
+
+
+void link_open(int fd) {
+    if (fd < 0) return;
+    std::lock_guard<std::mutex> lk(link_mu);
+    LinkGuard& g = link_table[fd];
+    g = LinkGuard{};
+    g.fd = fd;
+    g.mode = default_link_crc();
+}
+
+void link_close(int fd) {
+    std::lock_guard<std::mutex> lk(link_mu);
+    link_table.erase(fd);
+}
+
+void set_link_crc(int fd, LinkCrc mode) {
+    std::lock_guard<std::mutex> lk(link_mu);
+    auto it = link_table.find(fd);
+    if (it == link_table.end()) return;
+    it->second.mode = mode;
+    it->second.peer_crc = false;
+    it->second.sent.clear();
+}
+
+LinkGuard* link_guard(int fd) {
+    std::lock_guard<std::mutex> lk(link_mu);
+    auto it = link_table.find(fd);
+    return it == link_table.end() || it->second.mode == LinkCrc::Off ? nullptr : &it->second;
+}
+
+void link_forget(int fd, uint8_t seq) {
+    if (LinkGuard* lg = link_guard(fd)) lg->forget(seq);
+}
+
+uint32_t link_damage(int fd) {
+    const LinkGuard* lg = link_guard(fd);
+    return lg ? lg->damage : 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// outgoing()
+// ----------
+// Before the peer has shown it speaks CRC (Auto), only FLAG_CRC_OK goes out:
+// the invitation. Old firmware never looks at byte [1], so the request is
+// otherwise exactly what it used to be.
+// ---------------------------------------------------------------------------
+const uint8_t* LinkGuard::outgoing(const uint8_t* p, size_t& n) {
+    if (n < FRAME_HEADER) return p;
+    if (peer_crc || mode == LinkCrc::On) {
+        crc_seal(p, n, sealed);
+    } else {
+        sealed.assign(p, p + n);
+        sealed[1] |= FLAG_CRC_OK;
+    }
+    n = sealed.size();
+    return sealed.data();
+}
+
+
+// ---------------------------------------------------------------------------
+// remember()
+// ----------
+// Only what a resend may safely repeat stays: a request replaces one still
+// remembered under its seq (PINGs cycle through 16), a SET replaces older
+// SETs to any of its tags and a PING older PINGs, and entries past their hold
+// time go. Past LINK_OUTSTANDING the oldest goes as well.
+// ---------------------------------------------------------------------------
+static bool is_set(uint8_t verb) { return verb == SET_PARAM || verb == SET_ID; }
+
+void LinkGuard::remember(const uint8_t* frame, size_t n, const uint8_t* wire, size_t wn) {
+    if (n < FRAME_HEADER) return;
+    const uint8_t verb = frame[0], seq = frame[2];
+    if (verb == GET_ALL) return;                        // its readers ask again under a new seq
+
+    Sent s;
+    s.seq = seq;
+    s.verb = verb;
+    if (is_set(verb)) {
+        TlvCursor cur(frame, n);
+        TlvView t;
+        while (cur.next(t)) s.tags.push_back(t.tag);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    auto superseded = [&](const Sent& o) {
+        if (o.until <= now || o.seq == seq) return true;
+        if (verb == PING) return o.verb == PING;
+        if (!is_set(verb) || !is_set(o.verb)) return false;
+        for (uint8_t tag : o.tags)
+            if (std::find(s.tags.begin(), s.tags.end(), tag) != s.tags.end()) return true;
+        return false;
+    };
+    sent.erase(std::remove_if(sent.begin(), sent.end(), superseded), sent.end());
+    if (sent.size() >= LINK_OUTSTANDING) sent.erase(sent.begin());
+
+    s.until = now + std::chrono::milliseconds(LINK_HOLD_MS);
+    s.wire.assign(wire, wire + wn);
+    sent.push_back(std::move(s));
+}
+
+void LinkGuard::forget(uint8_t seq) {
+    sent.erase(std::remove_if(sent.begin(), sent.end(), [&](const Sent& o) { return o.seq == seq; }),
+               sent.end());
+}
+
+
+// ---------------------------------------------------------------------------
+// accept()
+// --------
+// 1) Trailer: Bad drops the frame. A peer that sealed before and now sends
+//    none had FLAG_CRC flipped on the way, so that is damage as well.
+// 2) RESP_NACK: the node's own CRC check failed; nothing to deliver.
+// 3) Retire the request the frame answers.
+// ---------------------------------------------------------------------------
+bool LinkGuard::accept(std::vector<uint8_t>& f) {
+    if (f.size() < FRAME_HEADER) return true;          // callers reject runts themselves
+
+    switch (crc_check(f.data(), f.size())) {
+    case CrcCheck::Bad:
+        stats_count(fd, Counter::CrcErrors);
+        return false;
+    case CrcCheck::Ok:
+        f.resize(f.size() - CRC_LEN);
+        peer_crc = true;
+        break;
+    case CrcCheck::None:
+        if (peer_crc) { stats_count(fd, Counter::CrcErrors); return false; }
+        break;
+    }
+
+    if (f[0] == RESP_NACK) {
+        stats_count(fd, Counter::CrcErrors);
+        return false;
+    }
+
+    forget(f[2]);
+    return true;
+}
+
+
+size_t LinkGuard::resend(std::vector<uint8_t>& out) {
+    out.clear();
+    ++damage;
+    const auto now = std::chrono::steady_clock::now();
+    sent.erase(std::remove_if(sent.begin(), sent.end(), [&](const Sent& o) { return o.until <= now; }),
+               sent.end());
+    size_t n = 0;
+    for (auto& s : sent) {
+        if (s.resends >= LINK_RESENDS) continue;
+        ++s.resends;
+        out.insert(out.end(), s.wire.begin(), s.wire.end());
+        ++n;
+    }
+    if (n) stats_count(fd, Counter::Resends, n);
+    return n;
+}
+
+} // namespace viatext
@@ -0,0 +1,363 @@
+// ============================================================================
+// log_pull.cpp — implementation for log_pull.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file log_pull.cpp
+ */
+
+#include "log_pull.hpp"       // LogPullOptions, run_log_pull()
+#include "commands.hpp"       // make_get_log(), make_get_log_count(), TlvCursor
+#include "node_registry.hpp"  // open_node() for --boot-delay auto
+#include "serial_io.hpp"      // open_serial(), write_frame(), read_frame(), close_serial()
+#include "session.hpp"        // read_reply()
+#include "stats.hpp"          // --stats: range timeouts and re-asks
+
+#include <algorithm>          // std::min over range ends
+#include <cctype>             // isdigit(): the last line must start with an index
+#include <cerrno>             // EINTR on output writes, EBUSY from open_serial()
+#include <chrono>             // range deadlines, transfer time
+#include <cstdlib>            // strtoull() of the last record's index
+#include <deque>              // ranges in flight, oldest first
+#include <fcntl.h>            // open(2) of the output file
+#include <map>                // records that arrived ahead of a gap
+#include <ostream>            // summary and error lines
+#include <sys/stat.h>         // fstat(2): regular file or not
+#include <unistd.h>           // read/write/ftruncate/fdatasync/usleep
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - SEQ_MAX: stay below the readiness PING range (0xF0..0xFF).
+// - FLUSH_BYTES: output buffer size that forces a write between ranges.
+// - REOPEN_WAIT_MS: pause before each reopen, time for a replug to settle.
+// ---------------------------------------------------------------------------
+static constexpr uint8_t SEQ_MAX    = 0xEF;
+static constexpr size_t FLUSH_BYTES = 64 * 1024;
+static constexpr int REOPEN_WAIT_MS = 1000;
+
+using Clock = std::chrono::steady_clock;
+
+
+// -------- output file --------
+
+void format_log_record(uint32_t index, const uint8_t* entry, size_t len, std::string& out) {
+    static const char HEX[] = "0123456789abcdef";
+    out += std::to_string(index);
+    out.push_back(' ');
+    for (size_t i = 0; i < len; ++i) {
+        const uint8_t c = entry[i];
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20 || c == 0x7F) {
+                out += "\\x";
+                out.push_back(HEX[c >> 4]);
+                out.push_back(HEX[c & 0x0F]);
+            } else {
+                out.push_back(static_cast<char>(c));
+            }
+        }
+    }
+    out.push_back('\n');
+}
+
+/*
+ * log_resume_point()
+ * ------------------
+ * Reads backwards from the end in blocks until the last '\n'. The line
+ * before it must start with an index and a space (the last record written);
+ * only then is everything after it, a torn record, cut off. A non-empty file
+ * without such a line is refused untouched.
+ */
+bool log_resume_point(const std::string& path, uint32_t& next) {
+    next = 0;
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+    // tail = bytes [at, size); grow it backwards until it holds the last
+    // complete line, i.e. a '\n' and the '\n' (or file start) before it.
+    std::string tail;
+    off_t at = st.st_size;
+    size_t nl = std::string::npos, start = std::string::npos;
+    char buf[4096];
+    while (at > 0) {
+        const off_t from = at > static_cast<off_t>(sizeof(buf)) ? at - static_cast<off_t>(sizeof(buf)) : 0;
+        const ssize_t n = ::pread(fd, buf, static_cast<size_t>(at - from), from);
+        if (n != at - from) { ::close(fd); return false; }
+        tail.insert(0, buf, static_cast<size_t>(n));
+        at = from;
+        nl = tail.rfind('\n');
+        if (nl == std::string::npos) continue;
+        const size_t prev = nl == 0 ? std::string::npos : tail.rfind('\n', nl - 1);
+        if (prev != std::string::npos) { start = prev + 1; break; }
+        if (at == 0) { start = 0; break; }
+    }
+
+    // Validate before touching anything: a file we refuse stays as it was.
+    if (nl == std::string::npos) { ::close(fd); return st.st_size == 0; }   // no complete line: not ours
+    const char* p = tail.c_str() + start;
+    char* e = nullptr;
+    const unsigned long long idx = std::isdigit(static_cast<unsigned char>(*p)) ? std::strtoull(p, &e, 10) : 0;
+    if (!e || *e != ' ') { ::close(fd); return false; }         // not a record file
+
+    const off_t keep = at + static_cast<off_t>(nl) + 1;
+    const bool ok = keep == st.st_size || ::ftruncate(fd, keep) == 0;
+    ::close(fd);
+    if (ok) next = static_cast<uint32_t>(idx + 1);
+    return ok;
+}
+
+static bool write_out(int fd, std::string& buf) {
+    size_t off = 0;
+    while (off < buf.size()) {
+        const ssize_t n = ::write(fd, buf.data() + off, buf.size() - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += static_cast<size_t>(n);
+    }
+    buf.clear();
+    return true;
+}
+
+
+// -------- transfer --------
+
+// One GET_LOG on the wire: entries [from, to), replies tagged `seq`.
+struct Range {
+    uint8_t seq;
+    uint32_t from, to;
+    Clock::time_point active;     // sent, or last frame received
+    bool ended = false;           // empty end frame seen
+};
+
+// Everything the download loop carries across reopens.
+struct Pull {
+    const LogPullOptions& opt;
+    int fd = -1;
+    int out = -1;
+    uint32_t count = 0;
+    uint32_t next_write = 0;      // first index not yet in the file
+    uint32_t next_ask = 0;        // first index not yet asked for
+    uint8_t seq = 0;
+    std::deque<Range> inflight;
+    std::map<uint32_t, std::string> ahead;   // formatted records past a gap
+    std::string wbuf;
+    uint64_t requests = 0, retries = 0;
+    int reopens = 0;
+    bool out_failed = false;      // the output file refused a write
+
+    explicit Pull(const LogPullOptions& o) : opt(o) {}
+
+    uint8_t next_seq() { seq = static_cast<uint8_t>(seq % SEQ_MAX + 1); return seq; }
+
+    bool ask(uint32_t from, uint32_t to) {
+        const uint8_t s = next_seq();
+        if (!write_frame(fd, make_get_log(s, from, static_cast<uint16_t>(to - from)))) return false;
+        inflight.push_back({s, from, to, Clock::now()});
+        ++requests;
+        return true;
+    }
+
+    // One record: straight to the buffer if it is next, else parked.
+    void accept(uint32_t idx, const uint8_t* p, size_t n) {
+        if (idx < next_write || idx >= count) return;   // duplicate of a re-ask, or junk
+        if (idx != next_write) {
+            if (!ahead.count(idx)) format_log_record(idx, p, n, ahead[idx]);
+            return;
+        }
+        format_log_record(idx, p, n, wbuf);
+        ++next_write;
+        for (auto it = ahead.begin(); it != ahead.end() && it->first == next_write; it = ahead.erase(it)) {
+            wbuf += it->second;
+            ++next_write;
+        }
+    }
+
+    // First index of r neither written nor parked; r.to if complete.
+    uint32_t first_missing(const Range& r) const {
+        for (uint32_t i = std::max(r.from, next_write); i < r.to; ++i)
+            if (!ahead.count(i)) return i;
+        return r.to;
+    }
+};
+
+static int open_port(const std::string& dev, const LogPullOptions& opt) {
+    return opt.boot_delay_ms < 0 ? open_node(dev, opt.baud) : open_serial(dev, opt.baud, opt.boot_delay_ms);
+}
+
+// GET_PARAM log_count; false if the node didn't answer with one.
+static bool read_log_count(Pull& p, uint32_t& count) {
+    const uint8_t s = p.next_seq();
+    std::vector<uint8_t> resp;
+    if (!write_frame(p.fd, make_get_log_count(s)) || !read_reply(p.fd, s, resp, p.opt.timeout_ms)) return false;
+    TlvCursor cur(resp.data(), resp.size());
+    TlvView t;
+    uint16_t v = 0;
+    while (cur.next(t))
+        if (t.tag == TAG_LOG_COUNT && t.as_u16(v)) { count = v; return true; }
+    return false;
+}
+
+/*
+ * transfer()
+ * ----------
+ * The windowed loop on the current fd. Returns 0 when everything is written,
+ * 1 on a refusal (RESP_ERR) or output error, 2 when the port needs a reopen
+ * (write failed, or `retries` rounds in a row made no progress).
+ */
+static int transfer(Pull& p) {
+    const auto timeout = std::chrono::milliseconds(p.opt.timeout_ms);
+    std::vector<uint8_t> frame;
+    int stalled = 0;                                    // failed rounds since the last progress
+
+    while (p.next_write < p.count) {
+        if (p.inflight.empty() && p.next_ask >= p.count) p.next_ask = p.next_write;    // nothing left to wait for
+        while (p.inflight.size() < static_cast<size_t>(p.opt.window) && p.next_ask < p.count) {
+            const uint32_t to = std::min<uint32_t>(p.count, p.next_ask + static_cast<uint32_t>(p.opt.chunk));
+            if (!p.ask(p.next_ask, to)) return 2;
+            p.next_ask = to;
+        }
+
+        const auto left = p.inflight.front().active + timeout - Clock::now();
+        const int wait = static_cast<int>(std::max<long long>(
+            1, std::chrono::duration_cast<std::chrono::milliseconds>(left).count()));
+        const uint32_t before = p.next_write;
+
+        if (read_frame(p.fd, frame, wait) && frame.size() >= FRAME_HEADER) {
+            for (auto& r : p.inflight) {
+                if (r.seq != frame[2]) continue;
+                if (frame[0] == RESP_ERR) return 1;
+                if (frame[0] != RESP_OK) break;
+                r.active = Clock::now();
+                TlvCursor cur(frame.data(), frame.size());
+                TlvView t;
+                uint32_t idx = 0;
+                bool have_idx = false, any = false;
+                while (cur.next(t)) {
+                    any = true;
+                    if (t.tag == TAG_LOG_INDEX) have_idx = t.as_u32(idx);
+                    else if (t.tag == TAG_LOG_ENTRY && have_idx) { p.accept(idx, t.val, t.len); have_idx = false; }
+                }
+                if (!any) r.ended = true;
+                break;
+            }
+        }
+
+        // Retire finished or silent ranges, oldest first; re-ask what they left out.
+        bool retired = false;
+        while (!p.inflight.empty()) {
+            Range& r = p.inflight.front();
+            const bool silent = Clock::now() - r.active >= timeout;
+            if (!r.ended && !silent) break;
+            if (silent && !r.ended) stats_count(p.fd, Counter::Timeouts);
+            const uint32_t from = p.first_missing(r), to = r.to;
+            p.inflight.pop_front();
+            retired = true;
+            if (from < to) {
+                ++p.retries;
+                stats_count(p.fd, Counter::Retries);
+                if (++stalled > p.opt.retries) return 2;
+                if (!p.ask(from, to)) return 2;
+            }
+        }
+
+        if (p.next_write != before) stalled = 0;
+        if ((retired || p.wbuf.size() >= FLUSH_BYTES) && !p.wbuf.empty() && !write_out(p.out, p.wbuf)) {
+            p.out_failed = true;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * run_log_pull()
+ * --------------
+ * Output + resume point, open, log_count, then transfer() with reopens in
+ * between. The buffer is flushed on every way out, so the file always ends
+ * on a complete record.
+ */
+int run_log_pull(const std::string& dev, const std::string& path, const LogPullOptions& opt,
+                 std::ostream& log) {
+    Pull p(opt);
+    const bool to_stdout = path == "-";
+    if (to_stdout) {
+        p.out = STDOUT_FILENO;
+        p.next_write = opt.from < 0 ? 0 : static_cast<uint32_t>(opt.from);
+    } else if (opt.from >= 0) {
+        p.out = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        p.next_write = static_cast<uint32_t>(opt.from);
+    } else {
+        if (!log_resume_point(path, p.next_write)) {
+            log << "status=error reason=log_file_unreadable file=" << path << "\n";
+            return 1;
+        }
+        p.out = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    if (p.out < 0) {
+        log << "status=error reason=log_file_open_failed file=" << path << "\n";
+        return 1;
+    }
+    const uint32_t first = p.next_write;
+    const auto t0 = Clock::now();
+
+    int rc = 2;
+    bool opened = false, counted = false, busy = false;
+    const char* reason = "timeout";
+    while (true) {
+        p.fd = open_port(dev, opt);
+        if (p.fd < 0 && errno == EBUSY) { busy = true; break; }   // daemon or session owns it
+        if (p.fd >= 0) {
+            opened = true;
+            if (!counted) counted = read_log_count(p, p.count);
+            if (counted) {
+                if (p.next_write > p.count) p.next_write = p.count;
+                p.next_ask = p.next_write;
+                rc = transfer(p);
+            }
+            close_serial(p.fd);
+            p.fd = -1;
+        }
+        if (rc == 1 || rc == 0) break;
+        if (p.reopens >= opt.reopens) break;
+        ++p.reopens;
+        p.inflight.clear();                             // their replies went with the old fd
+        ::usleep(REOPEN_WAIT_MS * 1000);
+    }
+
+    const bool flushed = !p.out_failed && (p.wbuf.empty() || write_out(p.out, p.wbuf));
+    if (!to_stdout) {
+        struct stat st{};
+        if (::fstat(p.out, &st) == 0 && S_ISREG(st.st_mode)) ::fdatasync(p.out);
+        ::close(p.out);
+    }
+    if (!flushed) { rc = 1; reason = "log_file_write_failed"; }
+    else if (rc == 1) reason = "log_refused";
+    else if (busy) reason = "port_busy";
+    else if (!opened) reason = "open_failed";
+    else if (!counted) reason = "no_log_count";
+
+    const long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    if (rc == 0) {
+        log << "status=ok log_count=" << p.count << " from=" << first << " written=" << (p.next_write - first)
+            << " requests=" << p.requests << " retries=" << p.retries << " reopens=" << p.reopens
+            << " ms=" << ms << "\n";
+        return 0;
+    }
+    log << "status=error reason=" << reason
+        << " dev=" << dev << " next=" << p.next_write;
+    if (counted) log << " log_count=" << p.count;
+    log << " written=" << (p.next_write - first) << " reopens=" << p.reopens << "\n";
+    return rc == 1 ? 1 : 3;
+}
+
+} // namespace viatext
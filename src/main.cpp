@@ -1,16 +1,30 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <cstdlib>          // getenv
+#include <cstdlib>          // getenv, strtol
 #include <sys/types.h>      // getuid
 #include <unistd.h>         // access(), getuid
 #include <cstdint>
+#include <cerrno>           // EINVAL/EBUSY from open_serial(): baud not taken, port held
+#include <fstream>          // --session <file>, --poll-out <file>
 #include "CLI11.hpp"
 
 #include "command_dispatch.hpp"   // build_* dispatcher helpers
-#include "commands.hpp"           // decode_pretty()
+#include "commands.hpp"           // GET_ALL verb
 #include "serial_io.hpp"          // open_serial(), write_frame(), read_frame(), close_serial()
-#include "node_registry.hpp"      // discover_nodes(), save_registry(), create_symlinks()
+#include "link_guard.hpp"         // --crc: set_default_link_crc()
+#include "node_registry.hpp"      // discover_nodes(), resolve_node(), open_node(), save_registry(), create_symlinks()
+#include "session.hpp"            // run_session()
+#include "log_pull.hpp"           // --get-log: run_log_pull()
+#include "profile.hpp"            // --apply: parse_profile(), run_apply()
+#include "output_format.hpp"      // --format: format_reply(), csv_header()
+#include "node_watch.hpp"         // watch_nodes()
+#include "fanout.hpp"             // --nodes: select_targets(), run_fanout()
+#include "daemon.hpp"             // --daemon / thin-client: run_daemon(), daemon_request()
+#include "reply_cache.hpp"        // session-mode ReplyCache
+#include "poller.hpp"             // --poll: parse_poll_group(), run_poll()
+#include "mock_node.hpp"          // --mock: run_mock()
+#include "stats.hpp"              // --stats / --metrics: stats_enable(), stats_print()
 
 // Resolve alias path in user runtime dir:
 //   $XDG_RUNTIME_DIR/viatext/viatext-node-<id>
@@ -22,24 +36,93 @@ static std::string alias_for(const std::string& id) {
   return base + "/viatext/viatext-node-" + id;
 }
 
+// --boot-delay: "auto" (-1: readiness PING, learned per device) or a fixed ms sleep.
+static bool parse_boot_delay(const std::string& s, int& ms) {
+  if (s == "auto") { ms = -1; return true; }
+  char* e = nullptr;
+  long v = std::strtol(s.c_str(), &e, 10);
+  if (s.empty() || *e || v < 0 || v > 60000) return false;
+  ms = static_cast<int>(v);
+  return true;
+}
+
+// Open the target: auto waits only as long as the node needs (open_node()),
+// an explicit delay keeps the classic sleep-then-flush.
+static int open_target(const std::string& dev, int baud, int boot_delay_ms) {
+  return boot_delay_ms < 0 ? viatext::open_node(dev, baud)
+                           : viatext::open_serial(dev, baud, boot_delay_ms);
+}
+
+// open_serial() failure line: a refused speed and a port another viatext
+// process holds (daemon, session) are named, anything else is open_failed.
+static void report_open_failure(const std::string& dev, int baud) {
+  if (errno == EINVAL)
+    std::cerr << "status=error reason=baud_unsupported baud=" << baud << " dev=" << dev << "\n";
+  else if (errno == EBUSY)
+    std::cerr << "status=error reason=port_busy dev=" << dev << "\n";
+  else
+    std::cerr << "status=error reason=open_failed dev=" << dev << "\n";
+}
+
+// One request through viatextd; same lines and exit codes as the direct path.
+static int run_remote(int sock, const std::string& target, const std::vector<uint8_t>& req,
+                      int timeout_ms, viatext::OutputFormat fmt) {
+  std::vector<std::vector<uint8_t>> frames;
+  std::string err;
+  const bool answered = viatext::daemon_request(sock, target, req, timeout_ms, frames, err);
+  viatext::daemon_close(sock);
+
+  if (!answered) { std::cerr << "status=error reason=daemon_failed\n"; return 1; }
+  if (err == "timeout") { std::cerr << "status=error reason=timeout\n"; return 3; }
+  if (err == "damaged") { std::cerr << "status=error reason=damaged\n"; return 3; }
+  if (err == "node_not_found") {
+    std::cerr << "status=error reason=node_not_found id=" << target << "\n"; return 4;
+  }
+  if (err == "multiple_nodes_connected") {
+    std::cerr << "status=error reason=multiple_nodes_connected need_target\n"; return 5;
+  }
+  if (err == "no_nodes_online") { std::cerr << "status=error reason=no_nodes_online\n"; return 6; }
+  if (!err.empty()) { std::cerr << "status=error reason=" << err << " dev=" << target << "\n"; return 1; }
+
+  std::string line;
+  if (req[0] == viatext::GET_ALL) viatext::format_reply(fmt, frames, line);
+  else                            viatext::format_reply(fmt, frames.front(), line);
+  if (fmt == viatext::OutputFormat::Csv) std::cout << viatext::csv_header() << "\n";
+  std::cout << line << "\n";
+  return 0;
+}
+
 int main(int argc, char** argv) {
   CLI::App app{"ViaText CLI"};
 
   // ---- legacy commands ----
-  bool get_id=false, ping=false, do_scan=false, make_aliases=false;
+  bool get_id=false, ping=false, do_scan=false, make_aliases=false, do_watch=false;
+  bool do_daemon=false, no_daemon=false, no_cache=false, do_stats=false;
+  int metrics_port=0;
+  std::string socket_path = viatext::daemon_socket_path();   // --socket <path>
   std::string set_id;
 
   // ---- new generic param API ----
   std::string get_name;                 // --get <name>
   std::vector<std::string> set_kv;      // --set <name> <value>
+  std::string session_src;              // --session <file|->
+  std::string apply_src;                // --apply <profile.conf>
+  std::string log_out;                  // --get-log <file|->
+  viatext::LogPullOptions log_opt;      // --log-from/--log-window/--log-chunk
+  std::vector<std::string> poll_kv;     // --poll <interval> <tags> (repeatable)
+  std::string poll_out;                 // --poll-out <file>
+  std::string format_name = "pretty";   // --format pretty|jsonl|csv|raw
 
   // ---- targeting / device ----
   std::string node_id;                  // --node <id>
+  std::string nodes_spec;               // --nodes all|id1,id2|glob
   std::string dev="/dev/ttyACM0";       // --dev <path>
   CLI::Option* opt_dev = app.add_option("--dev", dev, "Serial device (e.g. /dev/serial/by-id/...)");
 
   // ---- io settings ----
-  int timeout_ms=1500, baud=115200, boot_delay_ms=400;
+  int timeout_ms=1500, baud=115200, boot_delay_ms=-1, window=1, idle_gap_ms=200;
+  std::string boot_delay="auto";        // --boot-delay auto|<ms>
+  std::string crc_mode="auto";          // --crc auto|on|off
 
   // legacy flags
   app.add_flag("--get-id", get_id, "Query node ID (legacy)");
@@ -48,73 +131,347 @@ int main(int argc, char** argv) {
 
   // generic param api
   app.add_option("--get", get_name,
-    "Get param: id|alias|fw|uptime|boot_time|freq|sf|bw|cr|tx_pwr|chan|mode|hops|beacon|buf_size|ack|rssi|snr|vbat|temp|free_mem|free_flash|log_count|all");
-  app.add_option("--set", set_kv, "Set param: --set <name> <value>")->expected(2);
+    "Get param: id|alias|fw|uptime|boot_time|freq|sf|bw|cr|tx_pwr|chan|mode|hops|beacon|buf_size|ack|rssi|snr|vbat|temp|free_mem|free_flash|log_count|all"
+    " (comma-separate names to batch: freq,sf,bw)");
+  app.add_option("--set", set_kv, "Set param: --set <name> <value> (repeat to batch into one frame)")
+    ->type_size(2)->expected(1, CLI::detail::expected_max_vector_size);
+  app.add_option("--session", session_src,
+    "Keep the port open and run one command per line from <file> ('-' = stdin)");
+  app.add_option("--apply", apply_src,
+    "Bring nodes to the profile in <file> (name = value lines): read, set only what differs, read back");
+  app.add_option("--get-log", log_out,
+    "Download the node's stored log into <file> ('-' = stdout), resuming after its last record");
+  app.add_option("--log-from", log_opt.from, "With --get-log: start at this index (rewrites <file>)");
+  app.add_option("--log-window", log_opt.window, "With --get-log: ranges in flight (1..16, default 4)");
+  app.add_option("--log-chunk", log_opt.chunk, "With --get-log: entries per range (1..1024, default 64)");
+  app.add_option("--poll", poll_kv,
+    "Sample until stopped: --poll <interval> <tags> (e.g. --poll 5s rssi,snr --poll 1m vbat)")
+    ->type_size(2)->expected(1, CLI::detail::expected_max_vector_size);
+  app.add_option("--poll-out", poll_out, "With --poll: append samples to <file> (default stdout)");
 
   // discovery / targeting
   app.add_flag("--scan", do_scan, "Scan and list nodes (prints id/dev/online), saves registry");
   app.add_flag("--aliases", make_aliases,
                "With --scan: create $XDG_RUNTIME_DIR/viatext/viatext-node-<id> symlinks");
-  app.add_option("--node", node_id, "Target node by ID (resolves device path)");
+  app.add_flag("--watch", do_watch,
+               "Stay running: follow hot-plug events, keep nodes.json and aliases live");
+  CLI::Option* opt_node = app.add_option("--node", node_id, "Target node by ID (resolves device path)");
+  app.add_option("--nodes", nodes_spec,
+    "Run the command on several nodes at once: all | id1,id2 | glob (e.g. 'gw-*')")
+    ->excludes(opt_node)->excludes(opt_dev);
 
   // io tuning
   app.add_option("--timeout", timeout_ms, "Read timeout (ms)");
-  app.add_option("--baud", baud, "Baud rate (default 115200)");
-  app.add_option("--boot-delay", boot_delay_ms, "Delay after open (ms) to let USB reset");
+  app.add_option("--baud", baud, "Baud rate (default 115200; e.g. 921600, 2000000, or any custom rate)");
+  app.add_option("--boot-delay", boot_delay,
+    "After open: auto (default; PING until ready, learned per device) or a fixed delay in ms");
+  app.add_option("--window", window, "With --session: max requests in flight (1..32, default 1)");
+  app.add_option("--idle-gap", idle_gap_ms, "get all: silence (ms) that ends a streamed snapshot");
+  app.add_option("--crc", crc_mode,
+    "Frame CRC: auto (default; used when the node supports it) | on | off. Damage triggers an immediate resend");
+  app.add_option("--format", format_name, "Reply output: pretty (default) | jsonl | csv | raw (hex frames)");
+
+  // daemon
+  app.add_flag("--daemon", do_daemon,
+               "Run as viatextd: own every node's port and serve clients on a Unix socket");
+  app.add_option("--socket", socket_path, "Daemon socket (default $XDG_RUNTIME_DIR/viatext/viatextd.sock)");
+  app.add_flag("--no-daemon", no_daemon, "Open the device directly even if viatextd is running");
+  app.add_flag("--no-cache", no_cache, "Daemon/session: always read parameters from the node");
+  app.add_option("--metrics", metrics_port,
+    "With --daemon: serve Prometheus metrics on http://127.0.0.1:<port>/");
+
+  // instrumentation
+  app.add_flag("--stats", do_stats,
+    "On exit, print per-device phase latencies (p50/p90/p99) and I/O counters to stderr");
+
+  // mock nodes (load testing without radios)
+  viatext::MockOptions mock;
+  mock.count = 0;
+  app.add_option("--mock", mock.count, "Emulate <n> nodes on ptys until stopped (1..1000)");
+  app.add_option("--mock-link", mock.link_prefix,
+    "With --mock: symlink <prefix><i> to each pty (e.g. /dev/ttyACM, so --scan finds them; "
+    "existing paths are never replaced)");
+  app.add_option("--mock-first", mock.first, "With --mock: index of the first node (IDs and links)");
+  app.add_option("--mock-id", mock.id_prefix, "With --mock: ID prefix (default M: M0, M1, ...)");
+  app.add_option("--mock-latency", mock.latency_ms, "With --mock: processing delay per request (ms)");
+  app.add_option("--mock-jitter", mock.jitter_ms, "With --mock: extra random delay 0..<ms> per request");
+  app.add_option("--mock-baud", mock.baud, "With --mock: emulate this link speed (default unthrottled)");
+  app.add_option("--mock-loss", mock.loss_pct, "With --mock: drop this % of reply frames");
+  app.add_option("--mock-corrupt", mock.corrupt_pct,
+    "With --mock: flip one bit in this % of frames (requests and replies)");
+  bool mock_no_crc = false;
+  app.add_flag("--mock-no-crc", mock_no_crc, "With --mock: behave like firmware without CRC trailers");
+  app.add_option("--mock-getall", mock.getall_per_frame, "With --mock: parameters per get-all frame (1..32)");
+  app.add_option("--mock-log", mock.log_entries, "With --mock: stored log entries per node (0..65535)");
+  app.add_option("--mock-seed", mock.seed, "With --mock: RNG seed for jitter/loss/corruption/telemetry (0 = random)");
 
   CLI11_PARSE(app, argc, argv);
 
+  // Installed as (or symlinked to) "viatextd": behave as --daemon
+  {
+    std::string self = argv[0];
+    auto slash = self.rfind('/');
+    if (self.substr(slash == std::string::npos ? 0 : slash + 1) == "viatextd") do_daemon = true;
+  }
+
+  viatext::OutputFormat fmt = viatext::OutputFormat::Pretty;
+  if (!viatext::parse_output_format(format_name, fmt)) {
+    std::cerr << "status=error reason=bad_value:format(pretty|jsonl|csv|raw)\n";
+    return 2;
+  }
+  if (baud <= 0) {
+    std::cerr << "status=error reason=bad_value:baud\n";
+    return 2;
+  }
+  if (!parse_boot_delay(boot_delay, boot_delay_ms)) {
+    std::cerr << "status=error reason=bad_value:boot_delay(auto|0..60000)\n";
+    return 2;
+  }
+  viatext::LinkCrc link_crc;
+  if (!viatext::parse_link_crc(crc_mode, link_crc)) {
+    std::cerr << "status=error reason=bad_value:crc(auto|on|off)\n";
+    return 2;
+  }
+  viatext::set_default_link_crc(link_crc);
+  if (metrics_port < 0 || metrics_port > 65535 || (metrics_port && !do_daemon)) {
+    std::cerr << "status=error reason=bad_value:metrics(1..65535, with --daemon)\n";
+    return 2;
+  }
+
+  // --stats: report on every way out of main() from here on
+  struct StatsReport {
+    bool on;
+    ~StatsReport() { if (on) viatext::stats_print(std::cerr); }
+  } stats_report{do_stats};
+  if (do_stats) viatext::stats_enable();
+
+  // -------- mock mode: emulated nodes for load tests --------
+  if (mock.count != 0) {
+    if (mock.count < 1 || mock.count > 1000)           { std::cerr << "status=error reason=bad_value:mock(1..1000)\n"; return 2; }
+    if (mock.latency_ms < 0 || mock.jitter_ms < 0)     { std::cerr << "status=error reason=bad_value:mock_latency\n"; return 2; }
+    if (mock.baud < 0)                                 { std::cerr << "status=error reason=bad_value:mock_baud\n"; return 2; }
+    if (mock.loss_pct < 0 || mock.loss_pct > 100)      { std::cerr << "status=error reason=bad_value:mock_loss(0..100)\n"; return 2; }
+    if (mock.corrupt_pct < 0 || mock.corrupt_pct > 100) {
+      std::cerr << "status=error reason=bad_value:mock_corrupt(0..100)\n";
+      return 2;
+    }
+    mock.crc = !mock_no_crc;
+    if (mock.getall_per_frame < 1 || mock.getall_per_frame > 32) {
+      std::cerr << "status=error reason=bad_value:mock_getall(1..32)\n";
+      return 2;
+    }
+    if (mock.log_entries < 0 || mock.log_entries > 65535) {
+      std::cerr << "status=error reason=bad_value:mock_log(0..65535)\n";
+      return 2;
+    }
+    return viatext::run_mock(mock, std::cout);
+  }
+
   // -------- scan mode --------
   if (do_scan) {
-    auto nodes = viatext::discover_nodes();
+    long long epoch;
+    auto nodes = viatext::discover_nodes(&epoch);
     for (const auto& n : nodes) {
       std::cout << "id=" << n.id
                 << " dev=" << n.dev_path
                 << " online=" << (n.online ? 1 : 0) << "\n";
     }
-    viatext::save_registry(nodes);
+    viatext::save_registry(nodes, epoch);
     if (make_aliases) viatext::create_symlinks(nodes);
     return 0;
   }
 
+  // -------- watch mode: long-running hot-plug follower --------
+  if (do_watch) {
+    if (viatext::watch_nodes(std::cout) != 0) {
+      std::cerr << "status=error reason=watch_failed\n";
+      return 1;
+    }
+    return 0;
+  }
+
+  // -------- daemon mode: long-running owner of every port --------
+  if (do_daemon) {
+    viatext::DaemonOptions dopt;
+    dopt.baud = baud;
+    dopt.boot_delay_ms = boot_delay_ms;
+    dopt.idle_gap_ms = idle_gap_ms;
+    dopt.cache = !no_cache;
+    dopt.metrics_port = metrics_port;
+    return viatext::run_daemon(socket_path, dopt, std::cout);
+  }
+
   // -------- choose exactly one command (legacy OR generic) --------
   int cmds = 0;
   cmds += get_id ? 1 : 0;
   cmds += ping   ? 1 : 0;
   cmds += (!set_id.empty()) ? 1 : 0;
   cmds += (!get_name.empty()) ? 1 : 0;
-  cmds += (set_kv.size()==2) ? 1 : 0;
+  cmds += (!set_kv.empty()) ? 1 : 0;
+  cmds += (!session_src.empty()) ? 1 : 0;
+  cmds += (!poll_kv.empty()) ? 1 : 0;
+  cmds += (!log_out.empty()) ? 1 : 0;
+  cmds += (!apply_src.empty()) ? 1 : 0;
 
   if (cmds != 1) {
     std::cerr << "status=error reason=need_exactly_one_command\n";
     return 2;
   }
+  if (!nodes_spec.empty() && !session_src.empty()) {
+    std::cerr << "status=error reason=nodes_with_session_unsupported\n";
+    return 2;
+  }
+  if (!nodes_spec.empty() && !log_out.empty()) {
+    std::cerr << "status=error reason=nodes_with_get_log_unsupported\n";
+    return 2;
+  }
+
+  // -------- poll mode: periodic batched sampling until stopped --------
+  if (!poll_kv.empty()) {
+    std::vector<viatext::PollGroup> groups;
+    for (size_t i = 0; i + 1 < poll_kv.size(); i += 2) {
+      viatext::PollGroup g;
+      std::string err;
+      if (!viatext::parse_poll_group(poll_kv[i], poll_kv[i + 1], g, err)) {
+        std::cerr << "status=error reason=" << err << "\n";
+        return 2;
+      }
+      groups.push_back(std::move(g));
+    }
+
+    viatext::PollOptions popt;
+    popt.baud = baud;
+    popt.boot_delay_ms = boot_delay_ms;
+    popt.timeout_ms = timeout_ms;
+
+    // Same targeting as one-shot commands; default is every online node.
+    std::vector<viatext::NodeInfo> targets;
+    std::vector<std::string> missing;
+    const std::string spec = !nodes_spec.empty() ? nodes_spec : !node_id.empty() ? node_id : "all";
+    const int probe = no_daemon ? -1 : viatext::daemon_connect(socket_path);
+    if (probe >= 0) {
+      popt.daemon_socket = socket_path;
+      std::vector<viatext::NodeInfo> roster;
+      if (!viatext::daemon_list(probe, roster)) roster.clear();
+      viatext::daemon_close(probe);
+      if (opt_dev && opt_dev->count() > 0) targets.push_back({"", dev, true});
+      else viatext::match_targets(spec, roster, targets, missing);
+    } else if (opt_dev && opt_dev->count() > 0) {
+      targets.push_back({"", dev, true});
+    } else {
+      viatext::select_targets(spec, targets, missing);
+    }
+    for (const auto& m : missing) std::cerr << "status=error reason=node_not_found id=" << m << "\n";
+    if (targets.empty()) {
+      std::cerr << "status=error reason=no_nodes_online\n";
+      return 6;
+    }
+
+    std::ofstream file;
+    if (!poll_out.empty()) {
+      file.open(poll_out, std::ios::app);
+      if (!file) {
+        std::cerr << "status=error reason=poll_out_open_failed file=" << poll_out << "\n";
+        return 2;
+      }
+    }
+    std::ostream& samples = poll_out.empty() ? std::cout : static_cast<std::ostream&>(file);
+    return viatext::run_poll(targets, groups, popt, samples, std::cerr) ? 7 : 0;
+  }
+
+  // -------- apply mode: profile diff + one SET per node, all nodes at once --------
+  if (!apply_src.empty()) {
+    if (fmt != viatext::OutputFormat::Pretty) {
+      std::cerr << "status=error reason=bad_value:format(pretty with --apply)\n";
+      return 2;
+    }
+    std::ifstream file(apply_src);
+    if (!file) {
+      std::cerr << "status=error reason=profile_open_failed file=" << apply_src << "\n";
+      return 1;
+    }
+    viatext::Profile prof;
+    std::string perr;
+    if (!viatext::parse_profile(file, prof, perr)) {
+      std::cerr << "status=error reason=" << perr << " file=" << apply_src << "\n";
+      return 2;
+    }
+
+    // Same targeting as --poll; default is every online node.
+    std::vector<viatext::NodeInfo> targets;
+    std::vector<std::string> missing;
+    const std::string spec = !nodes_spec.empty() ? nodes_spec : !node_id.empty() ? node_id : "all";
+    const int asock = no_daemon ? -1 : viatext::daemon_connect(socket_path);
+    if (opt_dev && opt_dev->count() > 0) {
+      targets.push_back({dev, dev, true});
+    } else if (asock >= 0) {
+      std::vector<viatext::NodeInfo> roster;
+      if (!viatext::daemon_list(asock, roster)) roster.clear();
+      viatext::match_targets(spec, roster, targets, missing);
+    } else {
+      viatext::select_targets(spec, targets, missing);
+    }
+    for (const auto& m : missing) std::cout << "node=" << m << " status=error reason=node_not_found\n";
+    if (targets.empty()) {
+      if (asock >= 0) viatext::daemon_close(asock);
+      std::cerr << "status=error reason=no_nodes_online\n";
+      return 6;
+    }
+
+    viatext::FanoutOptions aopt;
+    aopt.baud = baud;
+    aopt.boot_delay_ms = boot_delay_ms;
+    aopt.timeout_ms = timeout_ms;
+    const int failures = viatext::run_apply(targets, prof, aopt, asock, std::cout);
+    if (asock >= 0) viatext::daemon_close(asock);
+    return (failures || !missing.empty()) ? 7 : 0;
+  }
+
+  // A running daemon owns the ports: become its thin client. Sessions and log
+  // downloads keep their own fd, since they pipeline on it directly; they take
+  // the port exclusively, so a port the daemon (or another session) has open
+  // fails with port_busy instead of interleaving frames with it.
+  const int dsock = (no_daemon || !session_src.empty() || !log_out.empty())
+                        ? -1 : viatext::daemon_connect(socket_path);
+  if (!session_src.empty() || !log_out.empty()) viatext::set_exclusive_open(true);
 
   // ===== Target resolution =====
   const bool dev_explicit = (opt_dev && opt_dev->count() > 0);
 
-  if (!node_id.empty()) {
+  if (dsock >= 0) {
+    // the daemon resolves IDs, paths and auto-selection itself
+  } else if (!nodes_spec.empty()) {
+    // fan-out: targets come from select_targets() once the request is built
+  } else if (!node_id.empty()) {
     // Try existing alias first
     std::string link = alias_for(node_id);
     if (access(link.c_str(), R_OK) == 0) {
       dev = link;
-    } else {
-      // Live scan to resolve ID -> device
-      auto nodes = viatext::discover_nodes();
-      viatext::save_registry(nodes);
-      bool found = false;
+    } else if (!viatext::resolve_node(node_id, dev)) {
+      // cached registry + targeted probe, full scan only if that misses
+      std::cerr << "status=error reason=node_not_found id=" << node_id << "\n";
+      return 4;
+    }
+  } else if (!dev_explicit) {
+    // No --node and no explicit --dev → auto-select. A fresh registry with a
+    // single online node is trusted after one targeted probe; otherwise scan.
+    std::vector<viatext::NodeInfo> nodes;
+    bool cached = viatext::load_registry(nodes);
+    int cached_online = 0;
+    for (const auto& n : nodes) cached_online += n.online ? 1 : 0;
+
+    if (cached && cached_online == 1) {
       for (const auto& n : nodes) {
-        if (n.online && n.id == node_id) { dev = n.dev_path; found = true; break; }
-      }
-      if (!found) {
-        std::cerr << "status=error reason=node_not_found id=" << node_id << "\n";
-        return 4;
+        if (n.online && viatext::probe_node(n.dev_path) != n.id) cached = false;
       }
+    } else {
+      cached = false;
+    }
+    if (!cached) {
+      long long epoch;
+      nodes = viatext::discover_nodes(&epoch);
+      viatext::save_registry(nodes, epoch);
     }
-  } else if (!dev_explicit) {
-    // No --node and no explicit --dev → auto-select via quick scan
-    auto nodes = viatext::discover_nodes();
-    viatext::save_registry(nodes);
 
     int online_count = 0;
     std::string last_dev;
@@ -137,6 +494,60 @@ int main(int argc, char** argv) {
   }
   // else: explicit --dev provided → use as-is
 
+  // -------- session mode: open once, stream many commands --------
+  if (!session_src.empty()) {
+    if (window < 1 || window > 32) {
+      std::cerr << "status=error reason=bad_value:window(1..32)\n";
+      return 2;
+    }
+
+    std::ifstream file;
+    if (session_src != "-") {
+      file.open(session_src);
+      if (!file) {
+        std::cerr << "status=error reason=session_open_failed file=" << session_src << "\n";
+        return 1;
+      }
+    }
+
+    int fd = open_target(dev, baud, boot_delay_ms);
+    if (fd < 0) {
+      report_open_failure(dev, baud);
+      return 1;
+    }
+
+    // Unsynced, std::cin reads stdin in blocks and in_avail() sees what a pipe
+    // still holds, so run_session() coalesces piped lines as it does a file's.
+    if (session_src == "-") std::ios::sync_with_stdio(false);
+    std::istream& in = (session_src == "-") ? std::cin : static_cast<std::istream&>(file);
+    viatext::ReplyCache cache;
+    int failures = viatext::run_session(fd, in, std::cout, timeout_ms, window, idle_gap_ms, fmt,
+                                        no_cache ? nullptr : &cache, node_id.empty() ? dev : node_id);
+    viatext::close_serial(fd);
+    return failures ? 7 : 0;
+  }
+
+  // -------- log download: windowed GET_LOG ranges over one open port --------
+  if (!log_out.empty()) {
+    if (log_opt.window < 1 || log_opt.window > 16) {
+      std::cerr << "status=error reason=bad_value:log_window(1..16)\n";
+      return 2;
+    }
+    if (log_opt.chunk < 1 || log_opt.chunk > 1024) {
+      std::cerr << "status=error reason=bad_value:log_chunk(1..1024)\n";
+      return 2;
+    }
+    if (log_opt.from < -1 || log_opt.from > 65535) {
+      std::cerr << "status=error reason=bad_value:log_from(0..65535)\n";
+      return 2;
+    }
+    log_opt.timeout_ms = timeout_ms;
+    log_opt.baud = baud;
+    log_opt.boot_delay_ms = boot_delay_ms;
+    // records go to stdout with '-', so the summary moves to stderr
+    return viatext::run_log_pull(dev, log_out, log_opt, log_out == "-" ? std::cerr : std::cout);
+  }
+
   // -------- build request via dispatcher --------
   uint8_t seq = 1;
   std::vector<uint8_t> req;
@@ -150,16 +561,89 @@ int main(int argc, char** argv) {
     if (!viatext::build_param_set_packet(set_kv[0], set_kv[1], seq, req, derr)) {
       std::cerr << "status=error reason=" << derr << "\n"; return 2;
     }
+  } else if (!set_kv.empty()) {
+    // repeated --set: pack every pair into one SET_PARAM frame
+    std::vector<std::pair<std::string, std::string>> kv;
+    for (size_t i = 0; i + 1 < set_kv.size(); i += 2) kv.emplace_back(set_kv[i], set_kv[i + 1]);
+    if (!viatext::build_param_set_batch(kv, seq, req, derr)) {
+      std::cerr << "status=error reason=" << derr << "\n"; return 2;
+    }
   } else {
     if (!viatext::build_legacy_packet(get_id, ping, set_id, seq, req, derr)) {
       std::cerr << "status=error reason=" << derr << "\n"; return 2;
     }
   }
 
+  // -------- through the daemon --------
+  if (dsock >= 0 && !nodes_spec.empty()) {
+    std::vector<viatext::NodeInfo> roster, targets;
+    std::vector<std::string> missing, unmatched;
+    if (!viatext::daemon_list(dsock, roster)) {
+      viatext::daemon_close(dsock);
+      std::cerr << "status=error reason=daemon_failed\n";
+      return 1;
+    }
+    viatext::match_targets(nodes_spec, roster, targets, missing);
+    for (const auto& m : missing) {                 // exact IDs: the daemon may still find them
+      if (m == "all" || m.find_first_of("*?[") != std::string::npos) unmatched.push_back(m);
+      else targets.push_back({m, "", true});
+    }
+    if (fmt == viatext::OutputFormat::Csv) std::cout << "node," << viatext::csv_header() << "\n";
+    for (const auto& m : unmatched) {
+      std::string line;
+      viatext::format_error(fmt, "node_not_found", 0, line);
+      viatext::tag_with_node(fmt, m, line);
+      std::cout << line << "\n";
+    }
+    if (targets.empty()) {
+      viatext::daemon_close(dsock);
+      std::cerr << "status=error reason=no_nodes_online\n";
+      return 6;
+    }
+    viatext::FanoutOptions opt;
+    opt.timeout_ms = timeout_ms;
+    opt.fmt = fmt;
+    const int failures = viatext::run_fanout_remote(dsock, targets, req, opt, std::cout);
+    viatext::daemon_close(dsock);
+    return (failures || !unmatched.empty()) ? 7 : 0;
+  }
+  if (dsock >= 0) {
+    const std::string target = dev_explicit ? dev : !node_id.empty() ? node_id : "@auto";
+    return run_remote(dsock, target, req, timeout_ms, fmt);
+  }
+
+  // -------- fan-out: same request to every selected node, concurrently --------
+  if (!nodes_spec.empty()) {
+    std::vector<viatext::NodeInfo> targets;
+    std::vector<std::string> missing;
+    viatext::select_targets(nodes_spec, targets, missing);
+    if (fmt == viatext::OutputFormat::Csv) std::cout << "node," << viatext::csv_header() << "\n";
+
+    for (const auto& m : missing) {
+      std::string line;
+      viatext::format_error(fmt, "node_not_found", 0, line);
+      viatext::tag_with_node(fmt, m, line);
+      std::cout << line << "\n";
+    }
+    if (targets.empty()) {
+      std::cerr << "status=error reason=no_nodes_online\n";
+      return 6;
+    }
+
+    viatext::FanoutOptions opt;
+    opt.baud = baud;
+    opt.boot_delay_ms = boot_delay_ms;
+    opt.timeout_ms = timeout_ms;
+    opt.idle_gap_ms = idle_gap_ms;
+    opt.fmt = fmt;
+    const int failures = viatext::run_fanout(targets, req, opt, std::cout);
+    return (failures || !missing.empty()) ? 7 : 0;
+  }
+
   // -------- normal request/response over serial --------
-  int fd = viatext::open_serial(dev, baud, boot_delay_ms);
+  int fd = open_target(dev, baud, boot_delay_ms);
   if (fd < 0) {
-    std::cerr << "status=error reason=open_failed dev=" << dev << "\n";
+    report_open_failure(dev, baud);
     return 1;
   }
 
@@ -169,14 +653,42 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  // GET_ALL may stream several frames: collect them all and print one snapshot
+  if (req[0] == viatext::GET_ALL) {
+    std::vector<std::vector<uint8_t>> frames;
+    bool damaged = false;
+    if (!viatext::collect_reply(fd, req, frames, timeout_ms, idle_gap_ms, &damaged)) {
+      if (!damaged) viatext::stats_count(fd, viatext::Counter::Timeouts);
+      viatext::close_serial(fd);
+      std::cerr << (damaged ? "status=error reason=damaged\n" : "status=error reason=timeout\n");
+      return 3;
+    }
+    std::string line;
+    {
+      viatext::StatsTimer t(fd, viatext::Phase::Decode);
+      viatext::format_reply(fmt, frames, line);
+    }
+    if (fmt == viatext::OutputFormat::Csv) std::cout << viatext::csv_header() << "\n";
+    std::cout << line << "\n";
+    viatext::close_serial(fd);
+    return 0;
+  }
+
   std::vector<uint8_t> resp;
-  if (!viatext::read_frame(fd, resp, timeout_ms)) {
+  if (!viatext::read_reply(fd, seq, resp, timeout_ms)) {
+    viatext::stats_count(fd, viatext::Counter::Timeouts);
     viatext::close_serial(fd);
     std::cerr << "status=error reason=timeout\n";
     return 3;
   }
 
-  std::cout << viatext::decode_pretty(resp) << "\n";
+  std::string line;
+  {
+    viatext::StatsTimer t(fd, viatext::Phase::Decode);
+    viatext::format_reply(fmt, resp, line);
+  }
+  if (fmt == viatext::OutputFormat::Csv) std::cout << viatext::csv_header() << "\n";
+  std::cout << line << "\n";
   viatext::close_serial(fd);
   return 0;
 }
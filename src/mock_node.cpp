@@ -0,0 +1,474 @@
+// ============================================================================
+// mock_node.cpp — implementation for mock_node.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file mock_node.cpp
+ */
+
+#include "mock_node.hpp"      // MockNode, MockOptions
+#include "commands.hpp"       // verbs, TAG_*, TlvCursor
+#include "param_table.hpp"    // PARAMS, param_for_tag(), param_value()
+#include "serial_io.hpp"      // Reactor
+#include "slip.hpp"           // END/ESC for wire-time accounting
+
+#include <fcntl.h>            // posix_openpt, open, fcntl
+#include <stdlib.h>           // grantpt, unlockpt, ptsname
+#include <termios.h>          // cfmakeraw on the held slave side
+#include <sys/stat.h>         // lstat/stat: what --mock-link would replace
+#include <unistd.h>           // close, symlink, readlink, unlink, getpid
+#include <algorithm>          // std::max of wire-free and now
+#include <cerrno>             // EEXIST: --mock-link path taken
+#include <csignal>            // SIGINT/SIGTERM stop run_mock()
+#include <cstdio>             // rename: link into place atomically
+#include <ctime>              // boot_time seed
+#include <ostream>            // ready/summary lines
+#include <vector>
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - BITS_PER_BYTE: 8N1 framing, start and stop bit included.
+// - ALIAS_MAX: longest alias a SET may store (as the firmware's buffer).
+// - WANDER_*: spread of successive rssi/snr/temp readings around the seed.
+// ---------------------------------------------------------------------------
+static constexpr int BITS_PER_BYTE = 10;
+static constexpr size_t ALIAS_MAX  = 32;
+static constexpr int WANDER_RSSI   = 4;     // dBm
+static constexpr int WANDER_SNR    = 2;     // dB
+static constexpr int WANDER_TEMP   = 5;     // 0.1 C
+
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Seed values
+ * -----------
+ * What a freshly flashed board on the 915 MHz plan reports. Tags not listed
+ * start at zero (numbers) or empty (strings).
+ */
+struct Seed { uint8_t tag; int64_t num; const char* str; };
+static constexpr Seed SEEDS[] = {
+    {TAG_ALIAS,      0,         "mock"},
+    {TAG_FW_VERSION, 0,         "mock-1.0"},
+    {TAG_FREQ_HZ,    915000000, nullptr},
+    {TAG_SF,         9,         nullptr},
+    {TAG_BW_HZ,      125000,    nullptr},
+    {TAG_CR,         5,         nullptr},
+    {TAG_TX_PWR_DBM, 14,        nullptr},
+    {TAG_HOPS,       3,         nullptr},
+    {TAG_BEACON_SEC, 60,        nullptr},
+    {TAG_BUF_SIZE,   256,       nullptr},
+    {TAG_ACK_MODE,   1,         nullptr},
+    {TAG_RSSI_DBM,   -92,       nullptr},
+    {TAG_SNR_DB,     7,         nullptr},
+    {TAG_VBAT_MV,    3711,      nullptr},
+    {TAG_TEMP_C10,   235,       nullptr},
+    {TAG_FREE_MEM,   180000,    nullptr},
+    {TAG_FREE_FLASH, 1048576,   nullptr},
+    {TAG_LOG_COUNT,  1000,      nullptr},
+};
+
+// Little-endian bytes of v at the width of the row's wire type.
+static std::vector<uint8_t> encode_value(const ParamDef& p, int64_t v) {
+    size_t n = 0;
+    switch (p.type) {
+        case WireType::U8:  case WireType::I8:  n = 1; break;
+        case WireType::U16: case WireType::I16: n = 2; break;
+        case WireType::U32:                     n = 4; break;
+        default: break;
+    }
+    std::vector<uint8_t> out(n);
+    for (size_t i = 0; i < n; ++i) out[i] = static_cast<uint8_t>(static_cast<uint64_t>(v) >> (8 * i));
+    return out;
+}
+
+static int64_t decode_value(const ParamDef& p, const std::vector<uint8_t>& bytes) {
+    const TlvView t{p.tag, static_cast<uint8_t>(bytes.size()), bytes.data()};
+    int64_t v = 0;
+    return param_value(p, t, v) ? v : 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// place_link()
+// ------------
+// Point `link` at `pts` without destroying anything: the symlink is made
+// under a temporary name and renamed into place only when `link` is missing
+// or a dangling symlink (a mock that crashed before removing its own).
+// Anything else (a regular file, a device node, a live link) is left alone
+// and the call fails with errno = EEXIST.
+// ---------------------------------------------------------------------------
+static bool place_link(const std::string& pts, const std::string& link) {
+    struct stat st{};
+    if (::lstat(link.c_str(), &st) == 0 &&
+        !(S_ISLNK(st.st_mode) && ::stat(link.c_str(), &st) != 0 && errno == ENOENT)) {
+        errno = EEXIST;
+        return false;
+    }
+    const std::string tmp = link + ".mock" + std::to_string(::getpid());
+    ::unlink(tmp.c_str());                               // our own leftover, if any
+    if (::symlink(pts.c_str(), tmp.c_str()) < 0) return false;
+    if (::rename(tmp.c_str(), link.c_str()) < 0) {
+        const int err = errno;
+        ::unlink(tmp.c_str());
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+// Still the link place_link() made? Someone may have replaced it since.
+static bool owns_link(const MockNode& n) {
+    char buf[256];
+    const ssize_t len = ::readlink(n.link.c_str(), buf, sizeof(buf));
+    return len > 0 && n.pts.compare(0, std::string::npos, buf, static_cast<size_t>(len)) == 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// mock_open()
+// -----------
+// The slave side stays open for the node's lifetime: with no slave fd open a
+// pty master reports HUP and reads fail with EIO, which would drop the node
+// off the Reactor every time the host closes the port.
+// ---------------------------------------------------------------------------
+bool mock_open(MockNode& n, const std::string& id, const std::string& link) {
+    n = MockNode{};
+    n.master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (n.master < 0) return false;
+    const char* pts = nullptr;
+    if (::grantpt(n.master) < 0 || ::unlockpt(n.master) < 0 || !(pts = ::ptsname(n.master))) {
+        mock_close(n);
+        return false;
+    }
+    n.pts = pts;
+    ::fcntl(n.master, F_SETFL, ::fcntl(n.master, F_GETFL) | O_NONBLOCK);
+    ::fcntl(n.master, F_SETFD, FD_CLOEXEC);
+
+    n.slave = ::open(pts, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    termios tio{};
+    if (n.slave < 0 || ::tcgetattr(n.slave, &tio) < 0) { mock_close(n); return false; }
+    ::cfmakeraw(&tio);                                   // no echo, no line editing
+    ::tcsetattr(n.slave, TCSANOW, &tio);
+
+    if (!link.empty()) {
+        if (!place_link(n.pts, link)) {
+            const int err = errno;
+            mock_close(n);
+            errno = err;
+            return false;
+        }
+        n.link = link;                                   // set only once it is ours to remove
+    }
+
+    for (const auto& p : PARAMS) {
+        if (p.tag == 0) continue;
+        n.values[p.tag] = p.type == WireType::Str ? std::vector<uint8_t>{} : encode_value(p, 0);
+    }
+    for (const auto& s : SEEDS) {
+        const ParamDef* p = param_for_tag(s.tag);
+        if (!p) continue;
+        n.values[s.tag] = s.str ? std::vector<uint8_t>(s.str, s.str + std::char_traits<char>::length(s.str))
+                                : encode_value(*p, s.num);
+    }
+    n.values[TAG_ID].assign(id.begin(), id.end());
+    n.values[TAG_BOOT_TIME] = encode_value(*param_for_tag(TAG_BOOT_TIME), std::time(nullptr));
+    n.started = n.wire_free = Clock::now();
+    return true;
+}
+
+void mock_close(MockNode& n) {
+    if (!n.link.empty() && owns_link(n)) ::unlink(n.link.c_str());
+    if (n.slave >= 0) ::close(n.slave);
+    if (n.master >= 0) ::close(n.master);
+    n.master = n.slave = -1;
+    n.link.clear();
+}
+
+
+// -------- the node --------
+
+// Reply under construction: header plus TLVs, never past the 255-byte length field.
+struct Reply {
+    std::vector<uint8_t> f;
+    Reply(uint8_t verb, uint8_t seq) : f{verb, 0, seq, 0} {}
+    bool add(uint8_t tag, const std::vector<uint8_t>& v) {
+        if (f[3] + 2 + v.size() > 0xFF) return false;
+        f.push_back(tag);
+        f.push_back(static_cast<uint8_t>(v.size()));
+        f.insert(f.end(), v.begin(), v.end());
+        f[3] = static_cast<uint8_t>(f[3] + 2 + v.size());
+        return true;
+    }
+};
+
+// Current value of a tag as read now: uptime runs, telemetry wanders.
+static std::vector<uint8_t> read_value(MockNode& n, uint8_t tag, std::mt19937& rng) {
+    const ParamDef* p = param_for_tag(tag);
+    if (!p) return {};
+    auto wander = [&](int64_t seed, int spread) {
+        return seed + std::uniform_int_distribution<int>(-spread, spread)(rng);
+    };
+    switch (tag) {
+        case TAG_UPTIME_S:
+            return encode_value(*p, std::chrono::duration_cast<std::chrono::seconds>(
+                                        Clock::now() - n.started).count());
+        case TAG_RSSI_DBM: return encode_value(*p, wander(-92, WANDER_RSSI));
+        case TAG_SNR_DB:   return encode_value(*p, wander(7, WANDER_SNR));
+        case TAG_TEMP_C10: return encode_value(*p, wander(decode_value(*p, n.values[tag]), WANDER_TEMP));
+        default:           return n.values[tag];
+    }
+}
+
+// Stored log entry i: deterministic, so a download can be checked against a rerun.
+static std::vector<uint8_t> log_entry(const MockNode& n, uint32_t i) {
+    const auto& id = n.values.at(TAG_ID);
+    const std::string e = "t=" + std::to_string(1700000000u + i * 7u) + " rx from=" +
+                          std::string(id.begin(), id.end()) + "-" + std::to_string(i % 7) +
+                          " rssi=-" + std::to_string(80 + i % 20) + " len=" + std::to_string(12 + i % 40);
+    return std::vector<uint8_t>(e.begin(), e.end());
+}
+
+// A SET value the firmware would take: writable row, right width, in range.
+static bool settable(const ParamDef* p, const TlvView& t) {
+    if (!p || p->set_verb != SET_PARAM) return false;
+    if (p->type == WireType::Str) return t.len <= ALIAS_MAX;
+    int64_t v = 0;
+    return param_value(*p, t, v) && v >= p->lo && v <= p->hi;
+}
+
+void mock_answer(MockNode& n, const std::vector<uint8_t>& req, const MockOptions& opt,
+                 std::mt19937& rng, std::vector<std::vector<uint8_t>>& replies) {
+    replies.clear();
+    if (req.size() < FRAME_HEADER) return;
+    const uint8_t verb = req[0], seq = req[2];
+    TlvCursor cur(req.data(), req.size());
+    TlvView t;
+
+    switch (verb) {
+    case GET_ID: {
+        Reply r(RESP_OK, seq);
+        r.add(TAG_ID, n.values[TAG_ID]);
+        replies.push_back(std::move(r.f));
+        return;
+    }
+    case SET_ID: {
+        if (!cur.next(t) || t.tag != TAG_ID || t.len == 0) break;
+        n.values[TAG_ID].assign(t.val, t.val + t.len);
+        Reply r(RESP_OK, seq);
+        r.add(TAG_ID, n.values[TAG_ID]);
+        replies.push_back(std::move(r.f));
+        return;
+    }
+    case PING:
+        replies.push_back(Reply(RESP_OK, seq).f);
+        return;
+    case GET_PARAM: {
+        Reply r(RESP_OK, seq);
+        while (cur.next(t))
+            if (!r.add(t.tag, read_value(n, t.tag, rng))) break;
+        replies.push_back(std::move(r.f));
+        return;
+    }
+    case SET_PARAM: {
+        std::vector<TlvView> sets;                       // all or nothing
+        while (cur.next(t)) {
+            if (!settable(param_for_tag(t.tag), t)) {
+                Reply r(RESP_ERR, seq);
+                r.add(t.tag, std::vector<uint8_t>(t.val, t.val + t.len));
+                replies.push_back(std::move(r.f));
+                return;
+            }
+            sets.push_back(t);
+        }
+        Reply r(RESP_OK, seq);
+        for (const auto& s : sets) {
+            n.values[s.tag].assign(s.val, s.val + s.len);
+            r.add(s.tag, n.values[s.tag]);
+        }
+        replies.push_back(std::move(r.f));
+        return;
+    }
+    case GET_ALL: {
+        const int per = opt.getall_per_frame < 1 ? 1 : opt.getall_per_frame;
+        Reply r(RESP_OK, seq);
+        int in_frame = 0;
+        for (const auto& p : PARAMS) {
+            if (p.tag == 0 || p.get_verb == 0) continue;
+            const auto v = read_value(n, p.tag, rng);
+            if (in_frame == per || !r.add(p.tag, v)) {
+                replies.push_back(std::move(r.f));
+                r = Reply(RESP_OK, seq);
+                r.add(p.tag, v);
+                in_frame = 0;
+            }
+            ++in_frame;
+        }
+        if (in_frame) replies.push_back(std::move(r.f));
+        replies.push_back(Reply(RESP_OK, seq).f);       // empty frame: end of snapshot
+        return;
+    }
+    case GET_LOG: {
+        uint32_t from = 0;
+        uint16_t max = 0;
+        bool have_from = false, have_max = false;
+        while (cur.next(t)) {
+            if (t.tag == TAG_LOG_FROM) have_from = t.as_u32(from);
+            else if (t.tag == TAG_LOG_MAX) have_max = t.as_u16(max);
+        }
+        if (!have_from || !have_max) break;
+        uint16_t count = 0;
+        const auto& c = n.values[TAG_LOG_COUNT];
+        if (c.size() == 2) count = static_cast<uint16_t>(c[0] | c[1] << 8);
+        const uint32_t to = std::min<uint32_t>(count, from + max);
+        Reply r(RESP_OK, seq);
+        for (uint32_t i = from; i < to; ++i) {
+            const std::vector<uint8_t> idx = {static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8),
+                                              static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 24)};
+            const auto e = log_entry(n, i);
+            if (r.f[3] + 2 + idx.size() + 2 + e.size() > 0xFF) {      // index and entry share a frame
+                replies.push_back(std::move(r.f));
+                r = Reply(RESP_OK, seq);
+            }
+            r.add(TAG_LOG_INDEX, idx);
+            r.add(TAG_LOG_ENTRY, e);
+        }
+        if (r.f[3]) replies.push_back(std::move(r.f));
+        replies.push_back(Reply(RESP_OK, seq).f);       // empty frame: end of range
+        return;
+    }
+    default:
+        break;
+    }
+    replies.push_back(Reply(RESP_ERR, seq).f);
+}
+
+
+// ---------------------------------------------------------------------------
+// mock_attach()
+// -------------
+// Link model per request:
+//   the request may arrive with a bit flipped, and so may each reply frame
+//   (a sealed reply is damaged after sealing, as on a real wire);
+//   start  = max(now, wire_free) + request wire time
+//   ready  = start + latency + jitter
+//   frame k leaves at ready + wire time of frames 0..k, unless it is lost.
+// wire_free moves to the last frame's end, so a node answers one request at
+// a time like the firmware's single loop. With no latency, jitter or baud,
+// replies go out from the read callback itself, without a timer.
+// ---------------------------------------------------------------------------
+static std::chrono::microseconds wire_time(const std::vector<uint8_t>& f, int baud) {
+    if (baud <= 0) return std::chrono::microseconds(0);
+    size_t bytes = f.size() + 2;                          // END on both sides
+    for (uint8_t b : f) bytes += (b == slip::END || b == slip::ESC);
+    return std::chrono::microseconds(bytes * BITS_PER_BYTE * 1000000ull / static_cast<unsigned>(baud));
+}
+
+// One random bit of a decoded frame flipped: what a noisy hub does to a byte.
+static void flip_bit(std::vector<uint8_t>& f, std::mt19937& rng) {
+    if (f.empty()) return;
+    const size_t i = std::uniform_int_distribution<size_t>(0, f.size() - 1)(rng);
+    f[i] ^= static_cast<uint8_t>(1u << std::uniform_int_distribution<int>(0, 7)(rng));
+}
+
+bool mock_attach(Reactor& r, MockNode& n, const MockOptions& opt, std::mt19937& rng) {
+    return r.add(n.master, [&r, &n, &opt, &rng](int fd, std::vector<uint8_t>& req) {
+        ++n.requests;
+        std::uniform_real_distribution<double> pct(0.0, 100.0);
+        if (opt.corrupt_pct > 0 && pct(rng) < opt.corrupt_pct) { ++n.corrupted; flip_bit(req, rng); }
+
+        // Firmware side of the CRC trailer: check it, NACK damage, seal replies when asked
+        std::vector<std::vector<uint8_t>> replies;
+        const CrcCheck check = opt.crc ? crc_check(req.data(), req.size()) : CrcCheck::None;
+        const bool seal = opt.crc && req.size() >= FRAME_HEADER && (req[1] & FLAG_CRC_OK);
+        if (check == CrcCheck::Bad) {
+            ++n.nacks;
+            replies.push_back(Reply(RESP_NACK, 0).f);
+        } else {
+            if (check == CrcCheck::Ok) req.resize(req.size() - CRC_LEN);
+            mock_answer(n, req, opt, rng, replies);
+        }
+        for (auto& f : replies) {
+            if (seal) crc_seal(f);
+            if (opt.corrupt_pct > 0 && pct(rng) < opt.corrupt_pct) { ++n.corrupted; flip_bit(f, rng); }
+        }
+
+        const bool immediate = opt.latency_ms <= 0 && opt.jitter_ms <= 0 && opt.baud <= 0;
+        const auto now = Clock::now();
+        auto at = std::max(now, n.wire_free) + wire_time(req, opt.baud)
+                + std::chrono::milliseconds(opt.latency_ms)
+                + std::chrono::milliseconds(opt.jitter_ms > 0
+                      ? std::uniform_int_distribution<int>(0, opt.jitter_ms)(rng) : 0);
+
+        for (auto& f : replies) {
+            at += wire_time(f, opt.baud);
+            if (opt.loss_pct > 0 && pct(rng) < opt.loss_pct) { ++n.dropped; continue; }
+            ++n.replies;
+            if (immediate) { r.send(fd, f); continue; }
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                at - now + std::chrono::microseconds(999)).count();
+            r.after(static_cast<int>(ms), [&r, fd, f = std::move(f)] { r.send(fd, f); });
+        }
+        n.wire_free = at;
+    });
+}
+
+
+// ---------------------------------------------------------------------------
+// run_mock()
+// ----------
+// All nodes on one Reactor; the stop signal goes through Reactor::stop(),
+// which only writes an eventfd and is safe from a handler.
+// ---------------------------------------------------------------------------
+static Reactor* active_reactor = nullptr;
+
+static void on_stop_signal(int) { if (active_reactor) active_reactor->stop(); }
+
+int run_mock(const MockOptions& opt, std::ostream& out) {
+    std::mt19937 rng(opt.seed ? opt.seed : std::random_device{}());
+    std::vector<MockNode> nodes(static_cast<size_t>(opt.count));
+    Reactor r;
+
+    int rc = 0;
+    for (int i = 0; i < opt.count; ++i) {
+        const std::string idx = std::to_string(opt.first + i);
+        const std::string link = opt.link_prefix.empty() ? "" : opt.link_prefix + idx;
+        MockNode& n = nodes[static_cast<size_t>(i)];
+        if (!mock_open(n, opt.id_prefix + idx, link) || !mock_attach(r, n, opt, rng)) {
+            out << "status=error reason=" << (errno == EEXIST ? "mock_link_exists" : "mock_open_failed")
+                << (link.empty() ? "" : " link=" + link) << "\n" << std::flush;
+            rc = 1;
+            break;
+        }
+        n.values[TAG_LOG_COUNT] = encode_value(*param_for_tag(TAG_LOG_COUNT), opt.log_entries);
+        out << "event=mock_ready id=" << opt.id_prefix << idx << " dev=" << n.pts;
+        if (!n.link.empty()) out << " link=" << n.link;
+        out << "\n";
+    }
+    out << std::flush;
+
+    if (rc == 0) {
+        active_reactor = &r;
+        struct sigaction sa{};
+        sa.sa_handler = on_stop_signal;
+        sigaction(SIGINT,  &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        r.run();
+        active_reactor = nullptr;
+
+        for (const auto& n : nodes) {
+            const auto& id = n.values.at(TAG_ID);
+            out << "event=mock_summary id=" << std::string(id.begin(), id.end())
+                << " requests=" << n.requests << " replies=" << n.replies
+                << " dropped=" << n.dropped << " corrupted=" << n.corrupted
+                << " nacks=" << n.nacks << "\n";
+        }
+    }
+    for (auto& n : nodes) mock_close(n);
+    return rc;
+}
+
+} // namespace viatext
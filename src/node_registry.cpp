@@ -10,20 +10,30 @@
 #include "node_registry.hpp"  // public types and function declarations for the registry layer
 #include "commands.hpp"       // viatext::make_get_id(), viatext::decode_pretty() for probing
 #include "serial_io.hpp"      // viatext::open_serial(), write_frame(), read_frame(), close_serial()
+#include "link_guard.hpp"     // viatext::link_guard(): probe replies carry CRC trailers too
+#include "slip.hpp"           // viatext::slip::decoder, one per in-flight probe
+#include "stats.hpp"          // --stats: scan and readiness timings, PING retries
 
+#include <algorithm>          // std::min for wave sizing, std::remove_if for skipped devices
 #include <filesystem>         // std::filesystem for walking /dev and creating dirs/symlinks
-#include <fstream>            // std::ofstream for writing nodes.json
+#include <fstream>            // std::ifstream for reading nodes.json and probe_skip
 #include <iostream>           // std::cerr for error reporting
-#include <sstream>            // std::ostringstream if we need string assembly (kept for symmetry)
-#include <chrono>             // std::chrono types (boot delays/timeouts are expressed in ms)
-#include <thread>             // std::this_thread::sleep_for (used in serial open delay in serial_io)
-#include <fcntl.h>            // POSIX file controls (serial_io may rely on these headers)
+#include <sstream>            // std::ostringstream to slurp nodes.json for the cache loader
+#include <chrono>             // std::chrono types (boot delays/timeouts/deadlines are expressed in ms)
+#include <fcntl.h>            // open(2) flags for the temp file and the lock file
 #include <unistd.h>           // POSIX calls (getuid(), close, etc.)
 #include <glob.h>             // glob(3) for tty fallbacks when /dev/serial/by-id is absent
+#include <fnmatch.h>          // fnmatch(3) for VID:PID skip patterns
+#include <cctype>             // std::tolower for skip patterns
+#include <iterator>           // std::begin/std::end over the built-in skip list
+#include <poll.h>             // poll(2) to multiplex every in-flight probe on one wait
 #include <cerrno>             // errno access for diagnostics
 #include <system_error>       // std::error_code for non-throwing filesystem ops
-#include <cstdlib>            // getenv for XDG/HOME lookups
-#include <cstring>            // strerror for human-readable errno
+#include <cstdlib>            // getenv for XDG/HOME lookups, strtoll, std::abs on latency deltas
+#include <cstring>            // strerror for human-readable errno, memchr for END bytes
+#include <mutex>              // registry_mu: registry writers may run on several threads (fan-out)
+#include <sys/stat.h>         // stat(2) mtime of the device directory (cache invalidation)
+#include <sys/file.h>         // flock(2) on nodes.json.lock between processes
 
 namespace fs = std::filesystem;   // short handle; used heavily below
 namespace viatext {
@@ -31,55 +41,263 @@ namespace viatext {
 // ---------------------------------------------------------------------------
 // Probe-time constants (tuned for USB CDC/tty experience).
 // - PROBE_BAUD:   default via firmware; adjust only if firmware changes.
-// - PROBE_TIMEOUT_MS: read timeout per device so the whole scan stays bounded.
-// - PROBE_BOOT_MS: time to let a port settle after open (USB CDC sometimes re-enumerates).
+// - PROBE_TIMEOUT_MS: deadline per probe wave so the whole scan stays bounded;
+//   covers a node that resets on open (~400 ms boot) plus its first reply.
+// - PROBE_RETRY_MS: GET_ID is re-sent this often until a port answers; a
+//   node that is already up replies well inside one interval.
+// - PROBE_QUIET_MS: a port that has not sent a single SLIP END by then is
+//   dropped from the wave; a resetting node is up and has answered well
+//   before, so only silent modems and the like hit this.
+// - PROBE_NOISE_MAX: bytes a port may send without any END before it is
+//   taken for a non-SLIP talker (GPS NMEA, modem banners) and dropped.
+// - PROBE_MAX_INFLIGHT: devices opened at once; larger hosts probe in waves of this size.
 // ---------------------------------------------------------------------------
-static constexpr int PROBE_BAUD       = 115200;
-static constexpr int PROBE_TIMEOUT_MS = 1200;   // ms per device (read_frame timeout)
-static constexpr int PROBE_BOOT_MS    = 400;    // ms after open to let USB CDC reset
+static constexpr int PROBE_BAUD         = 115200;
+static constexpr int PROBE_TIMEOUT_MS   = 1600;   // ms per wave (shared by all devices in it)
+static constexpr int PROBE_RETRY_MS     = 100;    // ms between GET_ID attempts on a silent port
+static constexpr int PROBE_QUIET_MS     = 700;    // ms without any END before a port is given up
+static constexpr size_t PROBE_NOISE_MAX = 256;    // bytes without an END: not speaking SLIP
+static constexpr size_t PROBE_MAX_INFLIGHT = 32;  // bound on simultaneously open probe fds
+
+using Clock = std::chrono::steady_clock;
+
+static int ms_since(Clock::time_point t0) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                Clock::now() - t0).count());
+}
 
 
 // -------- helpers --------
 
 /*
- * probe_id()
- * ----------
- * Open a candidate serial device, send GET_ID, and extract the ID string
- * from the pretty-decoded response line. Quietly returns {} on any failure.
+ * id_from_response()
+ * ------------------
+ * The TAG_ID value of a RESP_OK, read straight from its TLVs; "" if the
+ * frame carries none (not a GET_ID reply, or not a ViaText node at all).
+ */
+static std::string id_from_response(const std::vector<uint8_t>& resp) {
+    viatext::TlvCursor cur(resp.data(), resp.size());
+    viatext::TlvView t;
+    while (cur.next(t))
+        if (t.tag == viatext::TAG_ID) return std::string(reinterpret_cast<const char*>(t.val), t.len);
+    return {};
+}
+
+
+/*
+ * ProbeSlot
+ * ---------
+ * State for one device inside a probe wave: its fd, a private SLIP decoder
+ * (bytes from different ports must never mix), and the result so far.
+ */
+struct ProbeSlot {
+    int fd = -1;                   // -1 when open failed or the slot is finished
+    viatext::slip::decoder dec;    // per-device framing state
+    uint8_t attempts = 0;          // GET_IDs sent; attempt k carries seq k
+    std::string id;                // filled when a GET_ID reply decodes
+    int ready_ms = -1;             // NodeInfo::ready_ms once answered
+    int latency_us = -1;           // NodeInfo::latency_us once answered
+    std::vector<Clock::time_point> sent;   // sent[k]: when the GET_ID with seq k+1 went out
+    bool framed = false;           // an END byte has been seen: the port may speak SLIP
+    size_t noise = 0;              // bytes received before the first END
+};
+
+
+/*
+ * probe_wave()
+ * ------------
+ * Probe up to PROBE_MAX_INFLIGHT devices concurrently and write each reported
+ * ID (or "" on failure) into ids[first..first+count), and its NodeInfo::ready_ms
+ * and NodeInfo::latency_us into ready[] and latency[] at the same indices.
  *
- * Assumptions:
- * - serial_io handles SLIP framing and write/read correctness.
- * - GET_ID has no TLVs and is supported by all nodes.
+ * Phases:
+ *   1) open every port with no boot delay,
+ *   2) write GET_ID to every port straight away,
+ *   3) poll() all fds together; ports still silent after PROBE_RETRY_MS get
+ *      another GET_ID, until each answered or the wave deadline passes,
+ *   4) close every port.
  *
- * Trade-offs:
- * - We parse from the lossy decode_pretty() line to keep the probing fast
- *   and shell-friendly; exact TLV parsing would be stricter but overkill here.
+ * Ports that can't be ViaText leave the wave early, so they don't hold it
+ * open until the deadline: no END byte within PROBE_QUIET_MS, more than
+ * PROBE_NOISE_MAX bytes without one, or our own GET_ID echoed back (a modem
+ * in command mode).
  *
- * Phases:
- *   1) open port (with boot delay),
- *   2) write request,
- *   3) read response (bounded by timeout),
- *   4) close port,
- *   5) parse "id=" token out of the summary.
+ * Why: a fixed boot delay is dead time for the many nodes that don't reset on
+ * open. Asking immediately and repeating costs those one round trip, while a
+ * node that does reset is caught by the first GET_ID sent after its firmware
+ * came up. A reply to seq 1 means the node was ready at open (ready_ms 0).
  */
-static std::string probe_id(const std::string& dev_path) {
-    int fd = viatext::open_serial(dev_path, /*baud*/PROBE_BAUD, /*boot_delay_ms*/PROBE_BOOT_MS);
-    if (fd < 0) return {};  // can't open: not our device or no permission
+static void probe_wave(const std::vector<std::string>& devs, size_t first, size_t count,
+                       std::vector<std::string>& ids, std::vector<int>& ready,
+                       std::vector<int>& latency) {
+    std::vector<ProbeSlot> slots(count);
 
-    auto req = viatext::make_get_id(1);               // simple, deterministic seq=1 is fine for probe
-    bool ok  = viatext::write_frame(fd, req);         // Step 2: write
+    // Step 1: open everything up front (open_serial with boot_delay_ms=0)
+    const auto t0 = Clock::now();
+    bool any_open = false;
+    for (size_t i = 0; i < count; ++i) {
+        slots[i].fd = viatext::open_serial(devs[first + i], /*baud*/PROBE_BAUD, /*boot_delay_ms*/0);
+        any_open = any_open || slots[i].fd >= 0;       // can't open: not our device or no permission
+    }
+    if (!any_open) return;
+
+    // Steps 2/3 share one writer: GET_ID has no TLVs and is supported by all nodes
+    std::vector<uint8_t> req;
+    auto send = [&](ProbeSlot& s) {
+        req = viatext::make_get_id(++s.attempts);
+        s.sent.push_back(Clock::now());
+        if (!viatext::write_frame(s.fd, req)) { viatext::close_serial(s.fd); s.fd = -1; }
+    };
+    for (auto& s : slots) if (s.fd >= 0) send(s);
+
+    // Step 3: multiplex reads until every slot is finished or the deadline expires
+    const auto deadline = t0 + std::chrono::milliseconds(PROBE_TIMEOUT_MS);
+    auto next_send = t0 + std::chrono::milliseconds(PROBE_RETRY_MS);
+    std::vector<pollfd> pfds;
+    std::vector<size_t> owner;                         // pfds[k] belongs to slots[owner[k]]
+    std::vector<uint8_t> frame;
+    uint8_t chunk[256];
+
+    const auto quiet_until = t0 + std::chrono::milliseconds(PROBE_QUIET_MS);
+    auto give_up = [](ProbeSlot& s) { viatext::close_serial(s.fd); s.fd = -1; };
+
+    while (true) {
+        if (Clock::now() >= next_send) {               // re-ask every port still silent
+            for (auto& s : slots) if (s.fd >= 0) send(s);
+            next_send += std::chrono::milliseconds(PROBE_RETRY_MS);
+        }
+        if (Clock::now() >= quiet_until)               // never sent an END: not a node
+            for (auto& s : slots) if (s.fd >= 0 && !s.framed) give_up(s);
+
+        pfds.clear(); owner.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (slots[i].fd < 0) continue;
+            pfds.push_back({slots[i].fd, POLLIN, 0});
+            owner.push_back(i);
+        }
+        if (pfds.empty()) break;                       // everyone answered (or failed)
+
+        const auto now = Clock::now();
+        if (now >= deadline) break;                    // wave deadline hit
+        auto wake = std::min(deadline, next_send);
+        if (now < quiet_until) wake = std::min(wake, quiet_until);
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count();
 
-    std::vector<uint8_t> resp;
-    if (ok) ok = viatext::read_frame(fd, resp, PROBE_TIMEOUT_MS);  // Step 3: read (bounded)
+        int pr = ::poll(pfds.data(), pfds.size(), static_cast<int>(std::max<long long>(left, 0) + 1));
+        if (pr < 0 && errno == EINTR) continue;
+        if (pr < 0) break;                             // poll error
+        if (pr == 0) continue;                         // retry tick or deadline; checked above
 
-    viatext::close_serial(fd);                        // Step 4: always close
-    if (!ok) return {};                               // timeout or I/O error
+        for (size_t k = 0; k < pfds.size(); ++k) {
+            ProbeSlot& s = slots[owner[k]];
+            if (pfds[k].revents & (POLLERR | POLLHUP | POLLNVAL)) { give_up(s); continue; }
+            if (!(pfds[k].revents & POLLIN)) continue;
 
-    // Step 5: Parse "status=ok seq=N id=XYZ"
-    auto line = viatext::decode_pretty(resp);
-    auto pos  = line.find("id=");                     // we only care about the ID token
-    if (pos == std::string::npos) return {};
-    return line.substr(pos + 3);                      // everything after "id=" (ID may contain hyphens etc.)
+            ssize_t n = ::read(s.fd, chunk, sizeof(chunk));
+            if (n <= 0) continue;
+            if (!s.framed) {
+                const void* end = std::memchr(chunk, viatext::slip::END, static_cast<size_t>(n));
+                s.framed = end != nullptr;
+                s.noise += end ? static_cast<size_t>(static_cast<const uint8_t*>(end) - chunk)
+                               : static_cast<size_t>(n);
+                if (s.noise > PROBE_NOISE_MAX) { give_up(s); continue; }   // chatty, never framed
+            }
+            bool echo = false;
+            viatext::LinkGuard* lg = viatext::link_guard(s.fd);
+            s.dec.feed(chunk, static_cast<size_t>(n), [&](const uint8_t*, size_t) {
+                s.dec.take(frame);
+                if (lg && !lg->accept(frame)) return true;   // damaged: the next retry tick re-asks
+                if (frame.size() >= 3 && frame[0] == viatext::GET_ID) { echo = true; return false; }  // modem echo
+                if (frame.size() < 3 || frame[0] != viatext::RESP_OK) return true;  // boot chatter
+                s.id = id_from_response(frame);
+                if (s.id.empty()) return true;
+                s.ready_ms = frame[2] == 1 ? 0 : std::max(1, ms_since(t0));
+                if (frame[2] >= 1 && frame[2] <= s.sent.size())
+                    s.latency_us = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                        Clock::now() - s.sent[frame[2] - 1]).count());
+                return false;                          // first GET_ID reply decides
+            });
+            if (echo || !s.id.empty()) give_up(s);     // decided either way
+        }
+    }
+
+    // Step 4: close stragglers and publish results
+    for (size_t i = 0; i < count; ++i) {
+        viatext::close_serial(slots[i].fd);
+        ids[first + i] = slots[i].id;
+        ready[first + i] = slots[i].ready_ms;
+        latency[first + i] = slots[i].latency_us;
+    }
+}
+
+
+/*
+ * probe_ids()
+ * -----------
+ * Probe every device path concurrently (in waves of PROBE_MAX_INFLIGHT) and
+ * return the reported IDs in the same order. Empty string means the device
+ * did not answer like a ViaText node. `ready` and `latency`, when non-null,
+ * receive each device's NodeInfo::ready_ms and NodeInfo::latency_us.
+ */
+static std::vector<std::string> probe_ids(const std::vector<std::string>& devs,
+                                          std::vector<int>* ready = nullptr,
+                                          std::vector<int>* latency = nullptr) {
+    viatext::StatsTimer scan(-1, viatext::Phase::Scan);
+    std::vector<std::string> ids(devs.size());
+    std::vector<int> ready_ms(devs.size(), -1), latency_us(devs.size(), -1);
+    for (size_t first = 0; first < devs.size(); first += PROBE_MAX_INFLIGHT)
+        probe_wave(devs, first, std::min(PROBE_MAX_INFLIGHT, devs.size() - first), ids, ready_ms, latency_us);
+    if (ready) *ready = std::move(ready_ms);
+    if (latency) *latency = std::move(latency_us);
+    return ids;
+}
+
+
+/*
+ * wait_ready()
+ * ------------
+ * PING a freshly opened port until it answers or deadline_ms passes.
+ * Each PING gets READY_RETRY_MS to be answered; only the reply carrying the
+ * latest PING's seq counts. The node answers in order, so once that reply is
+ * in, no older PING reply can still be on its way.
+ *
+ * Returns NodeInfo::ready_ms semantics: 0 if the very first PING was
+ * answered, else ms since `t0` (>= 1), or -1 if the node never answered.
+ */
+static int wait_ready(int fd, Clock::time_point t0, int deadline_ms) {
+    const auto deadline = t0 + std::chrono::milliseconds(deadline_ms);
+    std::vector<uint8_t> frame;
+
+    for (unsigned attempt = 0; Clock::now() < deadline; ++attempt) {
+        if (attempt > 0) viatext::stats_count(fd, viatext::Counter::Retries);
+        const uint8_t seq = static_cast<uint8_t>(READY_SEQ_BASE | (attempt & 0x0F));
+        if (!viatext::write_frame(fd, viatext::make_ping(seq))) return -1;
+
+        const auto retry_at = std::min(deadline, Clock::now() + std::chrono::milliseconds(READY_RETRY_MS));
+        while (true) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            retry_at - Clock::now()).count();
+            if (left <= 0 || !viatext::read_frame(fd, frame, static_cast<int>(left))) break;
+            if (frame.size() >= 3 && frame[2] == seq &&
+                (frame[0] == viatext::RESP_OK || frame[0] == viatext::RESP_ERR))
+                return attempt == 0 ? 0 : std::max(1, ms_since(t0));
+        }
+    }
+    return -1;
+}
+
+
+/*
+ * same_device()
+ * -------------
+ * True when two paths name the same device node (aliases and by-id links
+ * resolve to the registry's canonical path). Falls back to string equality
+ * when either path can't be resolved.
+ */
+static bool same_device(const std::string& a, const std::string& b) {
+    std::error_code ea, eb;
+    const auto ca = fs::canonical(a, ea), cb = fs::canonical(b, eb);
+    return (ea || eb) ? a == b : ca == cb;
 }
 
 
@@ -105,6 +323,262 @@ static void append_glob(std::vector<std::string>& out, const char* pattern) {
 }
 
 
+/*
+ * config_dir() / registry_path()
+ * ------------------------------
+ * $HOME/.config/altgrid/viatext and the nodes.json inside it.
+ *
+ * Edge cases:
+ * - If $HOME is not set, fs::path("") yields a relative path; callers still
+ *   attempt I/O and report failure through their return value.
+ */
+static fs::path config_dir() {
+    return fs::path(std::getenv("HOME") ? std::getenv("HOME") : "") / ".config/altgrid/viatext";
+}
+
+static fs::path registry_path() {
+    return config_dir() / "nodes.json";
+}
+
+
+/*
+ * device_epoch()
+ * --------------
+ * A cheap "has the set of serial devices changed?" stamp: the mtime of
+ * /dev/serial/by-id (udev adds/removes a link there on every plug/unplug),
+ * or of /dev itself when by-id does not exist. nodes.json records this value;
+ * a mismatch means the cached dev paths may point at the wrong hardware.
+ */
+long long device_epoch() {
+    struct stat st{};
+    if (::stat("/dev/serial/by-id", &st) == 0 || ::stat("/dev", &st) == 0)
+        return static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return 0;
+}
+
+
+/*
+ * json_escape() / JsonReader
+ * --------------------------
+ * Just enough JSON for the file save_registry() writes: strings with their
+ * escapes (IDs and paths are written escaped, so a quote or backslash in
+ * either can't break the file), bare scalars, and skipping of anything
+ * else. One pass over the text, no allocation per field beyond the value.
+ * Not a validator: the first malformed token ends the parse.
+ */
+static void json_escape(std::string& out, const std::string& s) {
+    static const char HEX[] = "0123456789abcdef";
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out.push_back(HEX[c >> 4]);
+                out.push_back(HEX[c & 0x0F]);
+            } else {
+                out.push_back(static_cast<char>(c));
+            }
+        }
+    }
+}
+
+static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+struct JsonReader {
+    const std::string& s;
+    size_t i = 0;
+
+    void ws() { while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i; }
+    bool eat(char c) { ws(); if (i < s.size() && s[i] == c) { ++i; return true; } return false; }
+
+    bool hex4(uint32_t& v) {
+        if (i + 4 > s.size()) return false;
+        v = 0;
+        for (int k = 0; k < 4; ++k) {
+            const char c = s[i++];
+            v <<= 4;
+            if (c >= '0' && c <= '9')      v |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') v |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') v |= static_cast<uint32_t>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    bool string(std::string& out) {
+        if (!eat('"')) return false;
+        out.clear();
+        while (i < s.size()) {
+            const char c = s[i++];
+            if (c == '"') return true;
+            if (c != '\\') { out.push_back(c); continue; }
+            if (i >= s.size()) return false;
+            switch (const char e = s[i++]) {
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'u': {
+                uint32_t cp;
+                if (!hex4(cp)) return false;
+                if (cp >= 0xD800 && cp < 0xDC00 && s.compare(i, 2, "\\u") == 0) {   // surrogate pair
+                    i += 2;
+                    uint32_t lo;
+                    if (!hex4(lo)) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default: out.push_back(e);                  // \" \\ \/
+            }
+        }
+        return false;                                   // unterminated
+    }
+
+    // Number, true/false/null: the raw token.
+    bool scalar(std::string& out) {
+        ws();
+        const size_t b = i;
+        while (i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ']' &&
+               !std::isspace(static_cast<unsigned char>(s[i])))
+            ++i;
+        out.assign(s, b, i - b);
+        return i > b;
+    }
+
+    // Any value, nested ones included; for fields this version doesn't know.
+    bool skip() {
+        ws();
+        if (i >= s.size()) return false;
+        std::string tmp;
+        if (s[i] == '"') return string(tmp);
+        if (s[i] != '{' && s[i] != '[') return scalar(tmp);
+        const char close = s[i] == '{' ? '}' : ']';
+        ++i;
+        while (!eat(close)) {
+            if (close == '}' && !(string(tmp) && eat(':'))) return false;
+            if (!skip()) return false;
+            eat(',');
+        }
+        return true;
+    }
+};
+
+static long long to_ll(const std::string& tok, long long fallback) {
+    char* e = nullptr;
+    const long long v = std::strtoll(tok.c_str(), &e, 10);
+    return (e == tok.c_str()) ? fallback : v;
+}
+
+// One {"id":..,"dev_path":..,...} object. False on malformed text; `n` is
+// only meaningful when both id and dev_path were present (`complete`).
+static bool read_node(JsonReader& r, NodeInfo& n, bool& complete) {
+    bool has_id = false, has_dev = false;
+    if (!r.eat('{')) return false;
+    std::string key, tok;
+    while (!r.eat('}')) {
+        if (!r.string(key) || !r.eat(':')) return false;
+        bool ok;
+        if (key == "id")              ok = has_id  = r.string(n.id);
+        else if (key == "dev_path")   ok = has_dev = r.string(n.dev_path);
+        else if (key == "online")     { ok = r.scalar(tok); n.online = tok == "true"; }
+        else if (key == "ready_ms")   { ok = r.scalar(tok); n.ready_ms = static_cast<int>(to_ll(tok, -1)); }
+        else if (key == "last_seen")  { ok = r.scalar(tok); n.last_seen = to_ll(tok, 0); }
+        else if (key == "latency_us") { ok = r.scalar(tok); n.latency_us = static_cast<int>(to_ll(tok, -1)); }
+        else                          ok = r.skip();
+        if (!ok) return false;
+        r.eat(',');
+    }
+    complete = has_id && has_dev;
+    return true;
+}
+
+// Array body after '['. Stops at the first malformed object.
+static bool read_nodes(JsonReader& r, std::vector<NodeInfo>& nodes) {
+    while (!r.eat(']')) {
+        NodeInfo n{};
+        bool complete = false;
+        if (!read_node(r, n, complete)) return false;
+        if (complete) nodes.push_back(std::move(n));
+        r.eat(',');
+    }
+    return true;
+}
+
+// Whole file: {"by_id_mtime":N,"nodes":[...]} or the older bare array.
+// `stamp` stays -1 when absent; returns false if the text is malformed.
+static bool parse_registry(const std::string& text, std::vector<NodeInfo>& nodes, long long& stamp) {
+    JsonReader r{text};
+    stamp = -1;
+    if (r.eat('[')) return read_nodes(r, nodes);
+    if (!r.eat('{')) return false;
+    std::string key, tok;
+    while (!r.eat('}')) {
+        if (!r.string(key) || !r.eat(':')) return false;
+        bool ok;
+        if (key == "by_id_mtime") { ok = r.scalar(tok); stamp = to_ll(tok, -1); }
+        else if (key == "nodes")  ok = r.eat('[') && read_nodes(r, nodes);
+        else                      ok = r.skip();
+        if (!ok) return false;
+        r.eat(',');
+    }
+    return true;
+}
+
+// The exact bytes save_registry() puts on disk for `nodes`.
+static std::string registry_text(const std::vector<NodeInfo>& nodes, long long epoch) {
+    std::string out = "{\n  \"by_id_mtime\":" + std::to_string(epoch) + ",\n  \"nodes\":[\n";
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const NodeInfo& n = nodes[i];
+        out += "    {\"id\":\"";
+        json_escape(out, n.id);
+        out += "\",\"dev_path\":\"";
+        json_escape(out, n.dev_path);
+        out += "\",\"online\":";
+        out += n.online ? "true" : "false";
+        out += ",\"ready_ms\":" + std::to_string(n.ready_ms)
+             + ",\"last_seen\":" + std::to_string(n.last_seen)
+             + ",\"latency_us\":" + std::to_string(n.latency_us) + "}";
+        if (i + 1 < nodes.size()) out += ",";           // avoid trailing comma
+        out += "\n";
+    }
+    out += "  ]\n}\n";
+    return out;
+}
+
+static bool read_file(const fs::path& p, std::string& out) {
+    std::ifstream ifs(p, std::ios::binary);
+    if (!ifs) return false;
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+
 /*
  * runtime_dir()
  * -------------
@@ -122,25 +596,266 @@ static fs::path runtime_dir() {
 }
 
 
-// -------- public API --------
+/*
+ * RegistryLock
+ * ------------
+ * Writers' exclusion around a read-modify-write of nodes.json:
+ * - registry_mu between threads of this process (fan-out opens in parallel),
+ * - flock(2) on nodes.json.lock between processes. The lock lives in its own
+ *   file because nodes.json itself is replaced by rename() on every write.
+ * The flock is tried without blocking for up to REGISTRY_LOCK_WAIT_MS; a
+ * writer that doesn't get it gives up (held() is false) rather than stall a
+ * CLI call behind another process's scan. Readers never lock.
+ */
+static std::mutex registry_mu;
+
+struct RegistryLock {
+    std::lock_guard<std::mutex> lk{registry_mu};
+    int fd = -1;
+
+    RegistryLock() {
+        std::error_code ec;
+        fs::create_directories(config_dir(), ec);
+        fd = ::open((config_dir() / "nodes.json.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return;
+        const auto give_up = Clock::now() + std::chrono::milliseconds(REGISTRY_LOCK_WAIT_MS);
+        while (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            if (errno != EWOULDBLOCK && errno != EINTR) { ::close(fd); fd = -1; return; }
+            if (Clock::now() >= give_up) { ::close(fd); fd = -1; return; }
+            ::usleep(5000);
+        }
+    }
+    ~RegistryLock() { if (fd >= 0) ::close(fd); }          // close releases the flock
+    RegistryLock(const RegistryLock&) = delete;
+    RegistryLock& operator=(const RegistryLock&) = delete;
+
+    bool held() const { return fd >= 0; }
+};
+
 
 /*
- * discover_nodes()
+ * keep_fresher()
+ * --------------
+ * The incremental part of save_registry(): carry ready_ms over from the
+ * stored entry for the same ID and path unless the node's reset behavior
+ * changed (the wait length itself is only ever compared with 0), and
+ * last_seen/latency_us when the new entry has none, or when its values are within the slack of the stored ones (so a
+ * rescan a few seconds later writes nothing). Latency slack is a quarter of
+ * the stored value or 1 ms, whichever is larger: probe round trips of a
+ * whole wave jitter by a few hundred us.
+ */
+static void keep_fresher(NodeInfo& n, const std::vector<NodeInfo>& stored) {
+    if (n.id.empty()) return;
+    for (const auto& o : stored) {
+        if (o.id != n.id || o.dev_path != n.dev_path) continue;
+        if (o.ready_ms >= 0 && (n.ready_ms < 0 || (n.ready_ms > 0) == (o.ready_ms > 0)))
+            n.ready_ms = o.ready_ms;                        // only reset vs no reset matters
+        if (n.last_seen == 0) {
+            n.last_seen = o.last_seen;
+            if (n.latency_us < 0) n.latency_us = o.latency_us;
+            return;
+        }
+        const bool seen_close = o.last_seen > 0 && n.last_seen >= o.last_seen &&
+                                n.last_seen - o.last_seen < REGISTRY_SEEN_SLACK_S;
+        const bool lat_close = n.latency_us < 0 ||
+                               (o.latency_us >= 0 &&
+                                std::abs(n.latency_us - o.latency_us) <= std::max(o.latency_us / 4, 1000));
+        if (seen_close && lat_close) {
+            n.last_seen = o.last_seen;
+            n.latency_us = o.latency_us;
+        }
+        return;
+    }
+}
+
+
+/*
+ * store_registry()
  * ----------------
- * Walk the system looking for serial devices that might be ViaText nodes,
- * then probe each to confirm by requesting its ID.
+ * save_registry() minus the locking; the caller holds a RegistryLock.
+ * `epoch` is the stamp to record (see save_registry()).
+ * Temp file in the same directory (rename() is only atomic within one
+ * filesystem), fsync, rename over nodes.json. Skipped when the bytes would
+ * not change.
+ */
+static bool store_registry(const std::vector<NodeInfo>& nodes, long long epoch) {
+    std::string old_text;
+    std::vector<NodeInfo> stored;
+    long long stamp;
+    if (read_file(registry_path(), old_text)) parse_registry(old_text, stored, stamp);
+
+    std::vector<NodeInfo> out = nodes;
+    for (auto& n : out) keep_fresher(n, stored);
+    const std::string text = registry_text(out, epoch);
+    if (text == old_text) return true;                      // nothing changed: no write
+
+    const fs::path tmp = config_dir() / ("nodes.json.tmp." + std::to_string(::getpid()));
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) { std::cerr << "open nodes.json failed\n"; return false; }
+    size_t off = 0;
+    while (off < text.size()) {
+        const ssize_t n = ::write(fd, text.data() + off, text.size() - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += static_cast<size_t>(n);
+    }
+    const bool ok = off == text.size() && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), registry_path().c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        std::cerr << "write nodes.json failed\n";
+        return false;
+    }
+    return true;
+}
+
+
+// -------- public API --------
+
+/*
+ * probe_node() / probe_nodes()
+ * ----------------------------
+ * Targeted probes of only the given devices (no directory walk). One device
+ * is the single-slot case of probe_ids(); several share one wave.
+ */
+std::string probe_node(const std::string& dev_path) {
+    return probe_ids({dev_path}).front();
+}
+
+std::vector<std::string> probe_nodes(const std::vector<std::string>& devs,
+                                     std::vector<int>* ready_ms, std::vector<int>* latency_us) {
+    return probe_ids(devs, ready_ms, latency_us);
+}
+
+long long unix_now() {
+    return static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+
+/*
+ * learned_ready_ms() / record_ready_ms()
+ * --------------------------------------
+ * Read and update NodeInfo::ready_ms for a device in a fresh nodes.json.
+ * record_ready_ms() reloads the file under a RegistryLock and rewrites it
+ * only when the outcome changes what was known (unknown → known, or
+ * reset ↔ no reset), so concurrent open_node() calls (fan-out threads, or
+ * other processes) neither tear the file nor drop each other's updates.
  *
- * Strategy:
- * - Prefer /dev/serial/by-id symlinks for stability across reboots/ports.
+ * A stale registry is not consulted or rewritten: its dev paths may belong
+ * to other hardware by now.
+ */
+int learned_ready_ms(const std::string& dev) {
+    std::vector<NodeInfo> nodes;
+    if (!load_registry(nodes)) return -1;
+    for (const auto& n : nodes)
+        if (n.online && same_device(n.dev_path, dev)) return n.ready_ms;
+    return -1;
+}
+
+void record_ready_ms(const std::string& dev, int ready) {
+    RegistryLock lock;
+    if (!lock.held()) return;
+    const long long epoch = device_epoch();                 // before the load: a plug since keeps it stale
+    std::vector<NodeInfo> nodes;
+    if (!load_registry(nodes)) return;
+    for (auto& n : nodes) {
+        if (!n.online || !same_device(n.dev_path, dev)) continue;
+        if (n.ready_ms >= 0 && (n.ready_ms > 0) == (ready > 0)) return;   // nothing new
+        n.ready_ms = ready;
+        store_registry(nodes, epoch);
+        return;
+    }
+}
+
+
+/*
+ * open_node()
+ * -----------
+ * open_serial() without the fixed boot delay:
+ *   1) open with boot_delay_ms=0,
+ *   2) learned "no reset" (ready_ms == 0): done,
+ *   3) otherwise wait_ready() and record what was observed.
+ */
+int open_node(const std::string& dev, int baud, int deadline_ms) {
+    const int known = learned_ready_ms(dev);
+
+    const auto t0 = Clock::now();
+    int fd = viatext::open_serial(dev, baud, /*boot_delay_ms*/0);
+    if (fd < 0) return -1;
+    if (known == 0) return fd;                               // learned: answers straight after open
+
+    const auto waiting = Clock::now();
+    const int ready = wait_ready(fd, t0, deadline_ms);
+    viatext::stats_time(fd, viatext::Phase::BootDelay, Clock::now() - waiting);
+    if (ready >= 0) record_ready_ms(dev, ready);
+    return fd;
+}
+
+
+/*
+ * usb_id()
+ * --------
+ * "vvvv:pppp" of the USB device behind a tty, read from sysfs: the tty's
+ * `device` link leads to the USB interface, and idVendor/idProduct sit on
+ * the USB device one or two levels up. "" for ttys that are not on USB
+ * (ptys, onboard UARTs). The by-id link names carry the vendor/product
+ * strings, not these numbers, so sysfs is where they come from.
+ */
+static std::string usb_id(const std::string& dev) {
+    std::error_code ec;
+    const auto name = fs::canonical(dev, ec).filename();
+    if (ec) return {};
+    fs::path p = fs::canonical(fs::path("/sys/class/tty") / name / "device", ec);
+    if (ec) return {};
+    for (int up = 0; up < 4 && p.has_relative_path(); ++up, p = p.parent_path()) {
+        std::ifstream v(p / "idVendor"), d(p / "idProduct");
+        std::string vid, pid;
+        if (v >> vid && d >> pid) return vid + ":" + pid;
+    }
+    return {};
+}
+
+
+/*
+ * probe_skip_list()
+ * -----------------
+ * VID:PID patterns (fnmatch, lower-case hex) of USB serial devices that are
+ * never ViaText nodes, so discovery doesn't open them at all:
+ *   1546:*  u-blox GNSS receivers
+ *   2c7c:*  Quectel, 1199:* Sierra Wireless, 12d1:* Huawei, 1bc7:* Telit modems
+ * Extended by config_dir()/probe_skip: one pattern per line ("0403:6015",
+ * "10c4:*"), '#' starts a comment. Node boards (CP210x, CH340, FTDI,
+ * Espressif) are deliberately not in the built-in list.
+ */
+static const char* const PROBE_SKIP_BUILTIN[] = {"1546:*", "2c7c:*", "1199:*", "12d1:*", "1bc7:*"};
+
+static std::vector<std::string> probe_skip_list() {
+    std::vector<std::string> skip(std::begin(PROBE_SKIP_BUILTIN), std::end(PROBE_SKIP_BUILTIN));
+    std::ifstream in(config_dir() / "probe_skip");
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string pat;
+        if (!(words >> pat)) continue;
+        for (auto& c : pat) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        skip.push_back(pat);
+    }
+    return skip;
+}
+
+
+/*
+ * candidate_devices()
+ * -------------------
+ * Serial devices that might be ViaText nodes:
+ * - Prefer /dev/serial/by-id symlinks for stability across reboots/ports
+ *   (resolved to their canonical device).
  * - If that directory is absent, fall back to globbing tty patterns.
- * - For each candidate, attempt probe_id(); if it returns a non-empty string,
- *   mark the node as online.
- *
- * Failure handling:
- * - We never throw; errors just result in fewer entries or online=false.
+ * - Drop USB devices whose VID:PID is on probe_skip_list().
  */
-std::vector<NodeInfo> discover_nodes() {
-    std::vector<NodeInfo> result;
+std::vector<std::string> candidate_devices() {
     std::vector<std::string> candidates;
 
     // Prefer stable paths first: /dev/serial/by-id -> resolved to canonical device
@@ -158,10 +873,42 @@ std::vector<NodeInfo> discover_nodes() {
         append_glob(candidates, "/dev/ttyUSB*");
     }
 
-    // Probe each candidate device and record the result
-    for (const auto& dev : candidates) {
-        std::string id = probe_id(dev);                      // empty if not ours/offline
-        result.push_back({id, dev, !id.empty()});            // online flag is id presence
+    const auto skip = probe_skip_list();
+    auto skipped = [&](const std::string& dev) {
+        const std::string id = usb_id(dev);
+        if (id.empty()) return false;                        // not USB: can't tell, probe it
+        for (const auto& pat : skip)
+            if (::fnmatch(pat.c_str(), id.c_str(), 0) == 0) return true;
+        return false;
+    };
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), skipped), candidates.end());
+    return candidates;
+}
+
+
+/*
+ * discover_nodes()
+ * ----------------
+ * Probe every candidate_devices() entry at once through probe_ids(); a
+ * non-empty ID marks the node as online. The device epoch is read before the
+ * ports are listed, so a port plugged during the scan leaves the saved
+ * registry stale rather than fresh without it.
+ *
+ * Failure handling:
+ * - We never throw; errors just result in fewer entries or online=false.
+ */
+std::vector<NodeInfo> discover_nodes(long long* epoch) {
+    std::vector<NodeInfo> result;
+    if (epoch) *epoch = device_epoch();
+    const auto candidates = candidate_devices();
+
+    // Probe all candidates concurrently and record the results
+    std::vector<int> ready, latency;
+    const auto ids = probe_ids(candidates, &ready, &latency);   // empty id if not ours/offline
+    const long long now = unix_now();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const bool online = !ids[i].empty();                    // online flag is id presence
+        result.push_back({ids[i], candidates[i], online, ready[i], online ? now : 0, latency[i]});
     }
     return result;
 }
@@ -176,31 +923,87 @@ std::vector<NodeInfo> discover_nodes() {
  * Design:
  * - Minimal JSON so humans can read/edit it easily.
  * - No external JSON library to keep dependencies small.
- *
- * Edge cases:
- * - If $HOME is not set, fs::path("") yields a relative path; we still attempt
- *   to create directories (caller will see a failure via return false).
+ * - Stamps the caller's `epoch`, the device_epoch() read before its device
+ *   list was taken, so load_registry() can tell whether the devices have
+ *   changed since. Stamping at write time would mark a roster fresh that
+ *   misses a port plugged during the scan.
+ * - One writer at a time across processes (RegistryLock), atomic replace and
+ *   no write at all when nothing changed (store_registry()).
  */
-bool save_registry(const std::vector<NodeInfo>& nodes) {
-    fs::path conf = fs::path(std::getenv("HOME") ? std::getenv("HOME") : "") / ".config/altgrid/viatext";
+bool save_registry(const std::vector<NodeInfo>& nodes, long long epoch) {
+    fs::path conf = config_dir();
     std::error_code ec;
     fs::create_directories(conf, ec);                         // non-throwing; check ec
     if (ec) { std::cerr << "config dir error: " << ec.message() << "\n"; return false; }
 
-    std::ofstream ofs(conf / "nodes.json");
-    if (!ofs) { std::cerr << "open nodes.json failed\n"; return false; }
+    RegistryLock lock;
+    if (!lock.held()) return false;                         // another writer is busy; it's only a cache
+    return store_registry(nodes, epoch);
+}
 
-    // Write a tiny JSON array; commas placed between elements only.
-    ofs << "[\n";
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        ofs << "  {\"id\":\"" << nodes[i].id
-            << "\",\"dev_path\":\"" << nodes[i].dev_path
-            << "\",\"online\":" << (nodes[i].online ? "true" : "false") << "}";
-        if (i + 1 < nodes.size()) ofs << ",";                 // avoid trailing comma
-        ofs << "\n";
+
+/*
+ * load_registry()
+ * ---------------
+ * Read nodes.json back as a cache (parse_registry()); the older bare-array
+ * format (no stamp) parses but counts as stale. No lock: writers replace the
+ * file with rename(), so this sees one whole version or the other.
+ *
+ * Returns false when the file is missing/unreadable/malformed or its
+ * by_id_mtime stamp does not match the current device_epoch(); `nodes` is
+ * still filled in the stale case so callers may inspect it.
+ */
+bool load_registry(std::vector<NodeInfo>& nodes) {
+    nodes.clear();
+    std::string text;
+    if (!read_file(registry_path(), text)) return false;
+
+    long long stamp = -1;                                   // absent in old files → stays -1
+    if (!parse_registry(text, nodes, stamp)) return false;
+    return stamp == device_epoch();
+}
+
+
+/*
+ * resolve_node()
+ * --------------
+ * ID → device path, cheapest source first:
+ *   1) nodes.json entries for this ID, most recently seen first (ties: the
+ *      lower probe latency): one targeted probe per cached dev_path confirms
+ *      the node is still there and still has this ID. A stale registry
+ *      (devices plugged since) is only trusted for its most recent entry; a
+ *      USB node that was replugged usually comes back on the same path.
+ *   2) full discover_nodes() scan as a last resort; the fresh roster is saved
+ *      so the next lookup hits step 1. Only when the registry is stale or
+ *      missing, or a cached entry failed its probe: a fresh registry without
+ *      the ID is a definite miss (a mistyped --node fails in milliseconds).
+ *
+ * `scanned`, when non-null, reports whether step 2 ran.
+ */
+bool resolve_node(const std::string& id, std::string& dev_path, bool* scanned) {
+    if (scanned) *scanned = false;
+
+    std::vector<NodeInfo> cached, hits;
+    const bool fresh = load_registry(cached);
+    for (const auto& n : cached)
+        if (n.online && n.id == id) hits.push_back(n);
+    std::stable_sort(hits.begin(), hits.end(), [](const NodeInfo& a, const NodeInfo& b) {
+        if (a.last_seen != b.last_seen) return a.last_seen > b.last_seen;
+        return static_cast<unsigned>(a.latency_us) < static_cast<unsigned>(b.latency_us);   // -1 last
+    });
+    if (fresh && hits.empty()) return false;            // devices unchanged since the last scan
+    if (!fresh && hits.size() > 1) hits.resize(1);
+    for (const auto& n : hits)
+        if (probe_node(n.dev_path) == id) { dev_path = n.dev_path; return true; }
+
+    if (scanned) *scanned = true;
+    long long epoch;
+    auto nodes = discover_nodes(&epoch);
+    save_registry(nodes, epoch);
+    for (const auto& n : nodes) {
+        if (n.online && n.id == id) { dev_path = n.dev_path; return true; }
     }
-    ofs << "]\n";
-    return true;
+    return false;
 }
 
 
@@ -234,4 +1037,19 @@ bool create_symlinks(const std::vector<NodeInfo>& nodes) {
     return true;
 }
 
+
+/*
+ * remove_symlink()
+ * ----------------
+ * Drop <runtime_dir>/viatext-node-<ID> when that node goes away, so a stale
+ * alias never points --node at a port now owned by other hardware.
+ * A missing link is not an error.
+ */
+bool remove_symlink(const std::string& id) {
+    if (id.empty()) return true;
+    std::error_code ec;
+    fs::remove(runtime_dir() / ("viatext-node-" + id), ec);
+    return !ec;
+}
+
 } // namespace viatext
@@ -0,0 +1,233 @@
+// ============================================================================
+// node_watch.cpp — implementation for node_watch.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file node_watch.cpp
+ */
+
+#include "node_watch.hpp"     // watch_nodes()
+#include "node_registry.hpp"  // discover_nodes(), probe_nodes(), save_registry(), device_epoch(), create/remove_symlink(s)
+
+#include <algorithm>          // std::remove_if over the roster
+#include <chrono>             // settle deadlines
+#include <csignal>            // SIGINT/SIGTERM stop the watcher
+#include <map>                // device path -> probe due time
+#include <ostream>            // event lines
+#include <string>
+#include <vector>
+#include <cerrno>             // EINTR/EAGAIN from poll/read
+#include <poll.h>             // poll(2) on the inotify fd with a timer
+#include <sys/inotify.h>      // inotify_init1(), inotify_add_watch()
+#include <unistd.h>           // ::read, ::close
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - WATCH_DIR: the kernel creates ttyACM*/ttyUSB* here before udev adds the
+//   by-id link, and it never disappears (unlike /dev/serial/by-id).
+// - SETTLE_MS: wait after the last event for a device before probing it;
+//   covers udev's permission fix-up and USB CDC enumeration.
+// - TICK_MS: upper bound on one poll() so a stop signal is noticed promptly.
+// ---------------------------------------------------------------------------
+static constexpr const char* WATCH_DIR = "/dev";
+static constexpr int SETTLE_MS = 300;
+static constexpr int TICK_MS   = 1000;
+
+using Clock = std::chrono::steady_clock;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_stop_signal(int) { stop_requested = 1; }
+
+
+// ---------------------------------------------------------------------------
+// is_serial_name()
+// ----------------
+// Only USB serial ttys can be ViaText nodes; everything else in /dev is noise.
+// ---------------------------------------------------------------------------
+static bool is_serial_name(const std::string& name) {
+    return name.rfind("ttyACM", 0) == 0 || name.rfind("ttyUSB", 0) == 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// drop_device()
+// -------------
+// Remove the roster entry for `dev` (and its alias). Returns true if one existed.
+// ---------------------------------------------------------------------------
+static bool drop_device(std::vector<NodeInfo>& roster, const std::string& dev, std::ostream& out) {
+    bool changed = false;
+    for (const auto& n : roster) {
+        if (n.dev_path != dev) continue;
+        remove_symlink(n.id);
+        out << "event=remove id=" << n.id << " dev=" << n.dev_path << std::endl;
+        changed = true;
+    }
+    roster.erase(std::remove_if(roster.begin(), roster.end(),
+                                [&](const NodeInfo& n) { return n.dev_path == dev; }),
+                 roster.end());
+    return changed;
+}
+
+
+// ---------------------------------------------------------------------------
+// apply_probe()
+// -------------
+// Merge one probe result into the roster:
+// - the same ID on another path is a moved radio: that stale entry goes,
+// - an existing entry for this path is replaced (its old alias dropped if the
+//   ID changed), otherwise a new entry is added.
+// Returns true if the roster changed. A new ready_ms or latency alone is not
+// a change.
+// ---------------------------------------------------------------------------
+static bool apply_probe(std::vector<NodeInfo>& roster, const std::string& dev,
+                        const std::string& id, int ready_ms, int latency_us, std::ostream& out) {
+    const NodeInfo fresh{id, dev, !id.empty(), ready_ms, id.empty() ? 0 : unix_now(), latency_us};
+
+    for (const auto& n : roster) {
+        if (n.dev_path == dev && n.id == fresh.id && n.online == fresh.online) return false;
+    }
+
+    if (!id.empty()) {
+        std::vector<std::string> moved;
+        for (const auto& n : roster)
+            if (n.id == id && n.dev_path != dev) moved.push_back(n.dev_path);
+        for (const auto& m : moved) drop_device(roster, m, out);
+    }
+    drop_device(roster, dev, out);
+
+    roster.push_back(fresh);
+    out << "event=add id=" << fresh.id << " dev=" << fresh.dev_path
+        << " online=" << (fresh.online ? 1 : 0) << std::endl;
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// publish()
+// ---------
+// Persist the roster and refresh aliases. create_symlinks() replaces links
+// in place; removed nodes were already unlinked by drop_device(). `epoch` is
+// the registry stamp, as for save_registry().
+// ---------------------------------------------------------------------------
+static void publish(const std::vector<NodeInfo>& roster, long long epoch) {
+    save_registry(roster, epoch);
+    create_symlinks(roster);
+}
+
+
+// ---------------------------------------------------------------------------
+// watch_nodes()
+// -------------
+// 1) Arm inotify first so nothing plugged during the seed scan is missed.
+// 2) Seed the roster with one discover_nodes(), unlink aliases of previously
+//    registered nodes that are no longer online, and publish it.
+// 3) Loop: read events into a per-device "probe due" map (each new event for
+//    a device pushes its due time out by SETTLE_MS); removals apply at once.
+// 4) Probe every device whose settle time passed, in one shared wave, merge
+//    the results, and publish if anything changed.
+//
+// The registry stamp is the device epoch read before the events were
+// drained, and only while no device waits to settle; with one pending the
+// roster is incomplete and is published stale (-1). Once the last pending
+// device is probed the roster is published again under the current stamp,
+// even if the probe changed nothing (a port that turned out not to be a node).
+// ---------------------------------------------------------------------------
+int watch_nodes(std::ostream& out) {
+    int ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ifd < 0) return 1;
+    if (inotify_add_watch(ifd, WATCH_DIR,
+                          IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_TO | IN_MOVED_FROM) < 0) {
+        ::close(ifd);
+        return 1;
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = on_stop_signal;                  // no SA_RESTART: poll() returns EINTR
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::vector<NodeInfo> previous;
+    load_registry(previous);                         // fresh or stale: only used for alias cleanup
+
+    long long epoch;
+    std::vector<NodeInfo> roster = discover_nodes(&epoch);
+    for (const auto& old : previous) {               // aliases left behind by nodes now gone
+        bool still_here = false;
+        for (const auto& n : roster) still_here = still_here || (n.online && n.id == old.id);
+        if (!still_here) remove_symlink(old.id);
+    }
+    for (const auto& n : roster) {
+        out << "event=add id=" << n.id << " dev=" << n.dev_path
+            << " online=" << (n.online ? 1 : 0) << std::endl;
+    }
+    publish(roster, epoch);
+    long long stamped = epoch;                       // the stamp nodes.json carries now
+
+    std::map<std::string, Clock::time_point> due;    // device -> when to probe it
+    alignas(inotify_event) char buf[4096];
+
+    while (!stop_requested) {
+        // Sleep until the next probe is due (or a tick, to notice signals)
+        int wait_ms = TICK_MS;
+        for (const auto& d : due) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(d.second - Clock::now()).count();
+            wait_ms = std::max(0, std::min(wait_ms, static_cast<int>(left)));
+        }
+
+        pollfd pfd{ifd, POLLIN, 0};
+        int pr = ::poll(&pfd, 1, wait_ms);
+        if (pr < 0 && errno != EINTR) break;
+
+        bool changed = false;
+        epoch = device_epoch();                      // before the drain: a plug after it is seen as stale
+
+        // Step 3: drain queued events
+        if (pr > 0 && (pfd.revents & POLLIN)) {
+            ssize_t n;
+            while ((n = ::read(ifd, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + n; ) {
+                    auto* ev = reinterpret_cast<inotify_event*>(p);
+                    p += sizeof(inotify_event) + ev->len;
+                    if (ev->len == 0 || !is_serial_name(ev->name)) continue;
+
+                    const std::string dev = std::string(WATCH_DIR) + "/" + ev->name;
+                    if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                        due.erase(dev);
+                        changed = drop_device(roster, dev, out) || changed;
+                    } else {
+                        due[dev] = Clock::now() + std::chrono::milliseconds(SETTLE_MS);
+                    }
+                }
+            }
+        }
+
+        // Step 4: probe settled devices together
+        std::vector<std::string> ready;
+        const auto now = Clock::now();
+        for (auto it = due.begin(); it != due.end(); ) {
+            if (it->second <= now) { ready.push_back(it->first); it = due.erase(it); }
+            else ++it;
+        }
+        if (!ready.empty()) {
+            std::vector<int> ready_ms, latency_us;
+            const auto ids = probe_nodes(ready, &ready_ms, &latency_us);
+            for (size_t i = 0; i < ready.size(); ++i)
+                changed = apply_probe(roster, ready[i], ids[i], ready_ms[i], latency_us[i], out) || changed;
+        }
+
+        if (changed || (due.empty() && stamped != epoch)) {
+            stamped = due.empty() ? epoch : -1;
+            publish(roster, stamped);
+        }
+    }
+
+    ::close(ifd);
+    return 0;
+}
+
+} // namespace viatext
@@ -0,0 +1,322 @@
+// ============================================================================
+// output_format.cpp — implementation for output_format.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file output_format.cpp
+ */
+
+#include "output_format.hpp"  // OutputFormat, format_reply(), format_error()
+#include "commands.hpp"       // NodeReply, decode_reply_into(), TlvCursor, decode_pretty()
+#include "param_table.hpp"    // PARAMS: output keys and order
+
+#include <charconv>           // std::to_chars: locale-free integer formatting
+#include <string_view>
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Field order
+// -----------
+// Typed formats emit the tagged rows of PARAMS (param_table.hpp) in table
+// order, under the same keys decode_pretty() prints, so jsonl/csv consumers
+// and shell scripts agree. Verb-only rows (ping, all) carry no tag.
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// field_num() / field_str()
+// -------------------------
+// Read one NodeReply member by tag. Only called for tagged rows whose
+// presence bit is set.
+// ---------------------------------------------------------------------------
+static int64_t field_num(const NodeReply& r, uint8_t tag) {
+    switch (tag) {
+        case TAG_UPTIME_S:   return r.uptime_s;
+        case TAG_BOOT_TIME:  return r.boot_time;
+        case TAG_FREQ_HZ:    return r.freq_hz;
+        case TAG_SF:         return r.sf;
+        case TAG_BW_HZ:      return r.bw_hz;
+        case TAG_CR:         return r.cr;
+        case TAG_TX_PWR_DBM: return r.tx_pwr_dbm;
+        case TAG_CHAN:       return r.chan;
+        case TAG_MODE:       return r.mode;
+        case TAG_HOPS:       return r.hops;
+        case TAG_BEACON_SEC: return r.beacon_s;
+        case TAG_BUF_SIZE:   return r.buf_size;
+        case TAG_ACK_MODE:   return r.ack;
+        case TAG_RSSI_DBM:   return r.rssi_dbm;
+        case TAG_SNR_DB:     return r.snr_db;
+        case TAG_VBAT_MV:    return r.vbat_mv;
+        case TAG_TEMP_C10:   return r.temp_c10;
+        case TAG_FREE_MEM:   return r.free_mem;
+        case TAG_FREE_FLASH: return r.free_flash;
+        case TAG_LOG_COUNT:  return r.log_count;
+        default:             return 0;
+    }
+}
+
+static std::string_view field_str(const NodeReply& r, uint8_t tag) {
+    switch (tag) {
+        case TAG_ID:         return r.id;
+        case TAG_ALIAS:      return r.alias;
+        case TAG_FW_VERSION: return r.fw;
+        default:             return {};
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Appenders (no streams)
+// ---------------------------------------------------------------------------
+static void put_int(std::string& out, int64_t v) {
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    out.append(tmp, res.ptr);
+}
+
+// Tenths as a fixed one-decimal number: 235 -> "23.5", -5 -> "-0.5".
+static void put_tenths(std::string& out, int64_t v10) {
+    if (v10 < 0) { out.push_back('-'); v10 = -v10; }
+    put_int(out, v10 / 10);
+    out.push_back('.');
+    out.push_back(static_cast<char>('0' + v10 % 10));
+}
+
+static void put_hex(std::string& out, const uint8_t* p, size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back(digits[p[i] >> 4]);
+        out.push_back(digits[p[i] & 0x0F]);
+    }
+}
+
+static void put_json_string(std::string& out, std::string_view s) {
+    static const char digits[] = "0123456789abcdef";
+    out.push_back('"');
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { out.push_back('\\'); out.push_back(static_cast<char>(c)); }
+        else if (c == '\n')        out += "\\n";
+        else if (c == '\r')        out += "\\r";
+        else if (c == '\t')        out += "\\t";
+        else if (c < 0x20) {       // other control bytes: \u00XX
+            out += "\\u00";
+            out.push_back(digits[c >> 4]);
+            out.push_back(digits[c & 0x0F]);
+        } else {
+            out.push_back(static_cast<char>(c));
+        }
+    }
+    out.push_back('"');
+}
+
+static void put_csv_cell(std::string& out, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) { out.append(s.data(), s.size()); return; }
+    out.push_back('"');
+    for (char c : s) {
+        if (c == '"') out.push_back('"');          // RFC 4180: double embedded quotes
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+static const char* status_word(uint8_t verb) {
+    if (verb == RESP_OK)  return "ok";
+    if (verb == RESP_ERR) return "error";
+    return "unknown";
+}
+
+
+// ---------------------------------------------------------------------------
+// for_each_unknown()
+// ------------------
+// Walk the frames again for tags NodeReply has no field for (rare; only when
+// r.unknown > 0). Later frames repeat earlier unknown tags as-is.
+// ---------------------------------------------------------------------------
+template <class Fn>
+static void for_each_unknown(const std::vector<uint8_t>* frames, size_t count, Fn fn) {
+    for (size_t i = 0; i < count; ++i) {
+        TlvCursor cur(frames[i].data(), frames[i].size());
+        TlvView t;
+        while (cur.next(t)) {
+            if (!param_for_tag(t.tag)) fn(t);
+        }
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// JSON lines
+// ---------------------------------------------------------------------------
+static void format_jsonl(const NodeReply& r, const std::vector<uint8_t>* frames, size_t count,
+                         std::string& out) {
+    out += "{\"status\":\"";
+    out += status_word(r.verb);
+    out += "\",\"seq\":";
+    put_int(out, r.seq);
+
+    for (const auto& p : PARAMS) {
+        if (!p.tag || !r.has(p.tag)) continue;
+        out += ",\"";
+        out.append(p.key.data(), p.key.size());
+        out += "\":";
+        if (p.type == WireType::Str)            put_json_string(out, field_str(r, p.tag));
+        else if (p.display == Display::Tenths)  put_tenths(out, field_num(r, p.tag));
+        else                                    put_int(out, field_num(r, p.tag));
+    }
+
+    if (r.unknown) {
+        for_each_unknown(frames, count, [&](const TlvView& t) {
+            out += ",\"tag";
+            put_int(out, t.tag);
+            out += "\":\"";
+            put_hex(out, t.val, t.len);
+            out.push_back('"');
+        });
+    }
+    out.push_back('}');
+}
+
+
+// ---------------------------------------------------------------------------
+// CSV
+// ---------------------------------------------------------------------------
+static void format_csv(const NodeReply& r, const std::vector<uint8_t>* frames, size_t count,
+                       std::string& out) {
+    out += status_word(r.verb);
+    out.push_back(',');
+    put_int(out, r.seq);
+    out.push_back(',');                            // reason: only set by format_error()
+
+    for (const auto& p : PARAMS) {
+        if (!p.tag) continue;
+        out.push_back(',');
+        if (!r.has(p.tag)) continue;
+        if (p.type == WireType::Str)            put_csv_cell(out, field_str(r, p.tag));
+        else if (p.display == Display::Tenths)  put_tenths(out, field_num(r, p.tag));
+        else                                    put_int(out, field_num(r, p.tag));
+    }
+
+    out.push_back(',');
+    if (r.unknown) {
+        bool first = true;
+        for_each_unknown(frames, count, [&](const TlvView& t) {
+            if (!first) out.push_back(';');
+            first = false;
+            out += "tag";
+            put_int(out, t.tag);
+            out.push_back('=');
+            put_hex(out, t.val, t.len);
+        });
+    }
+}
+
+
+// -------- public API --------
+
+bool parse_output_format(const std::string& name, OutputFormat& fmt) {
+    if      (name == "pretty") fmt = OutputFormat::Pretty;
+    else if (name == "jsonl")  fmt = OutputFormat::Jsonl;
+    else if (name == "csv")    fmt = OutputFormat::Csv;
+    else if (name == "raw")    fmt = OutputFormat::Raw;
+    else return false;
+    return true;
+}
+
+
+// Built once from PARAMS so the columns can't drift from the rows.
+const char* csv_header() {
+    static const std::string header = [] {
+        std::string h = "status,seq,reason";
+        for (const auto& p : PARAMS) {
+            if (!p.tag) continue;
+            h.push_back(',');
+            h.append(p.key.data(), p.key.size());
+        }
+        h += ",extra";
+        return h;
+    }();
+    return header.c_str();
+}
+
+
+// ---------------------------------------------------------------------------
+// format_frames()
+// ---------------
+// Shared body of both format_reply() overloads: `count` frames at `frames`.
+// ---------------------------------------------------------------------------
+static void format_frames(OutputFormat fmt, const std::vector<uint8_t>* frames, size_t count,
+                          std::string& out) {
+    if (fmt == OutputFormat::Raw) {
+        for (size_t i = 0; i < count; ++i) {
+            if (i) out.push_back(' ');
+            put_hex(out, frames[i].data(), frames[i].size());
+        }
+        return;
+    }
+
+    NodeReply r;
+    bool any = false;
+    for (size_t i = 0; i < count; ++i)
+        any = decode_reply_into(frames[i].data(), frames[i].size(), r) || any;
+    if (!any) { format_error(fmt, "bad_frame", 0, out); return; }
+
+    if (fmt == OutputFormat::Jsonl) format_jsonl(r, frames, count, out);
+    else                            format_csv(r, frames, count, out);
+}
+
+
+void format_reply(OutputFormat fmt, const std::vector<std::vector<uint8_t>>& frames, std::string& out) {
+    if (fmt == OutputFormat::Pretty) { out += decode_snapshot(frames); return; }
+    format_frames(fmt, frames.data(), frames.size(), out);
+}
+
+
+void format_reply(OutputFormat fmt, const std::vector<uint8_t>& frame, std::string& out) {
+    if (fmt == OutputFormat::Pretty) { out += decode_pretty(frame); return; }
+    format_frames(fmt, &frame, 1, out);
+}
+
+
+void format_error(OutputFormat fmt, const std::string& reason, unsigned seq, std::string& out) {
+    if (fmt == OutputFormat::Jsonl) {
+        out += "{\"status\":\"error\"";
+        if (seq) { out += ",\"seq\":"; put_int(out, seq); }
+        out += ",\"reason\":";
+        put_json_string(out, reason);
+        out.push_back('}');
+        return;
+    }
+    if (fmt == OutputFormat::Csv) {
+        out += "error,";
+        if (seq) put_int(out, seq);
+        out.push_back(',');
+        put_csv_cell(out, reason);
+        for (size_t i = 0; i < param_field_count() + 1; ++i) out.push_back(',');
+        return;
+    }
+    // Pretty and raw share the CLI's usual error line
+    out += "status=error reason=";
+    out += reason;
+    if (seq) { out += " seq="; put_int(out, seq); }
+}
+
+
+void tag_with_node(OutputFormat fmt, const std::string& node, std::string& line) {
+    std::string prefix;
+    if (fmt == OutputFormat::Jsonl && !line.empty() && line[0] == '{') {
+        prefix = "{\"node\":";
+        put_json_string(prefix, node);
+        prefix.push_back(',');
+        line.replace(0, 1, prefix);
+        return;
+    }
+    if (fmt == OutputFormat::Csv) {
+        put_csv_cell(prefix, node);
+        prefix.push_back(',');
+    } else {
+        prefix = "node=" + node + " ";
+    }
+    line.insert(0, prefix);
+}
+
+} // namespace viatext
@@ -0,0 +1,264 @@
+// ============================================================================
+// poller.cpp — implementation for poller.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file poller.cpp
+ */
+
+#include "poller.hpp"         // PollGroup, parse_poll_group(), run_poll()
+#include "commands.hpp"       // make_get_params(), decode_pretty()
+#include "daemon.hpp"         // daemon_connect(), daemon_request() when viatextd runs
+#include "param_table.hpp"    // find_param() for tag names
+#include "serial_io.hpp"      // open_serial(), write_frame(), close_serial()
+#include "session.hpp"        // read_reply()
+#include "stats.hpp"          // --stats: timeouts
+
+#include <algorithm>          // std::min, std::find over due tags
+#include <atomic>             // stop flag shared by the handler and node threads
+#include <chrono>             // schedule, wall-clock sample stamps
+#include <csignal>            // SIGINT/SIGTERM stop the poller
+#include <cstdlib>            // std::strtol for intervals
+#include <mutex>              // one sample line at a time
+#include <ostream>            // sample and summary lines
+#include <thread>             // one worker per node
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - MIN_INTERVAL_MS: below this the link round trip dominates the period.
+// - SLICE_MS: longest uninterrupted sleep, so a stop signal is noticed.
+// - SEQ_MAX: stay below the readiness PING range (0xF0..0xFF).
+// ---------------------------------------------------------------------------
+static constexpr int MIN_INTERVAL_MS = 100;
+static constexpr int SLICE_MS        = 100;
+static constexpr uint8_t SEQ_MAX     = 0xEF;
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<bool> stop_requested{false};
+
+static void on_stop_signal(int) { stop_requested = true; }
+
+
+// -------- parsing --------
+
+bool parse_poll_group(const std::string& interval, const std::string& tags,
+                      PollGroup& g, std::string& err) {
+    g = PollGroup{};
+
+    char* end = nullptr;
+    const long n = std::strtol(interval.c_str(), &end, 10);
+    const std::string unit = end ? end : "";
+    long ms = -1;
+    if (end != interval.c_str() && n > 0) {
+        if (unit.empty() || unit == "s") ms = n * 1000;
+        else if (unit == "ms")           ms = n;
+        else if (unit == "m")            ms = n * 60 * 1000;
+    }
+    if (ms < MIN_INTERVAL_MS || ms > 24L * 3600 * 1000) { err = "bad_value:poll_interval"; return false; }
+    g.interval_ms = static_cast<int>(ms);
+
+    size_t start = 0;
+    while (start <= tags.size()) {
+        size_t comma = tags.find(',', start);
+        if (comma == std::string::npos) comma = tags.size();
+        const std::string name = tags.substr(start, comma - start);
+        start = comma + 1;
+        if (name.empty()) continue;
+
+        const ParamDef* p = find_param(name, /*is_set=*/false);
+        if (!p) { err = "unknown_get:" + name; return false; }
+        if (!p->tag) { err = "not_batchable:" + name; return false; }
+        if (std::find(g.tags.begin(), g.tags.end(), p->tag) == g.tags.end()) g.tags.push_back(p->tag);
+    }
+    if (g.tags.empty()) { err = "unknown_get"; return false; }
+    return true;
+}
+
+
+// -------- one node --------
+
+/** Counters for one node, reported on stop. */
+struct PollStats {
+    unsigned polls = 0, ok = 0, timeouts = 0, missed = 0;
+};
+
+/*
+ * Link
+ * ----
+ * Either a kept-open tty or a daemon connection; (re)established lazily so
+ * a node that is briefly unplugged recovers at its next slot.
+ */
+struct Link {
+    const NodeInfo& node;
+    const PollOptions& opt;
+    int fd = -1;       // tty (direct)
+    int sock = -1;     // viatextd connection
+
+    ~Link() { close_serial(fd); daemon_close(sock); }
+
+    // Send one request and wait for its reply; `err` names the failure.
+    bool request(const std::vector<uint8_t>& req, int timeout_ms,
+                 std::vector<uint8_t>& resp, std::string& err) {
+        if (!opt.daemon_socket.empty()) {
+            if (sock < 0) sock = daemon_connect(opt.daemon_socket);
+            if (sock < 0) { err = "daemon_failed"; return false; }
+            std::vector<std::vector<uint8_t>> frames;
+            const std::string target = node.id.empty() ? node.dev_path : node.id;
+            if (!daemon_request(sock, target, req, timeout_ms, frames, err)) {
+                daemon_close(sock);
+                sock = -1;
+                err = "daemon_failed";
+                return false;
+            }
+            if (!err.empty()) return false;
+            resp = frames.front();
+            return true;
+        }
+
+        if (fd < 0) {
+            fd = opt.boot_delay_ms < 0 ? open_node(node.dev_path, opt.baud)
+                                       : open_serial(node.dev_path, opt.baud, opt.boot_delay_ms);
+            if (fd < 0) { err = "open_failed"; return false; }
+        }
+        if (!write_frame(fd, req)) {
+            close_serial(fd);
+            fd = -1;
+            err = "write_failed";
+            return false;
+        }
+        if (!read_reply(fd, req[2], resp, timeout_ms)) {
+            stats_count(fd, Counter::Timeouts);
+            err = "timeout";
+            return false;
+        }
+        return true;
+    }
+};
+
+// Sleep until `t` in slices; false if a stop was requested first.
+static bool sleep_until(Clock::time_point t) {
+    while (!stop_requested) {
+        const auto now = Clock::now();
+        if (now >= t) return true;
+        std::this_thread::sleep_for(std::min<Clock::duration>(t - now, std::chrono::milliseconds(SLICE_MS)));
+    }
+    return false;
+}
+
+static long long epoch_ms() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+
+// ---------------------------------------------------------------------------
+// poll_node()
+// -----------
+// 1) Every group is first due at start + phase; afterwards at +interval.
+// 2) Sleep to the earliest due time, take every group that is due, merge
+//    their tags, and advance each group past now (slots skipped on the way
+//    are missed deadlines).
+// 3) One GET_PARAM, one sample line.
+// ---------------------------------------------------------------------------
+static void poll_node(const NodeInfo& node, const std::vector<PollGroup>& groups, const PollOptions& opt,
+                      Clock::time_point start, std::ostream& samples, std::mutex& out_mu, PollStats& st) {
+    const std::string label = node.id.empty() ? node.dev_path : node.id;
+    int shortest = groups.front().interval_ms;
+    for (const auto& g : groups) shortest = std::min(shortest, g.interval_ms);
+    const int timeout_ms = std::min(opt.timeout_ms, shortest);
+
+    std::vector<Clock::time_point> next(groups.size(), start);
+    std::vector<uint8_t> tags, resp;
+    std::string err;
+    Link link{node, opt};
+    uint8_t seq = 0;
+
+    while (true) {
+        const auto due = *std::min_element(next.begin(), next.end());
+        if (!sleep_until(due)) break;
+
+        const auto now = Clock::now();
+        tags.clear();
+        for (size_t i = 0; i < groups.size(); ++i) {
+            if (next[i] > now) continue;
+            for (uint8_t t : groups[i].tags)
+                if (std::find(tags.begin(), tags.end(), t) == tags.end()) tags.push_back(t);
+            const auto period = std::chrono::milliseconds(groups[i].interval_ms);
+            next[i] += period;
+            while (next[i] <= now) { next[i] += period; ++st.missed; }
+        }
+
+        seq = seq >= SEQ_MAX ? 1 : static_cast<uint8_t>(seq + 1);
+        const auto req = make_get_params(seq, tags);
+        ++st.polls;
+
+        std::string line = std::to_string(epoch_ms()) + " " + label + " ";
+        err.clear();
+        if (!req.empty() && link.request(req, timeout_ms, resp, err)) {
+            ++st.ok;
+            const std::string pretty = decode_pretty(resp);      // "status=ok seq=N k=v ..."
+            const auto cut = pretty.find(' ', pretty.find(' ') + 1);
+            line += (resp[0] == RESP_OK && cut != std::string::npos) ? pretty.substr(cut + 1) : pretty;
+        } else {
+            if (err == "timeout") ++st.timeouts;
+            line += "status=error reason=" + (req.empty() ? std::string("batch_too_large") : err);
+        }
+
+        std::lock_guard<std::mutex> lk(out_mu);
+        samples << line << '\n';
+        samples.flush();
+    }
+}
+
+
+// -------- public API --------
+
+/*
+ * run_poll()
+ * ----------
+ * Spread the node phases over the shortest interval, start one thread per
+ * node, wait for a stop signal, then print the counters.
+ */
+int run_poll(const std::vector<NodeInfo>& targets, const std::vector<PollGroup>& groups,
+             const PollOptions& opt, std::ostream& samples, std::ostream& log) {
+    if (targets.empty() || groups.empty()) return static_cast<int>(targets.size());
+
+    struct sigaction sa{};
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    int shortest = groups.front().interval_ms;
+    for (const auto& g : groups) shortest = std::min(shortest, g.interval_ms);
+
+    std::mutex out_mu;
+    std::vector<PollStats> stats(targets.size());
+    std::vector<std::thread> workers;
+    workers.reserve(targets.size());
+
+    const auto t0 = Clock::now();
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto phase = std::chrono::milliseconds(static_cast<long long>(shortest) * i / targets.size());
+        workers.emplace_back(poll_node, std::cref(targets[i]), std::cref(groups), std::cref(opt),
+                             t0 + phase, std::ref(samples), std::ref(out_mu), std::ref(stats[i]));
+    }
+    for (auto& w : workers) w.join();
+
+    int silent = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto& s = stats[i];
+        if (s.ok == 0) ++silent;
+        log << "event=poll_summary node=" << (targets[i].id.empty() ? targets[i].dev_path : targets[i].id)
+            << " polls=" << s.polls << " ok=" << s.ok << " timeouts=" << s.timeouts
+            << " missed=" << s.missed << "\n";
+    }
+    log.flush();
+    return silent;
+}
+
+} // namespace viatext
@@ -0,0 +1,221 @@
+// ============================================================================
+// profile.cpp — implementation for profile.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file profile.cpp
+ */
+
+#include "profile.hpp"          // Profile, parse_profile(), run_apply()
+#include "command_dispatch.hpp" // build_param_get_batch(), build_param_set_batch()
+#include "commands.hpp"         // RESP_OK/RESP_ERR, TlvCursor
+#include "param_table.hpp"      // find_param(), param_for_tag(), param_value()
+
+#include <algorithm>            // std::equal on value bytes
+#include <istream>              // profile text
+#include <ostream>              // result lines
+#include <utility>              // std::pair for the SET batch
+
+namespace viatext {
+
+// Request seqs of the three steps; any fixed, distinct values in 1..0xEF do.
+static constexpr uint8_t SEQ_SNAPSHOT = 1;
+static constexpr uint8_t SEQ_SET      = 2;
+static constexpr uint8_t SEQ_VERIFY   = 3;
+
+
+// -------- profile file --------
+
+static std::string trim(const std::string& s) {
+    const auto b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return {};
+    return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+/*
+ * parse_profile()
+ * ---------------
+ * Each line goes through build_param_set_batch() on its own, so names,
+ * aliases and range checks are exactly those of `--set`; the TLV is cut out
+ * of the frame it built. A last batch over every line checks the size.
+ */
+bool parse_profile(std::istream& in, Profile& prof, std::string& err) {
+    prof.clear();
+    std::vector<std::pair<std::string, std::string>> all;
+    std::string raw;
+    std::vector<uint8_t> frame;
+    for (int lineno = 1; std::getline(in, raw); ++lineno) {
+        const auto hash = raw.find('#');
+        const std::string line = trim(hash == std::string::npos ? raw : raw.substr(0, hash));
+        if (line.empty()) continue;
+
+        const auto sep = line.find_first_of("= \t");
+        const std::string name = trim(line.substr(0, sep));
+        std::string value = sep == std::string::npos ? "" : trim(line.substr(sep));
+        if (!value.empty() && value[0] == '=') value = trim(value.substr(1));
+
+        const ParamDef* p = find_param(name, /*is_set=*/true);
+        if (!build_param_set_batch({{name, value}}, SEQ_SET, frame, err)) {
+            err += " line=" + std::to_string(lineno);
+            return false;
+        }
+        for (const auto& it : prof) {
+            if (it.tag != p->tag) continue;
+            err = "profile_duplicate:" + std::string(p->name) + " line=" + std::to_string(lineno);
+            return false;
+        }
+
+        ProfileItem it;
+        it.name.assign(p->name.data(), p->name.size());
+        it.value = value;
+        it.tag = p->tag;
+        it.tlv.assign(frame.begin() + FRAME_HEADER, frame.end());
+        prof.push_back(std::move(it));
+        all.emplace_back(name, value);
+    }
+    if (prof.empty()) { err = "profile_empty"; return false; }
+    return build_param_set_batch(all, SEQ_SET, frame, err);   // batch_too_large
+}
+
+
+// -------- applying --------
+
+// Value of a [tag][len][value] TLV for the result line.
+static std::string render(uint8_t tag, const uint8_t* val, size_t len) {
+    const ParamDef* p = param_for_tag(tag);
+    int64_t v = 0;
+    if (p && param_value(*p, TlvView{tag, static_cast<uint8_t>(len), val}, v)) return std::to_string(v);
+    return std::string(reinterpret_cast<const char*>(val), len);
+}
+
+// Where one node stands; indices point into the profile.
+struct NodeApply {
+    enum class Step { Snapshot, Set, Verify } step = Step::Snapshot;
+    std::vector<size_t> changed;
+    std::string diff;             // "sf:7>9,bw:250000>125000"
+};
+
+struct Apply {
+    const Profile& prof;
+    std::vector<NodeApply> nodes;
+    std::vector<uint8_t> snapshot;   // GET_PARAM of every profile tag
+
+    Apply(const Profile& p, size_t n) : prof(p), nodes(n) {}
+
+    // Tag -> value TLV of one RESP_OK frame (GET_PARAM answers one TLV per tag).
+    static const uint8_t* find(const std::vector<uint8_t>& f, uint8_t tag, size_t& len) {
+        TlvCursor cur(f.data(), f.size());
+        TlvView t;
+        while (cur.next(t))
+            if (t.tag == tag) { len = t.len; return t.val; }
+        return nullptr;
+    }
+
+    static bool same(const ProfileItem& it, const uint8_t* val, size_t len) {
+        return val && len + 2 == it.tlv.size() && std::equal(val, val + len, it.tlv.begin() + 2);
+    }
+
+    std::string summary(const NodeApply& n) const {
+        return " changed=" + (n.diff.empty() ? std::string("none") : n.diff)
+             + " unchanged=" + std::to_string(prof.size() - n.changed.size());
+    }
+
+    StepNext fail(std::string& line, const std::string& reason, const NodeApply& n) {
+        line = "status=error reason=" + reason + summary(n);
+        return StepNext::Failed;
+    }
+
+    StepNext step(size_t i, const char* err, const std::vector<std::vector<uint8_t>>& frames,
+                  std::vector<uint8_t>& next, std::string& line) {
+        NodeApply& n = nodes[i];
+        static const char* const STEP_NAMES[] = {"snapshot", "set", "verify"};
+        if (err) {
+            line = std::string("status=error reason=") + err + " step=" + STEP_NAMES[static_cast<int>(n.step)];
+            if (n.step != NodeApply::Step::Snapshot) line += summary(n);   // what the SET carried
+            return StepNext::Failed;
+        }
+        if (frames.empty()) return fail(line, "timeout", n);
+        const std::vector<uint8_t>& f = frames.front();
+        std::string derr;
+
+        switch (n.step) {
+        case NodeApply::Step::Snapshot: {
+            if (f[0] != RESP_OK) return fail(line, "snapshot_refused", n);
+            std::vector<std::pair<std::string, std::string>> kv;
+            for (size_t k = 0; k < prof.size(); ++k) {
+                const ProfileItem& it = prof[k];
+                size_t len = 0;
+                const uint8_t* val = find(f, it.tag, len);
+                if (same(it, val, len)) continue;
+                n.changed.push_back(k);
+                kv.emplace_back(it.name, it.value);
+                if (!n.diff.empty()) n.diff += ',';
+                n.diff += it.name + ":" + (val ? render(it.tag, val, len) : "?") + ">" + it.value;
+            }
+            if (kv.empty()) { line = "status=ok" + summary(n); return StepNext::Done; }
+            if (!build_param_set_batch(kv, SEQ_SET, next, derr)) return fail(line, derr, n);
+            n.step = NodeApply::Step::Set;
+            return StepNext::Send;
+        }
+        case NodeApply::Step::Set: {
+            if (f[0] != RESP_OK) {
+                TlvCursor cur(f.data(), f.size());                 // the node names the TLV it refused
+                TlvView t;
+                const ParamDef* p = cur.next(t) ? param_for_tag(t.tag) : nullptr;
+                NodeApply none;
+                none.changed = n.changed;                          // nothing was written
+                return fail(line, p ? "set_refused:" + std::string(p->name) : "set_refused", none);
+            }
+            std::vector<std::string> names;
+            for (size_t k : n.changed) names.push_back(prof[k].name);
+            if (!build_param_get_batch(names, SEQ_VERIFY, next, derr)) return fail(line, derr, n);
+            n.step = NodeApply::Step::Verify;
+            return StepNext::Send;
+        }
+        case NodeApply::Step::Verify: {
+            std::string bad;
+            for (size_t k : n.changed) {
+                size_t len = 0;
+                const uint8_t* val = f[0] == RESP_OK ? find(f, prof[k].tag, len) : nullptr;
+                if (same(prof[k], val, len)) continue;
+                if (!bad.empty()) bad += ',';
+                bad += prof[k].name;
+            }
+            if (!bad.empty()) return fail(line, "verify_failed:" + bad, n);
+            line = "status=ok" + summary(n);
+            return StepNext::Done;
+        }
+        }
+        return fail(line, "unhandled_command", n);
+    }
+};
+
+/*
+ * run_apply()
+ * -----------
+ * Frames are matched to their request by the fan-out, so every step sees
+ * exactly its own reply; `frames` is never empty when `err` is null.
+ */
+int run_apply(const std::vector<NodeInfo>& targets, const Profile& prof, const FanoutOptions& opt,
+              int daemon_sock, std::ostream& out) {
+    Apply a(prof, targets.size());
+    std::vector<std::string> names;
+    for (const auto& it : prof) names.push_back(it.name);
+    std::string err;
+    if (!build_param_get_batch(names, SEQ_SNAPSHOT, a.snapshot, err)) {
+        out << "status=error reason=" << err << "\n";
+        return static_cast<int>(targets.size());
+    }
+
+    const FanoutStep step = [&a](size_t i, const char* e, const std::vector<std::vector<uint8_t>>& frames,
+                                 std::vector<uint8_t>& next, std::string& line) {
+        return a.step(i, e, frames, next, line);
+    };
+    FanoutOptions o = opt;
+    o.fmt = OutputFormat::Pretty;
+    return daemon_sock >= 0 ? run_fanout_steps_remote(daemon_sock, targets, a.snapshot, step, o, out)
+                            : run_fanout_steps(targets, a.snapshot, step, o, out);
+}
+
+} // namespace viatext
@@ -0,0 +1,209 @@
+// ============================================================================
+// reply_cache.cpp — implementation for reply_cache.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file reply_cache.cpp
+ */
+
+#include "reply_cache.hpp"    // ReplyCache, cache_lookup(), cache_update()
+#include "commands.hpp"       // verbs, TlvCursor, make_get_params()
+#include "param_table.hpp"    // param_for_tag(), Cache classes
+#include "stats.hpp"          // host-wide cache_hits / cache_misses for --stats
+
+#include <algorithm>          // std::min
+
+namespace viatext {
+
+using Clock = std::chrono::steady_clock;
+
+// Lifetime per Cache class (see the table in reply_cache.hpp).
+static constexpr int TTL_IDENTITY_MS = 10 * 60 * 1000;
+static constexpr int TTL_CONFIG_MS   =  5 * 60 * 1000;
+static constexpr int TTL_LIVE_MS     =  2 * 1000;
+
+
+int cache_ttl_ms(uint8_t tag) {
+    const ParamDef* p = param_for_tag(tag);
+    if (!p) return 0;
+    switch (p->cache) {
+        case Cache::Identity: return TTL_IDENTITY_MS;
+        case Cache::Config:   return TTL_CONFIG_MS;
+        case Cache::Live:     return TTL_LIVE_MS;
+        default:              return 0;
+    }
+}
+
+
+// Caller holds c.mu.
+static void erase_node(ReplyCache& c, const std::string& node) {
+    auto it = c.entries.lower_bound({node, 0});
+    while (it != c.entries.end() && it->first.first == node) it = c.entries.erase(it);
+}
+
+
+// Views of the TLVs in a bare TLV section [p, end).
+static void collect_tlvs(const uint8_t* p, const uint8_t* end, std::vector<TlvView>& out) {
+    while (end - p >= 2 && end - (p + 2) >= p[1]) {
+        out.push_back({p[0], p[1], p + 2});
+        p += 2 + p[1];
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// asked_tags()
+// ------------
+// The tags a read request asks for: TAG_ID for GET_ID, the len=0 TLVs of a
+// GET_PARAM. False for anything else (writes, GET_ALL, PING, or a GET_PARAM
+// carrying values), which the cache then leaves alone.
+// ---------------------------------------------------------------------------
+static bool asked_tags(const std::vector<uint8_t>& req, std::vector<uint8_t>& tags) {
+    tags.clear();
+    if (req.size() < FRAME_HEADER) return false;
+    if (req[0] == GET_ID) { tags.push_back(TAG_ID); return true; }
+    if (req[0] != GET_PARAM) return false;
+
+    TlvCursor cur(req.data(), req.size());
+    TlvView t;
+    while (cur.next(t)) {
+        if (t.len != 0) return false;
+        tags.push_back(t.tag);
+    }
+    return !cur.truncated && !tags.empty();
+}
+
+
+// ---------------------------------------------------------------------------
+// cache_lookup()
+// --------------
+// Split the asked tags into fresh (copied into lk.cached) and missing. All
+// fresh: build the reply. Some fresh: narrow the request to the rest.
+// ---------------------------------------------------------------------------
+bool cache_lookup(ReplyCache& c, const std::string& node, const std::vector<uint8_t>& req,
+                  CacheLookup& lk) {
+    lk.cached.clear();
+    lk.reply.clear();
+    lk.fetch = req;
+
+    std::vector<uint8_t> tags, missing;
+    uint64_t hits = 0, misses = 0;
+    {
+        std::lock_guard<std::mutex> g(c.mu);
+        auto w = c.writes.find(node);
+        lk.writes = w == c.writes.end() ? 0 : w->second;
+        if (!asked_tags(req, tags)) return false;
+
+        const auto now = Clock::now();
+        for (uint8_t tag : tags) {
+            auto it = c.entries.find({node, tag});
+            if (it != c.entries.end() && it->second.expires > now) {
+                lk.cached.insert(lk.cached.end(), it->second.tlv.begin(), it->second.tlv.end());
+                ++hits;
+            } else {
+                missing.push_back(tag);
+                if (cache_ttl_ms(tag) > 0) ++misses;
+            }
+        }
+        c.hits += hits;
+        c.misses += misses;
+    }
+    if (hits)   stats_count(-1, Counter::CacheHits, hits);
+    if (misses) stats_count(-1, Counter::CacheMisses, misses);
+
+    if (lk.cached.empty()) return false;
+    if (lk.cached.size() > 255) { lk.cached.clear(); return false; }   // can't fit one reply frame
+
+    if (missing.empty()) {
+        lk.fetch.clear();
+        lk.reply = {RESP_OK, 0, req[2], static_cast<uint8_t>(lk.cached.size())};
+        lk.reply.insert(lk.reply.end(), lk.cached.begin(), lk.cached.end());
+        return true;
+    }
+
+    lk.fetch = make_get_params(req[2], missing);
+    if (lk.fetch.empty()) { lk.fetch = req; lk.cached.clear(); }    // too many to narrow: send as is
+    return false;
+}
+
+
+// ---------------------------------------------------------------------------
+// cache_update()
+// --------------
+// 1) SETs invalidate what they touched (SET_ID: the whole node) and count
+//    as a write on the node.
+// 2) RESP_OK frames of reads refresh every cacheable TLV they carry, unless
+//    a write happened since their lookup.
+// 3) A narrowed reply gets the cached TLVs back, in request order.
+// ---------------------------------------------------------------------------
+void cache_update(ReplyCache& c, const std::string& node, const std::vector<uint8_t>& req,
+                  const CacheLookup& lk, std::vector<std::vector<uint8_t>>& frames) {
+    if (req.size() < FRAME_HEADER) return;
+    const uint8_t verb = req[0];
+
+    {
+        std::lock_guard<std::mutex> g(c.mu);
+
+        if (verb == SET_PARAM) {
+            TlvCursor cur(req.data(), req.size());
+            TlvView t;
+            while (cur.next(t)) c.entries.erase({node, t.tag});
+            ++c.writes[node];
+        } else if (verb == SET_ID) {
+            erase_node(c, node);
+            ++c.writes[node];
+        } else if ((verb == GET_ID || verb == GET_PARAM || verb == GET_ALL)
+                   && c.writes[node] == lk.writes) {          // no SET overtook this read
+            const auto now = Clock::now();
+            for (const auto& f : frames) {
+                if (f.size() < FRAME_HEADER || f[0] != RESP_OK) continue;
+                TlvCursor cur(f.data(), f.size());
+                TlvView t;
+                while (cur.next(t)) {
+                    const int ttl = cache_ttl_ms(t.tag);
+                    if (ttl <= 0 || t.len == 0) continue;          // len 0: node has no value
+                    auto& e = c.entries[{node, t.tag}];
+                    e.tlv.assign(t.val - 2, t.val + t.len);        // [tag][len][value]
+                    e.expires = now + std::chrono::milliseconds(ttl);
+                }
+            }
+        }
+    }
+
+    if (lk.cached.empty() || frames.size() != 1) return;
+    auto& f = frames.front();
+    if (f.size() < FRAME_HEADER || f[0] != RESP_OK) return;           // errors pass through untouched
+    const size_t own = std::min<size_t>(f[3], f.size() - FRAME_HEADER);
+    if (own + lk.cached.size() > 255) return;
+
+    // Rebuild the TLV section in the order the request asked for the tags;
+    // anything extra the node sent goes last.
+    std::vector<uint8_t> tags;
+    asked_tags(req, tags);
+    std::vector<TlvView> parts;
+    collect_tlvs(lk.cached.data(), lk.cached.data() + lk.cached.size(), parts);
+    collect_tlvs(f.data() + FRAME_HEADER, f.data() + FRAME_HEADER + own, parts);
+
+    std::vector<uint8_t> merged(f.begin(), f.begin() + FRAME_HEADER);
+    merged[3] = static_cast<uint8_t>(own + lk.cached.size());
+    std::vector<bool> used(parts.size(), false);
+    auto put = [&](size_t i) {
+        used[i] = true;
+        merged.insert(merged.end(), parts[i].val - 2, parts[i].val + parts[i].len);
+    };
+    for (uint8_t tag : tags)
+        for (size_t i = 0; i < parts.size(); ++i)
+            if (!used[i] && parts[i].tag == tag) { put(i); break; }
+    for (size_t i = 0; i < parts.size(); ++i)
+        if (!used[i]) put(i);
+    f.swap(merged);
+}
+
+
+void cache_forget(ReplyCache& c, const std::string& node) {
+    std::lock_guard<std::mutex> g(c.mu);
+    erase_node(c, node);
+}
+
+} // namespace viatext
@@ -0,0 +1,70 @@
+// ============================================================================
+// serial_baud.cpp — termios2 / driver-ioctl half of serial_io.hpp
+// For API/overview see serial_io.hpp.
+//
+// Kept apart from serial_io.cpp on purpose: <asm/termbits.h> (struct termios2,
+// BOTHER) redefines struct termios and the B* macros from glibc's <termios.h>,
+// so the two headers cannot share a translation unit.
+// ============================================================================
+
+/**
+ * @file serial_baud.cpp
+ */
+
+#include "serial_io.hpp"      // set_custom_baud(), set_low_latency()
+
+#include <asm/termbits.h>     // struct termios2, BOTHER, CBAUD, IBSHIFT
+#include <asm/ioctls.h>       // TCGETS2 / TCSETS2
+#include <linux/serial.h>     // struct serial_struct, ASYNC_LOW_LATENCY
+#include <sys/ioctl.h>        // ioctl(2)
+#include <cerrno>             // EINVAL for a rate the driver won't take
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// set_custom_baud()
+// -----------------
+// 1) TCGETS2 the current kernel termios (raw mode was already applied).
+// 2) Replace the speed bits with BOTHER for both directions and put the
+//    literal rate in c_ispeed/c_ospeed.
+// 3) TCSETS2, then read back: drivers round to what their divisor can hit
+//    (or silently keep the old rate), so accept only within 3%.
+// A rate the driver won't take fails with errno = EINVAL; an ioctl that
+// fails outright (ENOTTY, EIO, ...) keeps its own errno.
+// ---------------------------------------------------------------------------
+bool set_custom_baud(int fd, int baud) {
+    if (baud <= 0) { errno = EINVAL; return false; }
+
+    struct termios2 tio{};
+    if (::ioctl(fd, TCGETS2, &tio) != 0) return false;
+
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = static_cast<speed_t>(baud);
+    tio.c_ospeed = static_cast<speed_t>(baud);
+    if (::ioctl(fd, TCSETS2, &tio) != 0) return false;
+
+    struct termios2 got{};
+    if (::ioctl(fd, TCGETS2, &got) != 0) return false;
+    const long diff = static_cast<long>(got.c_ospeed) - baud;
+    if ((diff < 0 ? -diff : diff) * 100 > 3L * baud) { errno = EINVAL; return false; }
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// set_low_latency()
+// -----------------
+// usb-serial drivers map ASYNC_LOW_LATENCY to their shortest receive
+// latency (ftdi_sio: latency timer 16 ms -> 1 ms). CDC-ACM and ptys don't
+// implement TIOCSSERIAL; that's reported as false and is harmless.
+// ---------------------------------------------------------------------------
+bool set_low_latency(int fd) {
+    struct serial_struct ss{};
+    if (::ioctl(fd, TIOCGSERIAL, &ss) != 0) return false;
+    if (ss.flags & ASYNC_LOW_LATENCY) return true;
+    ss.flags |= ASYNC_LOW_LATENCY;
+    return ::ioctl(fd, TIOCSSERIAL, &ss) == 0;
+}
+
+} // namespace viatext
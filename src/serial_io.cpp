@@ -9,6 +9,9 @@
 
 #include "serial_io.hpp"   // declarations for open_serial(), write_frame(), read_frame(), close_serial()
 #include "slip.hpp"        // viatext::slip::encode() and decoder for frame boundaries
+#include "stats.hpp"       // --stats hooks: phases, bytes, frames, SLIP errors
+#include "link_guard.hpp"  // CRC trailers and fast resends per fd
+#include "commands.hpp"    // CRC_LEN: room for a trailer per frame
 
 // POSIX / termios headers for low-level serial port handling
 #include <fcntl.h>         // ::open flags (O_RDWR, O_NOCTTY, etc.)
@@ -16,9 +19,132 @@
 #include <termios.h>       // termios struct + raw mode helpers
 #include <poll.h>          // poll(2) for timeout-based read loop
 #include <cstring>         // memset, etc. (used indirectly by termios calls)
+#include <cerrno>          // errno checks for EINTR/EAGAIN in the read loop
+#include <sys/file.h>      // flock(2): exclusive ports (set_exclusive_open())
+#include <atomic>          // process-wide exclusive-open switch
+#include <algorithm>       // std::max for the resend write deadline
+#include <chrono>          // steady_clock deadline so partial reads don't extend the timeout
+#include <mutex>           // guards the per-fd receive table
+#include <unordered_map>   // fd -> receive state
 
 namespace viatext {
 
+// ---------------------------------------------------------------------------
+// Per-fd receive state
+// --------------------
+// read_frame() pulls bytes in bulk (RX_CHUNK at a time), so one ::read() can
+// return the tail of this frame plus the start of the next. Those extra bytes
+// and the decoder's partial-frame state are kept here, keyed by fd, so the
+// next read_frame() call starts from them instead of losing them.
+//
+// Lifetime: entries are reset by open_serial() and erased by close_serial().
+// The mutex only guards the table itself; a single fd must still not be read
+// from two threads at once (see serial_io.hpp).
+// ---------------------------------------------------------------------------
+static constexpr size_t RX_CHUNK = 4096;          // bytes requested per ::read()
+static constexpr size_t RX_MAX_FRAME = 1024;      // ViaText frames are <= 259 bytes; headroom for trailers
+
+struct RxState {
+    RxState() { dec.max_frame = RX_MAX_FRAME; }    // line noise can't grow the accumulator
+    viatext::slip::decoder dec;                   // framing state survives between calls
+    std::vector<uint8_t> pending;                 // bytes read but not yet fed to dec
+    size_t pos = 0;                               // next unread index into pending
+};
+
+static std::mutex rx_mu;
+static std::unordered_map<int, RxState> rx_table;
+
+static RxState& rx_state(int fd) {
+    std::lock_guard<std::mutex> lk(rx_mu);
+    return rx_table[fd];                          // node references stay valid across inserts
+}
+
+static void rx_forget(int fd) {
+    std::lock_guard<std::mutex> lk(rx_mu);
+    rx_table.erase(fd);
+}
+
+// Feed carried-over bytes into the decoder; true once a frame lands in 'out'.
+// The buffer form of feed() copies whole runs and stops after one frame, so
+// the bytes behind it stay in 'pending' for the next call. take() swaps the
+// payload into 'out', so delivery costs no copy and both buffers keep their
+// capacity.
+static bool drain_pending(RxState& st, std::vector<uint8_t>& out, int fd) {
+    bool got = false;
+    if (st.pos < st.pending.size()) {
+        const size_t dropped = st.dec.dropped;
+        st.pos += st.dec.feed(st.pending.data() + st.pos, st.pending.size() - st.pos,
+                              [&](const uint8_t*, size_t) {
+                                  st.dec.take(out);
+                                  got = true;
+                                  return false;   // one frame per read_frame()
+                              });
+        if (st.dec.dropped != dropped) stats_count(fd, Counter::SlipErrors, st.dec.dropped - dropped);
+    }
+    if (st.pos >= st.pending.size()) {
+        st.pending.clear();                       // fully consumed
+        st.pos = 0;
+    }
+    return got;
+}
+
+// ---------------------------------------------------------------------------
+// Standard termios speeds
+// -----------------------
+// Rates with a B* constant go through cfsetspeed(); anything else is set with
+// termios2/BOTHER by set_custom_baud() (serial_baud.cpp). The high rates are
+// guarded because not every libc exposes all of them.
+// ---------------------------------------------------------------------------
+struct BaudConst { int baud; speed_t sp; };
+
+static const BaudConst BAUDS[] = {
+    {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600}, {19200, B19200},
+    {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+#ifdef B460800
+    {460800, B460800},
+#endif
+#ifdef B500000
+    {500000, B500000},
+#endif
+#ifdef B576000
+    {576000, B576000},
+#endif
+#ifdef B921600
+    {921600, B921600},
+#endif
+#ifdef B1000000
+    {1000000, B1000000},
+#endif
+#ifdef B1152000
+    {1152000, B1152000},
+#endif
+#ifdef B1500000
+    {1500000, B1500000},
+#endif
+#ifdef B2000000
+    {2000000, B2000000},
+#endif
+#ifdef B2500000
+    {2500000, B2500000},
+#endif
+#ifdef B3000000
+    {3000000, B3000000},
+#endif
+#ifdef B3500000
+    {3500000, B3500000},
+#endif
+#ifdef B4000000
+    {4000000, B4000000},
+#endif
+};
+
+static bool baud_constant(int baud, speed_t& sp) {
+    for (const auto& b : BAUDS) {
+        if (b.baud == baud) { sp = b.sp; return true; }
+    }
+    return false;
+}
+
 // ---------------------------------------------------------------------------
 // set_raw()
 // ----------
@@ -27,7 +153,8 @@ namespace viatext {
 // - Sets VMIN=0, VTIME=0 (non-blocking reads; poll() handles timing).
 // - Flushes both input/output buffers after applying settings.
 //
-// Returns: true on success, false if tcgetattr/tcsetattr fails.
+// Returns: true on success, false if tcgetattr/tcsetattr fails (their errno)
+//          or the driver kept a different speed than requested (EINVAL).
 //
 // Design:
 // - We keep this static since it's an internal helper for open_serial() only.
@@ -48,6 +175,11 @@ static bool set_raw(int fd, speed_t baud) {
 
     if (tcsetattr(fd, TCSANOW, &tio) != 0) return false;  // apply immediately
     tcflush(fd, TCIOFLUSH);                       // flush in/out buffers
+
+    // tcsetattr() succeeds if *any* change was applied; confirm the speed stuck
+    termios got{};
+    if (tcgetattr(fd, &got) != 0) return false;
+    if (cfgetospeed(&got) != baud) { errno = EINVAL; return false; }
     return true;
 }
 
@@ -57,47 +189,154 @@ static bool set_raw(int fd, speed_t baud) {
 // -------------
 // Open and initialize a serial port at the requested baud.
 // - Applies O_NOCTTY (don’t steal controlling terminal) and O_NONBLOCK.
-// - Maps common baud integers (9600..230400) to termios constants.
-// - Calls set_raw() to apply 8N1 raw mode.
+// - Standard rates (1200..4000000) use their termios constant; any other
+//   rate is applied with termios2/BOTHER after raw mode is set.
+// - A speed the driver refuses fails the open with errno = EINVAL instead of
+//   silently running at another rate; any other setup failure (EIO, ENOTTY,
+//   ...) keeps its own errno.
+// - With set_exclusive_open() on, flock()s the port before touching it and
+//   fails with errno = EBUSY if another process holds it.
+// - Asks usb-serial drivers for low-latency mode (best effort).
 // - Sleeps boot_delay_ms to allow USB CDC devices to reset on open.
 // - Flushes boot chatter after delay.
 //
 // Returns: file descriptor (>=0) or -1 on failure.
 // ---------------------------------------------------------------------------
+static std::atomic<bool> exclusive_open{false};
+
+void set_exclusive_open(bool on) { exclusive_open.store(on, std::memory_order_relaxed); }
+
 int open_serial(const std::string& dev, int baud, int boot_delay_ms) {
+    if (baud <= 0) { errno = EINVAL; return -1; }
+
+    const auto t0 = std::chrono::steady_clock::now();
     int fd = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (fd < 0) return -1;                        // open failed (perm, missing, etc.)
+    if (exclusive_open.load(std::memory_order_relaxed) && ::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        const int err = errno == EWOULDBLOCK ? EBUSY : errno;   // another viatext process owns it
+        ::close(fd);
+        errno = err;
+        return -1;
+    }
+    stats_bind(fd, dev);
 
-    speed_t sp = B115200;                         // default
-    if      (baud == 9600)   sp = B9600;
-    else if (baud == 19200)  sp = B19200;
-    else if (baud == 38400)  sp = B38400;
-    else if (baud == 57600)  sp = B57600;
-    else if (baud == 230400) sp = B230400;
+    if (isatty(fd)) {                             // files/sockets used in tests have no speed
+        speed_t sp;
+        const bool standard = baud_constant(baud, sp);
+        bool ok = set_raw(fd, standard ? sp : B115200);   // configure low-level mode
+        if (ok && !standard) ok = set_custom_baud(fd, baud);
+        if (!ok) {
+            const int err = errno;                // EINVAL: caller reports baud_unsupported
+            stats_unbind(fd);
+            ::close(fd);
+            errno = err;
+            return -1;
+        }
+        set_low_latency(fd);                      // FTDI: 16 ms latency timer -> 1 ms
+    }
 
-    set_raw(fd, sp);                              // configure low-level mode
+    stats_time(fd, Phase::Open, std::chrono::steady_clock::now() - t0);
 
-    usleep(boot_delay_ms * 1000);                 // allow USB-serial auto-reset
-    tcflush(fd, TCIOFLUSH);                       // flush any reboot chatter
+    if (boot_delay_ms > 0) {
+        StatsTimer boot(fd, Phase::BootDelay);
+        usleep(boot_delay_ms * 1000);             // allow USB-serial auto-reset
+    }
+    {
+        StatsTimer flush(fd, Phase::Flush);
+        tcflush(fd, TCIOFLUSH);                   // flush any reboot chatter
+    }
+    rx_forget(fd);                                // fd numbers are reused; drop stale carry-over
+    link_open(fd);                                // CRC policy: process default (--crc)
     return fd;
 }
 
 
 // ---------------------------------------------------------------------------
-// write_frame()
-// -------------
-// Encode a payload into SLIP format and write it to the serial fd.
+// write_all()
+// -----------
+// Push every byte of [p, p+n) out of a non-blocking fd before the deadline.
+// - A short write advances and writes the rest.
+// - EAGAIN (TX buffer full: a busy USB CDC endpoint, a pipelined burst)
+//   waits for POLLOUT instead of failing.
+// - EINTR retries; any other error, POLLERR/POLLHUP or the deadline fails.
+// ---------------------------------------------------------------------------
+static bool write_all(int fd, const uint8_t* p, size_t n, int timeout_ms) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (n > 0) {
+        const ssize_t w = ::write(fd, p, n);
+        if (w > 0) { p += w; n -= static_cast<size_t>(w); continue; }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              deadline - clock::now()).count();
+        if (left <= 0) return false;
+        stats_count(fd, Counter::Retries);        // driver full: wait and write the rest
+        pollfd pfd{fd, POLLOUT, 0};
+        const int pr = ::poll(&pfd, 1, static_cast<int>(left));
+        if (pr < 0 && errno != EINTR) return false;
+        if (pr > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) return false;
+    }
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+// write_frame() / write_frames()
+// ------------------------------
+// Encode payloads into SLIP format and write them to the serial fd.
 //
-// Returns: true if entire frame was written successfully, false otherwise.
+// Returns: true if every byte was written before the deadline, false otherwise.
 //
 // Notes:
-// - SLIP adds END/ESC bytes so payload boundaries are preserved.
-// - We buffer into a temporary vector before calling ::write().
+// - SLIP adds END/ESC bytes so payload boundaries are preserved; frames
+//   written back to back stay separable, so write_frames() encodes them all
+//   into one buffer and hands the kernel a single contiguous write.
+// - The encoded copy goes into a per-thread buffer that keeps its capacity,
+//   so steady-state sends don't allocate.
+// - On a guarded fd each payload goes out as LinkGuard::outgoing() has it
+//   (flags, trailer) and its encoded bytes are remembered for resends.
 // ---------------------------------------------------------------------------
-bool write_frame(int fd, const std::vector<uint8_t>& payload) {
-    std::vector<uint8_t> out;
-    viatext::slip::encode(payload.data(), payload.size(), out);
-    return ::write(fd, out.data(), out.size()) == (ssize_t)out.size();
+static thread_local std::vector<uint8_t> tx_buf;   // reused; capacity stays
+
+bool write_frame(int fd, const uint8_t* payload, size_t n, int timeout_ms) {
+    LinkGuard* lg = link_guard(fd);
+    const uint8_t* frame = lg ? lg->outgoing(payload, n) : payload;
+    viatext::slip::encode(frame, n, tx_buf);
+    StatsTimer t(fd, Phase::Write);
+    if (!write_all(fd, tx_buf.data(), tx_buf.size(), timeout_ms)) return false;
+    stats_sent(fd, tx_buf.size());
+    if (lg) lg->remember(frame, n, tx_buf.data(), tx_buf.size());
+    return true;
+}
+
+bool write_frame(int fd, const std::vector<uint8_t>& payload, int timeout_ms) {
+    return write_frame(fd, payload.data(), payload.size(), timeout_ms);
+}
+
+bool write_frames(int fd, const std::vector<std::vector<uint8_t>>& payloads, int timeout_ms) {
+    LinkGuard* lg = link_guard(fd);
+    size_t cap = 0;
+    for (const auto& p : payloads) cap += viatext::slip::encoded_max(p.size() + (lg ? CRC_LEN : 0));
+    tx_buf.resize(cap);
+
+    static thread_local std::vector<size_t> ends;     // end of each encoded frame in tx_buf
+    ends.clear();
+    size_t len = 0;
+    for (const auto& p : payloads) {
+        size_t n = p.size();
+        const uint8_t* frame = lg ? lg->outgoing(p.data(), n) : p.data();
+        len += viatext::slip::encode(frame, n, tx_buf.data() + len, cap - len);
+        ends.push_back(len);
+    }
+    StatsTimer t(fd, Phase::Write);
+    if (!write_all(fd, tx_buf.data(), len, timeout_ms)) return false;
+    stats_sent(fd, len, payloads.size());
+    for (size_t i = 0, at = 0; lg && i < payloads.size(); at = ends[i++])   // verb/seq are as in the payload
+        lg->remember(payloads[i].data(), payloads[i].size(), tx_buf.data() + at, ends[i] - at);
+    return true;
 }
 
 
@@ -105,31 +344,66 @@ bool write_frame(int fd, const std::vector<uint8_t>& payload) {
 // read_frame()
 // ------------
 // Blocking read loop that assembles exactly one SLIP frame.
-// - Uses poll() for timeout (timeout_ms).
-// - Feeds bytes into a slip::decoder until a full frame is seen.
-// - Stores decoded payload into 'out'.
+// - First consumes bytes carried over from the previous call on this fd.
+// - Then polls for input and reads up to RX_CHUNK bytes per ::read().
+// - Feeds bytes into the fd's slip::decoder until a full frame is seen.
+// - Stores decoded payload into 'out'; bytes after its END stay buffered.
+// - Guarded fd: a frame LinkGuard::accept() refuses, or a frame the decoder
+//   dropped, resends the unanswered requests at once and keeps reading.
 //
 // Returns: true if a full frame was decoded, false on timeout or error.
 //
 // Design:
 // - VMIN/VTIME are zero (non-blocking), so poll() controls blocking time.
-// - Reads one byte at a time; low throughput, but reliable for framing.
+// - timeout_ms is an overall deadline for the frame, not a per-read gap;
+//   resends don't extend it, and neither does a poll() interrupted by a
+//   signal (EINTR retries with whatever is left).
+// - Bulk reads cost two syscalls per chunk instead of two per byte, and
+//   back-to-back frames (GET_ALL, log dumps) are never dropped between calls.
 // ---------------------------------------------------------------------------
+static void resend_unanswered(int fd, LinkGuard& lg, long long left_ms) {
+    static thread_local std::vector<uint8_t> buf;
+    const size_t frames = lg.resend(buf);
+    if (frames && write_all(fd, buf.data(), buf.size(), static_cast<int>(std::max(1LL, left_ms))))
+        stats_sent(fd, buf.size(), frames);
+}
+
 bool read_frame(int fd, std::vector<uint8_t>& out, int timeout_ms) {
-    viatext::slip::decoder dec;
+    RxState& st = rx_state(fd);
+    LinkGuard* lg = link_guard(fd);
     out.clear();
-    uint8_t byte = 0;
+
+    const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(timeout_ms);
     pollfd pfd{fd, POLLIN, 0};
 
     while (true) {
-        int pr = ::poll(&pfd, 1, timeout_ms);
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+        if (left < 0) left = 0;
+
+        // Buffered bytes first (carry-over from the last call, then each chunk read below)
+        const size_t dropped = st.dec.dropped;
+        const bool got = drain_pending(st, out, fd);
+        const bool ok = got && (!lg || lg->accept(out));  // accept() retires what it answers
+        if (lg && ((got && !ok) || st.dec.dropped != dropped)) resend_unanswered(fd, *lg, left);
+        if (ok) { stats_frame(fd); return true; }
+        if (got) { out.clear(); continue; }       // damaged frame dropped; more may be buffered
+
+        int pr = ::poll(&pfd, 1, static_cast<int>(left));
         if (pr == 0) return false;                // timeout expired
-        if (pr < 0)  return false;                // poll error (EINTR etc.)
-        if (pfd.revents & POLLIN) {
-            ssize_t n = ::read(fd, &byte, 1);
-            if (n == 1 && dec.feed(byte, out))    // decoder returns true if END seen
-                return true;                      // full frame ready in 'out'
-        }
+        if (pr < 0 && errno == EINTR) continue;   // signal (SIGWINCH, SIGCHLD): retry with what is left
+        if (pr < 0)  return false;                // poll error
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) return false;  // link gone
+        if (!(pfd.revents & POLLIN)) continue;
+
+        st.pending.resize(RX_CHUNK);
+        ssize_t n = ::read(fd, st.pending.data(), RX_CHUNK);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) n = 0;
+        if (n < 0) { st.pending.clear(); return false; }  // read error
+        st.pending.resize(static_cast<size_t>(n));
+        st.pos = 0;
+        if (n > 0) stats_received(fd, static_cast<size_t>(n));
     }
 }
 
@@ -137,10 +411,14 @@ bool read_frame(int fd, std::vector<uint8_t>& out, int timeout_ms) {
 // ---------------------------------------------------------------------------
 // close_serial()
 // --------------
-// Close a serial fd if valid (>=0).
+// Close a serial fd if valid (>=0) and drop its receive state.
 // ---------------------------------------------------------------------------
 void close_serial(int fd) {
-    if (fd >= 0) ::close(fd);
+    if (fd < 0) return;
+    rx_forget(fd);                                // release any carried-over bytes
+    link_close(fd);
+    stats_unbind(fd);
+    ::close(fd);
 }
 
 } // namespace viatext
@@ -0,0 +1,334 @@
+// ============================================================================
+// serial_reactor.cpp — Reactor half of serial_io.hpp
+// For API/overview see serial_io.hpp.
+//
+// One epoll set, one eventfd for stop(), and a per-fd Chan holding the SLIP
+// decoder and the unsent bytes. Everything runs on the loop thread. Fds from
+// open_serial() also go through their LinkGuard (link_guard.hpp) both ways.
+// ============================================================================
+
+/**
+ * @file serial_reactor.cpp
+ */
+
+#include "serial_io.hpp"      // Reactor
+#include "slip.hpp"           // slip::encode(), slip::decoder per fd
+#include "stats.hpp"          // --stats hooks: bytes, frames, SLIP errors
+#include "link_guard.hpp"     // CRC trailers, resend on damage
+#include "commands.hpp"       // CRC_LEN: room for a trailer
+
+#include <sys/epoll.h>        // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // stop() wakeup
+#include <unistd.h>           // ::read, ::write, ::close
+#include <algorithm>          // std::min for the epoll timeout
+#include <cerrno>             // EAGAIN / EINTR
+#include <chrono>             // timer deadlines
+#include <map>                // timers ordered by deadline
+#include <unordered_map>      // fd -> channel, timer id -> deadline
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// Tunables
+// --------
+// - RX_CHUNK / RX_MAX_FRAME: as read_frame() in serial_io.cpp.
+// - MAX_EVENTS: fd events taken per epoll_wait(); more simply wait a turn.
+// - WAKE_TAG: epoll user data of the eventfd (fd numbers never reach it).
+// ---------------------------------------------------------------------------
+static constexpr size_t RX_CHUNK     = 4096;
+static constexpr size_t RX_MAX_FRAME = 1024;
+static constexpr int    MAX_EVENTS   = 64;
+static constexpr uint64_t WAKE_TAG   = ~uint64_t{0};
+
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Chan
+ * ----
+ * Everything the loop keeps for one fd. `gen` goes into the epoll user data
+ * next to the fd, so an event still queued for an fd that was removed (and
+ * maybe reused by a new open) in the same batch is recognized and skipped.
+ */
+struct Chan {
+    Chan() { dec.max_frame = RX_MAX_FRAME; }
+    int fd = -1;
+    uint32_t gen = 0;
+    slip::decoder dec;
+    Reactor::FrameFn on_frame;
+    Reactor::CloseFn on_close;
+    std::vector<uint8_t> tx;      // encoded bytes not yet taken by the driver
+    size_t tx_pos = 0;            // first unsent byte in tx
+    bool want_out = false;        // EPOLLOUT armed
+    bool failed = false;          // write error seen in send(); closed on next dispatch
+};
+
+struct Reactor::Impl {
+    int ep = -1;
+    int wake = -1;
+    uint32_t next_gen = 1;
+    std::unordered_map<int, std::unique_ptr<Chan>> chans;
+    std::vector<std::unique_ptr<Chan>> retired;        // removed during dispatch, freed after it
+
+    uint64_t next_timer = 1;
+    std::map<std::pair<Clock::time_point, uint64_t>, TimerFn> timers;
+    std::unordered_map<uint64_t, Clock::time_point> timer_at;
+
+    bool stopping = false;
+    std::vector<uint8_t> rx, frame, again;
+
+    Chan* find(int fd) {
+        auto it = chans.find(fd);
+        return it == chans.end() ? nullptr : it->second.get();
+    }
+
+    bool arm(Chan& c, bool out) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | (out ? EPOLLOUT : 0u);
+        ev.data.u64 = (uint64_t{c.gen} << 32) | static_cast<uint32_t>(c.fd);
+        if (epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &ev) < 0) return false;
+        c.want_out = out;
+        return true;
+    }
+
+    // Write queued bytes until done or EAGAIN; false on a hard error.
+    bool flush(Chan& c) {
+        while (c.tx_pos < c.tx.size()) {
+            const ssize_t w = ::write(c.fd, c.tx.data() + c.tx_pos, c.tx.size() - c.tx_pos);
+            if (w > 0) { c.tx_pos += static_cast<size_t>(w); continue; }
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0 && errno == EAGAIN) break;
+            return false;
+        }
+        if (c.tx_pos >= c.tx.size()) { c.tx.clear(); c.tx_pos = 0; }
+        const bool pending = !c.tx.empty();
+        return pending == c.want_out || arm(c, pending);
+    }
+
+    // Queue the requests the link guard wants written again; a full queue skips it.
+    void resend(Chan& c, LinkGuard& lg) {
+        const size_t frames = lg.resend(again);
+        if (!frames || c.failed || c.tx.size() - c.tx_pos + again.size() > TX_QUEUE_MAX) return;
+        c.tx.insert(c.tx.end(), again.begin(), again.end());
+        stats_sent(c.fd, again.size(), frames);
+        if (!c.want_out && !flush(c)) c.failed = true;   // closed by the next run_once()
+    }
+
+    // Stop watching; the Chan object outlives the current dispatch.
+    void drop(int fd) {
+        auto it = chans.find(fd);
+        if (it == chans.end()) return;
+        epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        retired.push_back(std::move(it->second));
+        chans.erase(it);
+    }
+
+    void hang_up(Chan& c) {
+        auto cb = std::move(c.on_close);
+        const int fd = c.fd;
+        drop(fd);
+        if (cb) cb(fd);
+    }
+
+    // Read until EAGAIN, handing each frame over; stops early once `c` is removed.
+    void on_readable(Chan& c) {
+        rx.resize(RX_CHUNK);
+        while (true) {
+            const ssize_t n = ::read(c.fd, rx.data(), rx.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno == EAGAIN) return;
+            if (n <= 0) { hang_up(c); return; }        // EOF or I/O error (unplugged)
+
+            const int fd = c.fd;
+            bool live = true;
+            const size_t dropped = c.dec.dropped;
+            LinkGuard* lg = link_guard(fd);
+            stats_received(fd, static_cast<size_t>(n));
+            c.dec.feed(rx.data(), static_cast<size_t>(n), [&](const uint8_t*, size_t) {
+                c.dec.take(frame);
+                if (lg && !lg->accept(frame)) { resend(c, *lg); return true; }   // damaged or NACK
+                stats_frame(fd);
+                c.on_frame(fd, frame);
+                live = find(fd) == &c;                  // callback may have removed it
+                return live;
+            });
+            if (live && c.dec.dropped != dropped) {
+                stats_count(fd, Counter::SlipErrors, c.dec.dropped - dropped);
+                if (lg) resend(c, *lg);
+            }
+            if (!live || static_cast<size_t>(n) < rx.size()) return;
+        }
+    }
+};
+
+
+Reactor::Reactor() : impl(new Impl) {
+    impl->ep   = epoll_create1(EPOLL_CLOEXEC);
+    impl->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (impl->ep >= 0 && impl->wake >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_TAG;
+        epoll_ctl(impl->ep, EPOLL_CTL_ADD, impl->wake, &ev);
+    }
+}
+
+Reactor::~Reactor() {
+    if (impl->wake >= 0) ::close(impl->wake);
+    if (impl->ep >= 0) ::close(impl->ep);
+}
+
+
+bool Reactor::add(int fd, FrameFn on_frame, CloseFn on_close) {
+    if (fd < 0 || impl->ep < 0 || impl->find(fd)) return false;
+    auto c = std::make_unique<Chan>();
+    c->fd = fd;
+    c->gen = impl->next_gen++;
+    c->on_frame = std::move(on_frame);
+    c->on_close = std::move(on_close);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = (uint64_t{c->gen} << 32) | static_cast<uint32_t>(fd);
+    if (epoll_ctl(impl->ep, EPOLL_CTL_ADD, fd, &ev) < 0) return false;
+    impl->chans[fd] = std::move(c);
+    return true;
+}
+
+void Reactor::remove(int fd) { impl->drop(fd); }
+
+
+// ---------------------------------------------------------------------------
+// send()
+// ------
+// Append the encoded frame. With nothing else queued, write straight away
+// (the common case: one request, fits the driver buffer, no EPOLLOUT round
+// trip); otherwise it goes out behind the queue on EPOLLOUT. A guarded fd
+// sends the frame as LinkGuard::outgoing() has it and remembers it queued.
+// ---------------------------------------------------------------------------
+bool Reactor::send(int fd, const uint8_t* payload, size_t n) {
+    Chan* c = impl->find(fd);
+    if (!c || c->failed) return false;
+    if (c->tx.size() - c->tx_pos + slip::encoded_max(n + CRC_LEN) > TX_QUEUE_MAX) return false;
+
+    LinkGuard* lg = link_guard(fd);
+    const uint8_t* frame = lg ? lg->outgoing(payload, n) : payload;
+    const size_t at = c->tx.size();
+    c->tx.resize(at + slip::encoded_max(n));
+    c->tx.resize(at + slip::encode(frame, n, c->tx.data() + at, c->tx.size() - at));
+    stats_sent(fd, c->tx.size() - at);
+    if (lg) lg->remember(frame, n, c->tx.data() + at, c->tx.size() - at);
+    if (c->want_out) return true;
+    if (impl->flush(*c)) return true;
+
+    c->failed = true;                                   // closed by the next run_once()
+    return false;
+}
+
+
+uint64_t Reactor::after(int ms, TimerFn fn) {
+    const uint64_t id = impl->next_timer++;
+    const auto at = Clock::now() + std::chrono::milliseconds(ms < 0 ? 0 : ms);
+    impl->timers.emplace(std::make_pair(at, id), std::move(fn));
+    impl->timer_at[id] = at;
+    return id;
+}
+
+void Reactor::cancel(uint64_t id) {
+    auto it = impl->timer_at.find(id);
+    if (it == impl->timer_at.end()) return;
+    impl->timers.erase({it->second, id});
+    impl->timer_at.erase(it);
+}
+
+
+// ---------------------------------------------------------------------------
+// run_once()
+// ----------
+// 1) Sleep until the earliest of: max_wait_ms, the next timer, an fd event.
+// 2) Dispatch fd events: readable bytes go through the fd's decoder, then
+//    a hang-up (EPOLLHUP/EPOLLERR), a dead read, or an earlier failed
+//    send() closes it; EPOLLOUT drains its queue.
+// 3) Fire every timer that is due, earliest first. One scheduled from
+//    inside a timer for "now" waits for the next turn.
+// ---------------------------------------------------------------------------
+int Reactor::run_once(int max_wait_ms) {
+    Impl& m = *impl;
+    if (m.ep < 0) return -1;
+
+    std::vector<int> failed;                            // send() failures since the last turn
+    for (auto& kv : m.chans)
+        if (kv.second->failed) failed.push_back(kv.first);
+    for (int fd : failed)
+        if (Chan* c = m.find(fd)) m.hang_up(*c);
+
+    int wait = max_wait_ms;
+    if (!m.timers.empty()) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              m.timers.begin()->first.first - Clock::now()).count() + 1;
+        const int t = left < 0 ? 0 : static_cast<int>(std::min<long long>(left, 1 << 30));
+        wait = wait < 0 ? t : std::min(wait, t);
+    }
+
+    epoll_event evs[MAX_EVENTS];
+    int n = epoll_wait(m.ep, evs, MAX_EVENTS, wait);
+    if (n < 0) {
+        if (errno != EINTR) return -1;
+        n = 0;
+    }
+
+    int handled = 0;
+    for (int i = 0; i < n; ++i) {
+        if (evs[i].data.u64 == WAKE_TAG) {
+            uint64_t v;
+            while (::read(m.wake, &v, sizeof v) > 0) {}
+            m.stopping = true;
+            continue;
+        }
+        const int fd = static_cast<int>(evs[i].data.u64 & 0xFFFFFFFFu);
+        const uint32_t gen = static_cast<uint32_t>(evs[i].data.u64 >> 32);
+        Chan* c = m.find(fd);
+        if (!c || c->gen != gen) continue;              // removed earlier in this batch
+        ++handled;
+
+        const uint32_t e = evs[i].events;
+        if (e & EPOLLIN) {
+            m.on_readable(*c);                          // drains what is left, even on a hang-up
+            c = m.find(fd);
+            if (!c || c->gen != gen) continue;
+        }
+        if (e & (EPOLLHUP | EPOLLERR)) {
+            m.hang_up(*c);
+            continue;
+        }
+        if ((e & EPOLLOUT) && !m.flush(*c)) m.hang_up(*c);
+    }
+
+    const auto now = Clock::now();
+    while (!m.timers.empty() && m.timers.begin()->first.first <= now) {
+        auto it = m.timers.begin();
+        TimerFn fn = std::move(it->second);
+        m.timer_at.erase(it->first.second);
+        m.timers.erase(it);
+        ++handled;
+        fn();
+    }
+
+    m.retired.clear();
+    return handled;
+}
+
+
+void Reactor::run() {
+    impl->stopping = false;
+    while (!impl->stopping && (!impl->chans.empty() || !impl->timers.empty()))
+        if (run_once(-1) < 0) break;
+}
+
+void Reactor::stop() {
+    const uint64_t one = 1;
+    if (impl->wake >= 0) (void)!::write(impl->wake, &one, sizeof one);
+}
+
+size_t Reactor::watched() const { return impl->chans.size(); }
+
+} // namespace viatext
@@ -0,0 +1,402 @@
+// ============================================================================
+// session.cpp — implementation for session.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file session.cpp
+ */
+
+#include "session.hpp"           // build_packet_from_line(), run_session()
+#include "command_dispatch.hpp"  // build_param_get_packet(), build_param_set_packet(), build_legacy_packet()
+#include "commands.hpp"          // GET_ALL/RESP_* verbs
+#include "output_format.hpp"     // format_reply(), format_error(), csv_header()
+#include "stats.hpp"             // --stats: decode time, timeouts
+#include "reply_cache.hpp"       // cache_lookup(), cache_update()
+#include "serial_io.hpp"         // write_frame(), read_frame()
+#include "link_guard.hpp"        // link_damage(), link_forget(), LINK_RESENDS: damaged streams, given-up seqs
+#include "node_registry.hpp"     // READY_SEQ_BASE: redo seqs stay below the readiness PINGs
+#include <algorithm>             // std::min/std::max of stream waits
+
+#include <chrono>                // per-request deadlines
+#include <deque>                 // in-flight slots, oldest first
+#include <istream>               // std::getline over the command source
+#include <ostream>               // result lines
+#include <sstream>               // std::istringstream to split a line into verb/name
+
+namespace viatext {
+
+// ---------------------------------------------------------------------------
+// trim()
+// ------
+// Strip leading/trailing whitespace (spaces, tabs, CR from DOS-edited files).
+// ---------------------------------------------------------------------------
+static std::string trim(const std::string& s) {
+    const char* ws = " \t\r\n";
+    auto b = s.find_first_not_of(ws);
+    if (b == std::string::npos) return {};
+    auto e = s.find_last_not_of(ws);
+    return s.substr(b, e - b + 1);
+}
+
+
+// ---------------------------------------------------------------------------
+// build_packet_from_line()
+// ------------------------
+// Split "<verb> [name] [value...]" and route to the same dispatcher helpers
+// main.cpp uses, so names, validation and error strings stay identical.
+// ---------------------------------------------------------------------------
+bool build_packet_from_line(const std::string& raw, uint8_t seq,
+                            std::vector<uint8_t>& out, std::string& err) {
+    out.clear();
+    err.clear();
+
+    const std::string line = trim(raw);
+    if (line.empty() || line[0] == '#') return false;   // separator / comment
+
+    std::istringstream is(line);
+    std::string verb, name;
+    is >> verb >> name;
+    if (verb.rfind("--", 0) == 0) verb.erase(0, 2);      // accept pasted CLI flags
+
+    // Value is the remainder of the line so aliases may contain spaces.
+    std::string value;
+    std::getline(is, value);
+    value = trim(value);
+
+    if (verb == "get") {
+        if (name.empty()) { err = "missing_value"; return false; }
+        return build_param_get_packet(name, seq, out, err);
+    }
+    if (verb == "set") {
+        if (name.empty() || value.empty()) { err = "missing_value"; return false; }
+        return build_param_set_packet(name, value, seq, out, err);
+    }
+    if (verb == "ping")   return build_legacy_packet(false, true,  "", seq, out, err);
+    if (verb == "get-id") return build_legacy_packet(true,  false, "", seq, out, err);
+    if (verb == "set-id") {
+        if (name.empty()) { err = "missing_value"; return false; }
+        return build_legacy_packet(false, false, name, seq, out, err);
+    }
+
+    err = "unknown_command";
+    return false;
+}
+
+
+// ---------------------------------------------------------------------------
+// read_reply()
+// ------------
+// Read frames until one carries the expected sequence number or the timeout
+// elapses. Late replies to an earlier, timed-out command are discarded here
+// so they can't be mistaken for the current answer.
+// ---------------------------------------------------------------------------
+bool read_reply(int fd, uint8_t seq, std::vector<uint8_t>& resp, int timeout_ms) {
+    const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+        if (!read_frame(fd, resp, static_cast<int>(left))) break;
+        if (resp.size() >= 3 && resp[2] == seq) return true;   // [verb][0][seq]...
+    }
+    link_forget(fd, seq);                             // given up: a later resend must not repeat it
+    return false;
+}
+
+
+// ---------------------------------------------------------------------------
+// is_stream_end()
+// ---------------
+// A streamed reply ends early on RESP_ERR or on a frame with no TLVs (the
+// node's "nothing more" marker). Otherwise the collector waits for the idle gap.
+// ---------------------------------------------------------------------------
+bool is_stream_end(const std::vector<uint8_t>& f) {
+    return f.size() < 4 || f[0] == RESP_ERR || f[3] == 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// collect_reply()
+// ---------------
+// Gather every frame that echoes the request's seq: the first must arrive
+// within timeout_ms, each later one within idle_gap_ms of the previous.
+// Because read_frame() keeps carry-over bytes per fd, frames that arrive back
+// to back in one read are still delivered one by one here.
+//
+// Damage on the link during a pass (link_damage() moved) spoils it: the
+// stream is read to its end (marker, or an idle gap; while nothing has come
+// yet the wait is cut to idle gaps too, so a NACKed request is asked again
+// without sitting out the whole timeout), then asked again under a new seq.
+// Frames of the spoiled pass that are still on their way carry the old seq
+// and are discarded by read_reply().
+// ---------------------------------------------------------------------------
+enum class StreamPass { Ok, Timeout, Damaged };
+
+static StreamPass collect_pass(int fd, uint8_t seq, std::vector<std::vector<uint8_t>>& frames,
+                               int timeout_ms, int idle_gap_ms) {
+    frames.clear();
+    std::vector<uint8_t> resp;
+    const uint32_t seen = link_damage(fd);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (true) {
+        const bool hurt = link_damage(fd) != seen;
+        int wait = idle_gap_ms;
+        if (frames.empty() && !hurt) {                  // first frame: whole timeout, watched per gap
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return StreamPass::Timeout;
+            wait = static_cast<int>(std::min<long long>(left, std::max(idle_gap_ms, 1)));
+        }
+        if (read_reply(fd, seq, resp, wait)) {
+            frames.push_back(resp);
+            if (!is_stream_end(frames.back())) continue;
+        } else if (frames.empty() && link_damage(fd) == seen) {
+            continue;                                   // still waiting for the first frame
+        }
+        return link_damage(fd) != seen ? StreamPass::Damaged : StreamPass::Ok;
+    }
+}
+
+uint8_t next_request_seq(uint8_t seq) {
+    return seq + 1 >= READY_SEQ_BASE ? 1 : static_cast<uint8_t>(seq + 1);
+}
+
+bool collect_reply(int fd, std::vector<uint8_t>& req, std::vector<std::vector<uint8_t>>& frames,
+                   int timeout_ms, int idle_gap_ms, bool* damaged) {
+    if (damaged) *damaged = false;
+    for (int redo = 0; ; ++redo) {
+        const StreamPass pass = collect_pass(fd, req[2], frames, timeout_ms, idle_gap_ms);
+        if (pass == StreamPass::Ok) return true;
+        frames.clear();
+        if (pass == StreamPass::Timeout) return false;
+        if (redo >= LINK_RESENDS) {                     // damaged every time: no snapshot is better than half of one
+            if (damaged) *damaged = true;
+            return false;
+        }
+        req[2] = next_request_seq(req[2]);
+        if (!write_frame(fd, req)) return false;
+        stats_count(fd, Counter::Resends);
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Pipeline state
+// --------------
+// Up to `window` requests are on the wire at once. Each occupies a Slot in
+// input order; replies are matched to slots by the echoed seq byte (f[2]),
+// and results are printed strictly in input order as soon as the oldest slot
+// resolves. Each slot has its own deadline so one lost reply times out alone.
+//
+// GET_ALL slots are "multi": they keep collecting frames with their seq, and
+// after each one the deadline moves to now + idle gap. The slot resolves on
+// an end marker or when the gap expires, and prints one merged snapshot.
+// If the link reported damage meanwhile (link_damage()), the snapshot may be
+// missing a frame: it is dropped and GET_ALL goes out again under a new seq,
+// at most LINK_RESENDS times, before the slot fails with "damaged".
+// ---------------------------------------------------------------------------
+using Clock = std::chrono::steady_clock;
+
+struct Slot {
+    uint8_t seq = 0;                  // 0 = no request on the wire (error already known)
+    Clock::time_point deadline;       // when this request gives up
+    bool done = false;                // result is final and ready to print
+    bool ok = false;                  // true if a reply arrived
+    bool multi = false;               // GET_ALL: expect a stream of frames
+    std::vector<std::vector<uint8_t>> frames;  // collected so far (multi only)
+    std::string result;               // the line to print
+    std::vector<uint8_t> req;         // original request, for the cache (cache on only)
+    std::vector<uint8_t> sent;        // the frame as written, to ask again (multi only)
+    uint32_t damage = 0;              // link_damage() when it went out (multi only)
+    int redo = 0;                     // times a damaged stream was asked again
+    CacheLookup cl;                   // cached part of the reply (cache on only)
+};
+
+static uint8_t next_seq(uint8_t& seq) {
+    seq = next_request_seq(seq);      // 1..READY_SEQ_BASE-1: a long session never reaches the PING seqs
+    return seq;
+}
+
+
+// ---------------------------------------------------------------------------
+// run_session()
+// -------------
+// 1) Fill the window: read lines, build, and record a Slot per command; the
+//    requests go out together in one write_frames() (see flush below).
+// 2) Print every resolved slot at the head of the queue.
+// 3) Wait for the next frame until the earliest pending deadline; hand it to
+//    the slot with the same seq (unknown seqs are stale and dropped).
+// 4) Expire slots whose deadline passed. Repeat until input and slots drain.
+//
+// With window=1 this is plain lock-step: one line is read only after the
+// previous reply printed, which keeps interactive/co-process use deadlock-free.
+// ---------------------------------------------------------------------------
+int run_session(int fd, std::istream& in, std::ostream& out, int timeout_ms, int window,
+                int idle_gap_ms, OutputFormat fmt, ReplyCache* cache, const std::string& node) {
+    if (window < 1) window = 1;
+    if (fmt == OutputFormat::Csv) out << csv_header() << std::endl;
+
+    int failures = 0;
+    uint8_t seq = 0;
+    bool eof = false;
+    std::string line, err;
+    std::vector<uint8_t> req, resp;
+    std::deque<Slot> slots;
+    size_t pending = 0;               // slots still waiting for a reply
+    std::vector<std::vector<uint8_t>> one(1);
+
+    // Learn from a finished reply (and complete a narrowed one) before printing it.
+    auto learn = [&](Slot& sl, std::vector<std::vector<uint8_t>>& fs) {
+        if (cache) cache_update(*cache, node, sl.req, sl.cl, fs);
+    };
+
+    // A node's reply (one frame or a snapshot) into its output line, timed for --stats.
+    auto decode = [&](const auto& frames, std::string& line) {
+        StatsTimer t(fd, Phase::Decode);
+        format_reply(fmt, frames, line);
+    };
+
+    // Requests built but not yet written, and their slots: written together
+    // in one write_frames() call, then their deadlines start.
+    std::vector<std::vector<uint8_t>> outq;
+    std::vector<Slot*> queued;
+    auto flush = [&] {
+        if (outq.empty()) return;
+        const bool sent = write_frames(fd, outq);
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+        for (Slot* sl : queued) {
+            if (sent) { sl->deadline = deadline; sl->damage = link_damage(fd); continue; }
+            sl->done = true; format_error(fmt, "write_failed", 0, sl->result);
+            --pending;
+        }
+        outq.clear();
+        queued.clear();
+    };
+
+    // A stream is over (end marker or idle gap): print it, or if the link was
+    // damaged meanwhile drop its frames and ask again from the first frame.
+    auto stream_over = [&](Slot& sl) {
+        if (link_damage(fd) != sl.damage) {
+            sl.frames.clear();
+            const char* why = "damaged";
+            if (sl.redo < LINK_RESENDS) {
+                ++sl.redo;
+                sl.seq = next_seq(seq);                      // late frames of the old pass are now stale
+                sl.sent[2] = sl.seq;
+                sl.damage = link_damage(fd);
+                if (write_frame(fd, sl.sent)) {
+                    stats_count(fd, Counter::Resends);
+                    sl.deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+                    return;
+                }
+                why = "write_failed";
+            }
+            sl.done = true;
+            format_error(fmt, why, sl.seq, sl.result);
+        } else {
+            learn(sl, sl.frames);
+            decode(sl.frames, sl.result);
+            sl.done = true; sl.ok = true;
+        }
+        --pending;
+    };
+
+    while (true) {
+        // 1) fill the window
+        while (!eof && static_cast<int>(slots.size()) < window) {
+            if (!std::getline(in, line)) { eof = true; break; }
+
+            Slot sl;
+            const uint8_t prev = seq;
+            const uint8_t s = next_seq(seq);
+            if (!build_packet_from_line(line, s, req, err)) {
+                if (err.empty()) { seq = prev; continue; }   // blank/comment: no sequence consumed
+                sl.done = true; format_error(fmt, err, 0, sl.result);
+            } else if (cache && cache_lookup(*cache, node, req, sl.cl)) {
+                sl.done = true; sl.ok = true; format_reply(fmt, sl.cl.reply, sl.result);
+            } else {
+                if (cache) {
+                    sl.req = req;
+                    // invalidate as it goes out: reads behind it in the window must miss
+                    if (req[0] == SET_PARAM || req[0] == SET_ID) learn(sl, one);
+                }
+                outq.push_back(cache ? sl.cl.fetch : req);
+                sl.seq = s;
+                sl.multi = (req[0] == GET_ALL);
+                if (sl.multi) sl.sent = outq.back();
+                ++pending;
+            }
+            slots.push_back(std::move(sl));
+            if (!slots.back().done) queued.push_back(&slots.back());   // deque: push_back keeps references
+
+            // Coalesce only what is already buffered; never hold a request
+            // back while the next line might block (co-process input).
+            if (in.rdbuf()->in_avail() <= 0) flush();
+        }
+        flush();
+
+        // 2) print resolved results in input order
+        while (!slots.empty() && slots.front().done) {
+            out << slots.front().result << std::endl;         // flush per line for streaming readers
+            if (!slots.front().ok) ++failures;
+            slots.pop_front();
+        }
+        if (slots.empty() && eof) break;
+        if (pending == 0) continue;                          // only errors queued; go refill
+
+        // 3) wait for a reply until the earliest deadline
+        auto first = Clock::time_point::max();
+        for (const auto& sl : slots)
+            if (!sl.done && sl.deadline < first) first = sl.deadline;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(first - Clock::now()).count();
+
+        if (left > 0 && read_frame(fd, resp, static_cast<int>(left)) && resp.size() >= 3) {
+            for (auto& sl : slots) {
+                if (sl.done || sl.seq != resp[2]) continue;
+                if (sl.multi) {
+                    sl.frames.push_back(resp);
+                    if (!is_stream_end(resp)) {     // more may follow; wait one idle gap
+                        sl.deadline = Clock::now() + std::chrono::milliseconds(idle_gap_ms);
+                    } else {
+                        stream_over(sl);
+                    }
+                    break;
+                } else if (cache) {
+                    one.front().swap(resp);
+                    if (sl.req[0] != SET_PARAM && sl.req[0] != SET_ID) learn(sl, one);
+                    decode(one.front(), sl.result);
+                } else {
+                    decode(resp, sl.result);
+                }
+                sl.done = true; sl.ok = true;
+                --pending;
+                break;
+            }
+        }
+
+        // 4) expire anything past its deadline
+        const auto now = Clock::now();
+        for (auto& sl : slots) {
+            if (sl.done) continue;
+            const bool hurt = sl.multi && link_damage(fd) != sl.damage;
+            if (hurt && sl.frames.empty())          // request or first frame may be lost: don't sit out the timeout
+                sl.deadline = std::min(sl.deadline, now + std::chrono::milliseconds(idle_gap_ms));
+            if (sl.deadline > now) continue;
+            if (sl.multi && (!sl.frames.empty() || hurt)) {   // idle gap after a stream
+                stream_over(sl);
+                continue;
+            }
+            sl.done = true;
+            stats_count(fd, Counter::Timeouts);
+            link_forget(fd, sl.seq);                // given up: a later resend must not repeat it
+            format_error(fmt, "timeout", sl.seq, sl.result);
+            --pending;
+        }
+    }
+    return failures;
+}
+
+} // namespace viatext
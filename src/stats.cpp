@@ -0,0 +1,285 @@
+// ============================================================================
+// stats.cpp — implementation for stats.hpp
+// For API/overview see the matching .hpp.
+// ============================================================================
+
+/**
+ * @file stats.cpp
+ */
+
+#include "stats.hpp"          // Phase, Counter, hooks
+
+#include <algorithm>          // std::lower_bound on the Prometheus ladder
+#include <array>              // fixed-size buckets and counters
+#include <map>                // device -> totals, ordered for output
+#include <memory>             // stable DevStats addresses
+#include <mutex>              // one lock for every table
+#include <ostream>            // stats_print(), stats_prometheus()
+#include <unordered_map>      // fd -> binding
+
+namespace viatext {
+
+std::atomic<bool> stats_enabled{false};
+
+void stats_enable() { stats_enabled.store(true, std::memory_order_relaxed); }
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------
+// Log-linear buckets over microseconds: values below SUB are their own
+// bucket; above, each power of two [2^k, 2^k+1) is split into SUB equal
+// sub-buckets. Index = SUB + (k - SUB_BITS) * SUB + (v >> (k - SUB_BITS)) - SUB.
+// OCTAVES powers of two above 16 us reach 2^40 us (~12 days).
+// ---------------------------------------------------------------------------
+static constexpr int SUB_BITS = 4;
+static constexpr uint64_t SUB = 1u << SUB_BITS;
+static constexpr int OCTAVES  = 36;
+static constexpr size_t BUCKETS = SUB + OCTAVES * SUB;
+
+// Bucket ladder exported to Prometheus, in microseconds. None of these is a
+// bucket edge above (100 us lands inside [96, 104)), so record() counts
+// against the ladder exactly on the side.
+static constexpr uint64_t LADDER_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                         100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+static constexpr size_t LADDER = sizeof(LADDER_US) / sizeof(LADDER_US[0]);
+
+struct Histogram {
+    std::array<uint64_t, BUCKETS> n{};
+    std::array<uint64_t, LADDER> rung{};   // samples in (LADDER_US[r-1], LADDER_US[r]]
+    uint64_t count = 0, sum_us = 0, max_us = 0;
+
+    static size_t index(uint64_t v) {
+        if (v < SUB) return static_cast<size_t>(v);
+        const int k = 63 - __builtin_clzll(v);                // 2^k <= v
+        const int shift = k - SUB_BITS;
+        const size_t i = SUB + static_cast<size_t>(shift) * SUB + ((v >> shift) - SUB);
+        return i < BUCKETS ? i : BUCKETS - 1;
+    }
+
+    // Largest value that lands in bucket i.
+    static uint64_t upper(size_t i) {
+        if (i < SUB) return i;
+        const size_t shift = (i - SUB) / SUB;
+        const uint64_t sub = SUB + (i - SUB) % SUB;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t us) {
+        ++n[index(us)];
+        const size_t r = static_cast<size_t>(std::lower_bound(LADDER_US, LADDER_US + LADDER, us) - LADDER_US);
+        if (r < LADDER) ++rung[r];
+        ++count;
+        sum_us += us;
+        if (us > max_us) max_us = us;
+    }
+
+    uint64_t percentile(double q) const {
+        if (count == 0) return 0;
+        uint64_t want = static_cast<uint64_t>(q * static_cast<double>(count) + 0.999999);
+        if (want == 0) want = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += n[i];
+            if (seen >= want) return upper(i) < max_us ? upper(i) : max_us;
+        }
+        return max_us;
+    }
+
+    // Samples <= LADDER_US[r], exact (cumulative, as Prometheus buckets are).
+    uint64_t at_most(size_t r) const {
+        uint64_t c = 0;
+        for (size_t i = 0; i <= r && i < LADDER; ++i) c += rung[i];
+        return c;
+    }
+};
+
+struct DevStats {
+    std::array<Histogram, static_cast<size_t>(Phase::Count)> phase;
+    std::array<uint64_t, static_cast<size_t>(Counter::Count)> counter{};
+};
+
+// Reply timing state of one open fd.
+struct FdState {
+    DevStats* dev = nullptr;
+    std::chrono::steady_clock::time_point sent;
+    bool awaiting = false;        // a request went out, no frame back yet
+    bool got_byte = false;        // first_byte already recorded for it
+};
+
+static std::mutex mu;
+static std::map<std::string, std::unique_ptr<DevStats>> devices;   // "" = host-wide
+static std::unordered_map<int, FdState> fds;
+
+static DevStats& device(const std::string& dev) {
+    auto& p = devices[dev];
+    if (!p) p = std::make_unique<DevStats>();
+    return *p;
+}
+
+// Caller holds mu. Unbound fds count as host-wide.
+static FdState& fd_state(int fd) {
+    FdState& s = fds[fd];
+    if (!s.dev) s.dev = &device("");
+    return s;
+}
+
+static uint64_t to_us(std::chrono::steady_clock::duration d) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    return us < 0 ? 0 : static_cast<uint64_t>(us);
+}
+
+
+// -------- hooks --------
+
+void stats_bind(int fd, const std::string& dev) {
+    if (!stats_on() || fd < 0) return;
+    std::lock_guard<std::mutex> lk(mu);
+    FdState s;
+    s.dev = &device(dev);
+    fds[fd] = s;
+}
+
+void stats_unbind(int fd) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    fds.erase(fd);
+}
+
+void stats_time(int fd, Phase p, std::chrono::steady_clock::duration d) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    DevStats& ds = fd < 0 ? device("") : *fd_state(fd).dev;
+    ds.phase[static_cast<size_t>(p)].record(to_us(d));
+}
+
+void stats_count(int fd, Counter c, uint64_t n) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    DevStats& ds = fd < 0 ? device("") : *fd_state(fd).dev;
+    ds.counter[static_cast<size_t>(c)] += n;
+}
+
+void stats_sent(int fd, size_t bytes, size_t frames) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    FdState& s = fd_state(fd);
+    s.dev->counter[static_cast<size_t>(Counter::BytesTx)] += bytes;
+    s.dev->counter[static_cast<size_t>(Counter::FramesTx)] += frames;
+    if (!s.awaiting) {
+        s.sent = std::chrono::steady_clock::now();
+        s.awaiting = true;
+        s.got_byte = false;
+    }
+}
+
+void stats_received(int fd, size_t bytes) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    FdState& s = fd_state(fd);
+    s.dev->counter[static_cast<size_t>(Counter::BytesRx)] += bytes;
+    if (s.awaiting && !s.got_byte) {
+        s.dev->phase[static_cast<size_t>(Phase::FirstByte)].record(to_us(std::chrono::steady_clock::now() - s.sent));
+        s.got_byte = true;
+    }
+}
+
+void stats_frame(int fd) {
+    if (!stats_on()) return;
+    std::lock_guard<std::mutex> lk(mu);
+    FdState& s = fd_state(fd);
+    ++s.dev->counter[static_cast<size_t>(Counter::FramesRx)];
+    if (s.awaiting) {
+        s.dev->phase[static_cast<size_t>(Phase::Frame)].record(to_us(std::chrono::steady_clock::now() - s.sent));
+        s.awaiting = false;
+    }
+}
+
+
+// -------- output --------
+
+static const char* const PHASE_NAMES[] = {"open", "boot_delay", "flush", "write", "first_byte",
+                                          "frame", "decode", "scan"};
+static const char* const COUNTER_NAMES[] = {"bytes_tx", "bytes_rx", "frames_tx", "frames_rx", "slip_errors",
+                                            "timeouts", "retries", "crc_errors", "resends",
+                                            "cache_hits", "cache_misses"};
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<size_t>(Phase::Count), "phase names");
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<size_t>(Counter::Count), "counter names");
+
+// Counters that only mean something per device (the cache ones are host-wide).
+static constexpr size_t DEVICE_COUNTERS = static_cast<size_t>(Counter::CacheHits);
+
+void stats_print(std::ostream& out) {
+    std::lock_guard<std::mutex> lk(mu);
+    for (const auto& kv : devices) {
+        const std::string who = kv.first.empty() ? "" : " dev=" + kv.first;
+        const DevStats& ds = *kv.second;
+        for (size_t p = 0; p < ds.phase.size(); ++p) {
+            const Histogram& h = ds.phase[p];
+            if (h.count == 0) continue;
+            out << "stats" << who << " phase=" << PHASE_NAMES[p] << " count=" << h.count
+                << " p50_us=" << h.percentile(0.50) << " p90_us=" << h.percentile(0.90)
+                << " p99_us=" << h.percentile(0.99) << " max_us=" << h.max_us
+                << " mean_us=" << h.sum_us / h.count << "\n";
+        }
+        bool any = false;
+        for (size_t c = 0; c < DEVICE_COUNTERS; ++c) any = any || ds.counter[c];
+        if (any) {
+            out << "stats" << who;
+            for (size_t c = 0; c < DEVICE_COUNTERS; ++c) out << ' ' << COUNTER_NAMES[c] << '=' << ds.counter[c];
+            out << "\n";
+        }
+    }
+    if (auto it = devices.find(""); it != devices.end()) {
+        const auto& c = it->second->counter;
+        if (c[static_cast<size_t>(Counter::CacheHits)] || c[static_cast<size_t>(Counter::CacheMisses)])
+            out << "stats cache_hits=" << c[static_cast<size_t>(Counter::CacheHits)]
+                << " cache_misses=" << c[static_cast<size_t>(Counter::CacheMisses)] << "\n";
+    }
+    out.flush();
+}
+
+
+// Label value with \, " and newline escaped as the text format requires.
+static std::string label(const std::string& v) {
+    std::string out;
+    for (char c : v) {
+        if (c == '\\' || c == '"') out.push_back('\\');
+        if (c == '\n') { out += "\\n"; continue; }
+        out.push_back(c);
+    }
+    return out;
+}
+
+void stats_prometheus(std::ostream& out) {
+    std::lock_guard<std::mutex> lk(mu);
+
+    out << "# HELP viatext_phase_seconds Time spent per I/O phase and device.\n"
+           "# TYPE viatext_phase_seconds histogram\n";
+    for (const auto& kv : devices) {
+        for (size_t p = 0; p < kv.second->phase.size(); ++p) {
+            const Histogram& h = kv.second->phase[p];
+            if (h.count == 0) continue;
+            const std::string lbl = "dev=\"" + label(kv.first) + "\",phase=\"" + PHASE_NAMES[p] + "\"";
+            for (size_t r = 0; r < LADDER; ++r)
+                out << "viatext_phase_seconds_bucket{" << lbl << ",le=\"" << LADDER_US[r] / 1e6 << "\"} "
+                    << h.at_most(r) << "\n";
+            out << "viatext_phase_seconds_bucket{" << lbl << ",le=\"+Inf\"} " << h.count << "\n"
+                << "viatext_phase_seconds_sum{" << lbl << "} " << std::to_string(h.sum_us / 1e6) << "\n"
+                << "viatext_phase_seconds_count{" << lbl << "} " << h.count << "\n";
+        }
+    }
+
+    for (size_t c = 0; c < static_cast<size_t>(Counter::Count); ++c) {
+        const bool host = c >= DEVICE_COUNTERS;
+        out << "# TYPE viatext_" << COUNTER_NAMES[c] << "_total counter\n";
+        for (const auto& kv : devices) {
+            if (host != kv.first.empty()) continue;
+            out << "viatext_" << COUNTER_NAMES[c] << "_total";
+            if (!host) out << "{dev=\"" << label(kv.first) << "\"}";
+            out << ' ' << kv.second->counter[c] << "\n";
+        }
+    }
+    out.flush();
+}
+
+} // namespace viatext
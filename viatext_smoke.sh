@@ -3,7 +3,7 @@ set -u
 
 NODE="${1:-N3}"
 CLI="./viatext-cli"
-CLI_OPTS=(--baud 115200 --timeout 2500 --boot-delay 600)  # longer I/O cushions
+CLI_OPTS=(--baud 115200 --timeout 2500)  # longer read cushion; boot wait is adaptive (--boot-delay auto)
 
 GREEN='\033[0;32m'; RED='\033[0;31m'; YEL='\033[0;33m'; NC='\033[0m'
 pass(){ echo -e "${GREEN}PASS${NC}  $*"; }